@@ -0,0 +1,468 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+#include "backend/aot.h"
+
+namespace stronk {
+
+namespace {
+
+enum class CType {
+    UNKNOWN,
+    BOOL,
+    INT,
+    REAL,
+    CHAR,
+    STRING
+};
+
+const char *RUNTIME = R"(#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int stronk_wrap_add(int a, int b) { return (int) ((unsigned) a + (unsigned) b); }
+static int stronk_wrap_sub(int a, int b) { return (int) ((unsigned) a - (unsigned) b); }
+static int stronk_wrap_mult(int a, int b) { return (int) ((unsigned) a * (unsigned) b); }
+
+static void stronk_error(int line, const char *message) {
+    fflush(stdout);
+    fprintf(stderr, "[line %d] Runtime error: %s\n", line, message);
+    exit(70);
+}
+
+static int stronk_div(int a, int b, int line) {
+    if (b == 0) {
+        stronk_error(line, "Division by zero.");
+    }
+    return b == -1 ? stronk_wrap_sub(0, a) : a / b;
+}
+)";
+
+// Infers the C type of every register from its definitions.
+// Copies may be defined after their source in program order
+// (loops), so iterate until nothing changes.
+class TypeInference {
+public:
+    explicit TypeInference(const Program &program) : program_(program), types_(program.num_registers_, CType::UNKNOWN) {}
+
+    auto Run() -> std::vector<CType> {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const auto &instr : program_.code_) {
+                CType type = ResultType(instr);
+                if (type == CType::UNKNOWN) {
+                    continue;
+                }
+                CType &current = types_[instr.dest_];
+                if (current == CType::UNKNOWN) {
+                    current = type;
+                    changed = true;
+                } else if (current != type) {
+                    throw std::invalid_argument("Register defined with conflicting types.");
+                }
+            }
+        }
+        return types_;
+    }
+private:
+    const Program &program_;
+    std::vector<CType> types_;
+
+    auto ResultType(const ProgramInstr &instr) const -> CType {
+        switch (instr.code_) {
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MULT:
+            case OpCode::DIV:
+            case OpCode::NEG:
+            case OpCode::ADDI:
+            case OpCode::SUBI:
+            case OpCode::MULTI:
+            case OpCode::MADD:
+            case OpCode::INCBLT:
+            case OpCode::INCBLEQ:
+            case OpCode::INCBLTI:
+            case OpCode::INCBLEQI:
+            case OpCode::F2I:
+                return CType::INT;
+            case OpCode::FADD:
+            case OpCode::FSUB:
+            case OpCode::FMULT:
+            case OpCode::FDIV:
+            case OpCode::FNEG:
+            case OpCode::FADDI:
+            case OpCode::FSUBI:
+            case OpCode::FMULTI:
+            case OpCode::FDIVI:
+            case OpCode::FMADD:
+            case OpCode::I2F:
+                return CType::REAL;
+            case OpCode::EQ:
+            case OpCode::NEQ:
+            case OpCode::GT:
+            case OpCode::LT:
+            case OpCode::GEQ:
+            case OpCode::LEQ:
+            case OpCode::FEQ:
+            case OpCode::FNEQ:
+            case OpCode::FGT:
+            case OpCode::FLT:
+            case OpCode::FGEQ:
+            case OpCode::FLEQ:
+            case OpCode::AND:
+            case OpCode::OR:
+            case OpCode::XOR:
+            case OpCode::EQI:
+            case OpCode::NEQI:
+            case OpCode::GTI:
+            case OpCode::LTI:
+            case OpCode::GEQI:
+            case OpCode::LEQI:
+            case OpCode::FEQI:
+            case OpCode::FNEQI:
+            case OpCode::FGTI:
+            case OpCode::FLTI:
+            case OpCode::FGEQI:
+            case OpCode::FLEQI:
+                return CType::BOOL;
+            case OpCode::NOT:
+            case OpCode::ID:
+                return types_[instr.a_];
+            case OpCode::CONST:
+                return ConstantType(program_.constants_[instr.a_]);
+            default:
+                return CType::UNKNOWN;
+        }
+    }
+
+    static auto ConstantType(const ConstantPool::ConstantValue &constant) -> CType {
+        if (std::holds_alternative<int>(constant)) {
+            return CType::INT;
+        } else if (std::holds_alternative<float>(constant)) {
+            return CType::REAL;
+        } else if (std::holds_alternative<char>(constant)) {
+            return CType::CHAR;
+        } else if (std::holds_alternative<bool>(constant)) {
+            return CType::BOOL;
+        }
+        return CType::STRING;
+    }
+};
+
+auto TypeName(CType type) -> const char * {
+    switch (type) {
+        case CType::BOOL: return "int";
+        case CType::REAL: return "float";
+        case CType::CHAR: return "char";
+        case CType::STRING: return "const char *";
+        default: return "int";
+    }
+}
+
+auto QuoteString(const std::string &str) -> std::string {
+    std::ostringstream oss;
+    oss << '"';
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            oss << '\\' << c;
+        } else if (c < 0x20 || c >= 0x7f) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\%03o", c);
+            oss << buffer;
+        } else {
+            oss << c;
+        }
+    }
+    oss << '"';
+    return oss.str();
+}
+
+auto ConstantLiteral(const ConstantPool::ConstantValue &constant) -> std::string {
+    if (auto i = std::get_if<int>(&constant)) {
+        // -2147483648 is not a valid int literal in C.
+        return *i == INT32_MIN ? "(-2147483647 - 1)" : std::to_string(*i);
+    } else if (auto f = std::get_if<float>(&constant)) {
+        if (std::isnan(*f)) {
+            return "NAN";
+        } else if (std::isinf(*f)) {
+            return *f < 0 ? "-INFINITY" : "INFINITY";
+        }
+        // Hex floats round-trip exactly.
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%af", static_cast<double>(*f));
+        return buffer;
+    } else if (auto c = std::get_if<char>(&constant)) {
+        return "(char) " + std::to_string(static_cast<int>(*c));
+    } else if (auto b = std::get_if<bool>(&constant)) {
+        return *b ? "1" : "0";
+    }
+    return QuoteString(std::get<std::string>(constant));
+}
+
+class CEmitter {
+public:
+    explicit CEmitter(const Program &program) : program_(program), types_(TypeInference(program).Run()) {}
+
+    auto Emit() -> std::string {
+        FindTargets();
+        out_ << "/* Generated by stronk. */\n" << RUNTIME << "\n";
+        out_ << "int main(void) {\n";
+        for (int slot = 0; slot < program_.num_registers_; slot++) {
+            out_ << "    " << TypeName(types_[slot]) << " " << Local(slot) << " = 0;\n";
+            if (track_defined_[slot]) {
+                out_ << "    int " << Local(slot) << "_defined = 0;\n";
+            }
+        }
+        out_ << "\n";
+
+        int size = static_cast<int>(program_.code_.size());
+        for (int pc = 0; pc < size; pc++) {
+            if (is_target_[pc]) {
+                out_ << "L" << pc << ":\n";
+            }
+            EmitInstr(program_.code_[pc]);
+        }
+        if (is_target_[size]) {
+            out_ << "L" << size << ":\n";
+        }
+        out_ << "    return 0;\n}\n";
+        return out_.str();
+    }
+private:
+    const Program &program_;
+    std::vector<CType> types_;
+    std::vector<bool> is_target_;
+    std::vector<bool> track_defined_;
+    std::ostringstream out_;
+
+    // Marks jump targets, which need labels, and named variables
+    // that are printed, which print nil until first defined.
+    void FindTargets() {
+        is_target_.assign(program_.code_.size() + 1, false);
+        track_defined_.assign(program_.num_registers_, false);
+        int num_globals = static_cast<int>(program_.globals_.size());
+        for (const auto &instr : program_.code_) {
+            if (instr.code_ == OpCode::JMP) {
+                is_target_[instr.target_] = true;
+            } else if (IsBranch(instr.code_)) {
+                is_target_[instr.target_] = true;
+                is_target_[instr.alt_] = true;
+            } else if (instr.code_ == OpCode::PRINT) {
+                for (int i = 0; i < instr.b_; i++) {
+                    int slot = program_.operands_[instr.a_ + i];
+                    track_defined_[slot] = slot < num_globals && types_[slot] != CType::UNKNOWN;
+                }
+            }
+        }
+    }
+
+    auto Local(int slot) const -> std::string {
+        int num_globals = static_cast<int>(program_.globals_.size());
+        if (slot < num_globals) {
+            return "v_" + program_.globals_[slot];
+        }
+        return "t" + std::to_string(slot - num_globals);
+    }
+
+    void Assign(const ProgramInstr &instr, const std::string &expr) {
+        out_ << "    " << Local(instr.dest_) << " = " << expr << ";\n";
+        if (track_defined_[instr.dest_]) {
+            out_ << "    " << Local(instr.dest_) << "_defined = 1;\n";
+        }
+    }
+
+    void Binary(const ProgramInstr &instr, const char *op) {
+        Assign(instr, Local(instr.a_) + " " + op + " " + Local(instr.b_));
+    }
+
+    void Call(const ProgramInstr &instr, const char *function) {
+        Assign(instr, std::string(function) + "(" + Local(instr.a_) + ", " + Local(instr.b_) + ")");
+    }
+
+    void BinaryImm(const ProgramInstr &instr, const char *op, const ConstantPool::ConstantValue &imm) {
+        Assign(instr, Local(instr.a_) + " " + op + " " + ConstantLiteral(imm));
+    }
+
+    // if (a <op> b) goto target; goto alt;
+    void Branch(const ProgramInstr &instr, const char *op, bool immediate) {
+        std::string rhs = immediate ? ConstantLiteral(instr.b_) : Local(instr.b_);
+        out_ << "    if (" << Local(instr.a_) << " " << op << " " << rhs << ") goto L" << instr.target_ << ";\n";
+        out_ << "    goto L" << instr.alt_ << ";\n";
+    }
+
+    void CounterBranch(const ProgramInstr &instr, const char *op, bool immediate) {
+        Assign(instr, "stronk_wrap_add(" + Local(instr.a_) + ", " + ConstantLiteral(instr.c_) + ")");
+        Branch(instr, op, immediate);
+    }
+
+    void CallImm(const ProgramInstr &instr, const char *function) {
+        Assign(instr, std::string(function) + "(" + Local(instr.a_) + ", " + ConstantLiteral(instr.b_) + ")");
+    }
+
+    void EmitInstr(const ProgramInstr &instr) {
+        switch (instr.code_) {
+            case OpCode::ADD: Call(instr, "stronk_wrap_add"); break;
+            case OpCode::SUB: Call(instr, "stronk_wrap_sub"); break;
+            case OpCode::MULT: Call(instr, "stronk_wrap_mult"); break;
+            case OpCode::NEG: Assign(instr, "stronk_wrap_sub(0, " + Local(instr.a_) + ")"); break;
+            case OpCode::DIV:
+                Assign(instr, "stronk_div(" + Local(instr.a_) + ", " + Local(instr.b_) + ", " + std::to_string(instr.line_) + ")");
+                break;
+
+            case OpCode::FADD: Binary(instr, "+"); break;
+            case OpCode::FSUB: Binary(instr, "-"); break;
+            case OpCode::FMULT: Binary(instr, "*"); break;
+            case OpCode::FDIV: Binary(instr, "/"); break;
+            case OpCode::FNEG: Assign(instr, "0.0f - " + Local(instr.a_)); break;
+
+            case OpCode::EQ: case OpCode::FEQ: Binary(instr, "=="); break;
+            case OpCode::NEQ: case OpCode::FNEQ: Binary(instr, "!="); break;
+            case OpCode::GT: case OpCode::FGT: Binary(instr, ">"); break;
+            case OpCode::LT: case OpCode::FLT: Binary(instr, "<"); break;
+            case OpCode::GEQ: case OpCode::FGEQ: Binary(instr, ">="); break;
+            case OpCode::LEQ: case OpCode::FLEQ: Binary(instr, "<="); break;
+
+            case OpCode::ADDI: CallImm(instr, "stronk_wrap_add"); break;
+            case OpCode::SUBI: CallImm(instr, "stronk_wrap_sub"); break;
+            case OpCode::MULTI: CallImm(instr, "stronk_wrap_mult"); break;
+            case OpCode::EQI: BinaryImm(instr, "==", instr.b_); break;
+            case OpCode::NEQI: BinaryImm(instr, "!=", instr.b_); break;
+            case OpCode::GTI: BinaryImm(instr, ">", instr.b_); break;
+            case OpCode::LTI: BinaryImm(instr, "<", instr.b_); break;
+            case OpCode::GEQI: BinaryImm(instr, ">=", instr.b_); break;
+            case OpCode::LEQI: BinaryImm(instr, "<=", instr.b_); break;
+
+            case OpCode::FADDI: BinaryImm(instr, "+", DecodeReal(instr.b_)); break;
+            case OpCode::FSUBI: BinaryImm(instr, "-", DecodeReal(instr.b_)); break;
+            case OpCode::FMULTI: BinaryImm(instr, "*", DecodeReal(instr.b_)); break;
+            case OpCode::FDIVI: BinaryImm(instr, "/", DecodeReal(instr.b_)); break;
+            case OpCode::FEQI: BinaryImm(instr, "==", DecodeReal(instr.b_)); break;
+            case OpCode::FNEQI: BinaryImm(instr, "!=", DecodeReal(instr.b_)); break;
+            case OpCode::FGTI: BinaryImm(instr, ">", DecodeReal(instr.b_)); break;
+            case OpCode::FLTI: BinaryImm(instr, "<", DecodeReal(instr.b_)); break;
+            case OpCode::FGEQI: BinaryImm(instr, ">=", DecodeReal(instr.b_)); break;
+            case OpCode::FLEQI: BinaryImm(instr, "<=", DecodeReal(instr.b_)); break;
+
+            case OpCode::AND: Binary(instr, "&&"); break;
+            case OpCode::OR: Binary(instr, "||"); break;
+            case OpCode::XOR: Binary(instr, "!="); break;
+            case OpCode::NOT:
+                Assign(instr, (types_[instr.a_] == CType::BOOL ? "!" : "~") + Local(instr.a_));
+                break;
+
+            case OpCode::F2I: Assign(instr, "(int) " + Local(instr.a_)); break;
+            case OpCode::I2F: Assign(instr, "(float) " + Local(instr.a_)); break;
+
+            case OpCode::ID: Assign(instr, Local(instr.a_)); break;
+            case OpCode::CONST: Assign(instr, ConstantLiteral(program_.constants_[instr.a_])); break;
+
+            case OpCode::LABEL: break;
+            case OpCode::JMP:
+                out_ << "    goto L" << instr.target_ << ";\n";
+                break;
+            case OpCode::BR:
+                out_ << "    if (" << Local(instr.a_) << ") goto L" << instr.target_ << ";\n";
+                out_ << "    goto L" << instr.alt_ << ";\n";
+                break;
+
+            case OpCode::BEQ: Branch(instr, "==", false); break;
+            case OpCode::BNEQ: Branch(instr, "!=", false); break;
+            case OpCode::BGT: Branch(instr, ">", false); break;
+            case OpCode::BLT: Branch(instr, "<", false); break;
+            case OpCode::BGEQ: Branch(instr, ">=", false); break;
+            case OpCode::BLEQ: Branch(instr, "<=", false); break;
+            case OpCode::BEQI: Branch(instr, "==", true); break;
+            case OpCode::BNEQI: Branch(instr, "!=", true); break;
+            case OpCode::BGTI: Branch(instr, ">", true); break;
+            case OpCode::BLTI: Branch(instr, "<", true); break;
+            case OpCode::BGEQI: Branch(instr, ">=", true); break;
+            case OpCode::BLEQI: Branch(instr, "<=", true); break;
+            case OpCode::INCBLT: CounterBranch(instr, "<", false); break;
+            case OpCode::INCBLEQ: CounterBranch(instr, "<=", false); break;
+            case OpCode::INCBLTI: CounterBranch(instr, "<", true); break;
+            case OpCode::INCBLEQI: CounterBranch(instr, "<=", true); break;
+
+            case OpCode::MADD:
+                Assign(instr, "stronk_wrap_add(stronk_wrap_mult(" + Local(instr.a_) + ", " + Local(instr.b_) + "), "
+                    + Local(instr.c_) + ")");
+                break;
+            case OpCode::FMADD:
+                Assign(instr, Local(instr.a_) + " * " + Local(instr.b_) + " + " + Local(instr.c_));
+                break;
+
+            case OpCode::PRINT:
+                for (int i = 0; i < instr.b_; i++) {
+                    if (i != 0) {
+                        out_ << "    putchar(' ');\n";
+                    }
+                    EmitPrint(program_.operands_[instr.a_ + i]);
+                }
+                out_ << "    putchar('\\n');\n";
+                break;
+
+            default:
+                throw std::invalid_argument("Instruction cannot be compiled ahead of time.");
+        }
+    }
+
+    void EmitPrint(int slot) {
+        std::string local = Local(slot);
+        std::string print;
+        switch (types_[slot]) {
+            case CType::BOOL: print = "fputs(" + local + " ? \"true\" : \"false\", stdout);"; break;
+            case CType::INT: print = "printf(\"%d\", " + local + ");"; break;
+            case CType::REAL: print = "printf(\"%g\", (double) " + local + ");"; break;
+            case CType::CHAR: print = "putchar(" + local + ");"; break;
+            case CType::STRING: print = "fputs(" + local + ", stdout);"; break;
+            case CType::UNKNOWN: print = "fputs(\"nil\", stdout);"; break;
+        }
+        if (track_defined_[slot]) {
+            out_ << "    if (" << local << "_defined) " << print << " else fputs(\"nil\", stdout);\n";
+        } else {
+            out_ << "    " << print << "\n";
+        }
+    }
+};
+
+// Quotes `arg` for /bin/sh.
+auto ShellQuote(const std::string &arg) -> std::string {
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+} // namespace
+
+auto TranslateToC(const Program &program) -> std::string {
+    return CEmitter(program).Emit();
+}
+
+auto CompileExecutable(const std::string &c_source, const std::string &output, const std::string &compiler) -> bool {
+    std::string c_path = output + ".c";
+    {
+        std::ofstream file(c_path);
+        file << c_source;
+        if (!file) {
+            return false;
+        }
+    }
+    std::string command = compiler + " -O2 -o " + ShellQuote(output) + " " + ShellQuote(c_path);
+    int status = std::system(command.c_str());
+    std::remove(c_path.c_str());
+    return status == 0;
+}
+
+} // namespace "stronk"
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include "backend/heap.h"
+
+namespace stronk {
+
+// Size class index reserved for objects that do not fit in any
+// block and are allocated on their own.
+static constexpr uint8_t LARGE_OBJECT = _STRONK_HEAP_SIZE_CLASSES;
+
+static auto BlockSize(uint8_t size_class) -> size_t {
+    return static_cast<size_t>(_STRONK_HEAP_MIN_BLOCK) << size_class;
+}
+
+Heap::Heap(size_t initial_threshold) : next_gc_(initial_threshold) {}
+
+Heap::~Heap() {
+    Obj *obj = objects_;
+    while (obj != nullptr) {
+        Obj *next = obj->next_;
+        if (obj->size_class_ == LARGE_OBJECT) {
+            obj->~Obj();
+            ::operator delete(obj);
+        }
+        obj = next;
+    }
+    for (void *chunk : chunks_) {
+        ::operator delete(chunk);
+    }
+}
+
+// Installs the callback used to mark every root (registers,
+// globals, constants) at the start and end of a cycle.
+void Heap::SetRootMarker(RootMarker marker) {
+    mark_roots_ = std::move(marker);
+}
+
+// Allocates a string holding a copy of `chars`. May perform a
+// bounded amount of collection work first, so callers must have
+// every live value reachable from the roots before calling.
+auto Heap::AllocateString(std::string_view chars) -> ObjString * {
+    size_t size = sizeof(ObjString) + chars.size() + 1;
+
+    if (phase_ == Phase::MARKING || stats_.bytes_allocated_ + size > next_gc_) {
+        auto start = std::chrono::steady_clock::now();
+        if (phase_ == Phase::IDLE) {
+            BeginCycle();
+        }
+        MarkStep(_STRONK_HEAP_MARK_BUDGET);
+        if (gray_.empty()) {
+            FinishCycle();
+        }
+        RecordPause(start);
+    }
+
+    uint8_t size_class = 0;
+    void *block = AllocateBlock(size, size_class);
+
+    auto *str = new (block) ObjString(chars.size());
+    std::memcpy(str->Chars(), chars.data(), chars.size());
+    str->Chars()[chars.size()] = '\0';
+
+    str->size_class_ = size_class;
+    str->size_ = size_class == LARGE_OBJECT ? size : BlockSize(size_class);
+    // Objects born during a cycle are black so they survive it.
+    str->marked_ = phase_ == Phase::MARKING;
+    str->next_ = objects_;
+    objects_ = str;
+
+    stats_.bytes_allocated_ += str->size_;
+    stats_.total_allocated_ += str->size_;
+    return str;
+}
+
+void Heap::MarkValue(const Value &val) {
+    if (val.IsObj()) {
+        MarkObject(val.as_.obj_);
+    }
+}
+
+// Grays an object. Its children are traced later by `Blacken`.
+void Heap::MarkObject(Obj *obj) {
+    if (obj == nullptr || obj->marked_) {
+        return;
+    }
+    obj->marked_ = true;
+    gray_.push_back(obj);
+}
+
+// Must be called after storing `val` into the heap object `owner`
+// so that an already traced owner cannot hide a white object.
+void Heap::WriteBarrier(Obj *owner, const Value &val) {
+    if (phase_ == Phase::MARKING && owner->marked_) {
+        MarkValue(val);
+    }
+}
+
+// Runs a complete stop-the-world collection, finishing any
+// incremental cycle already in progress.
+void Heap::Collect() {
+    auto start = std::chrono::steady_clock::now();
+    if (phase_ == Phase::IDLE) {
+        BeginCycle();
+    }
+    FinishCycle();
+    RecordPause(start);
+}
+
+auto Heap::IsMarking() const -> bool {
+    return phase_ == Phase::MARKING;
+}
+
+auto Heap::GetStats() const -> const HeapStats & {
+    return stats_;
+}
+
+// Prints the heap statistics in a human readable form.
+void Heap::DumpStats(std::ostream &out) const {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    out << "== heap ==\n";
+    out << "bytes allocated:  " << stats_.bytes_allocated_ << "\n";
+    out << "live bytes:       " << stats_.live_bytes_ << "\n";
+    out << "live objects:     " << stats_.live_objects_ << "\n";
+    out << "total allocated:  " << stats_.total_allocated_ << "\n";
+    out << "collections:      " << stats_.collections_ << "\n";
+    out << "mark steps:       " << stats_.mark_steps_ << "\n";
+    out << "total pause (us): " << duration_cast<microseconds>(stats_.total_pause_).count() << "\n";
+    out << "max pause (us):   " << duration_cast<microseconds>(stats_.max_pause_).count() << "\n";
+    out << "pause histogram:\n";
+    for (size_t i = 0; i < stats_.pause_histogram_.size(); i++) {
+        if (stats_.pause_histogram_[i] == 0) {
+            continue;
+        }
+        out << "  < " << std::setw(6) << (1U << i) << " us: " << stats_.pause_histogram_[i] << "\n";
+    }
+}
+
+// Hands out a block from the smallest fitting size class, or a
+// dedicated allocation for large objects.
+auto Heap::AllocateBlock(size_t size, uint8_t &size_class) -> void * {
+    size_class = 0;
+    while (size_class < LARGE_OBJECT && BlockSize(size_class) < size) {
+        size_class++;
+    }
+    if (size_class == LARGE_OBJECT) {
+        return ::operator new(size);
+    }
+
+    SizeClass &cls = classes_[size_class];
+    if (cls.free_list_ != nullptr) {
+        FreeBlock *block = cls.free_list_;
+        cls.free_list_ = block->next_;
+        return block;
+    }
+
+    size_t block_size = BlockSize(size_class);
+    if (cls.bump_ == nullptr || cls.bump_ + block_size > cls.limit_) {
+        auto *chunk = static_cast<char *>(::operator new(_STRONK_HEAP_CHUNK_SIZE));
+        chunks_.push_back(chunk);
+        cls.bump_ = chunk;
+        cls.limit_ = chunk + _STRONK_HEAP_CHUNK_SIZE;
+    }
+    void *block = cls.bump_;
+    cls.bump_ += block_size;
+    return block;
+}
+
+// Returns an object's storage to its free list.
+void Heap::FreeObject(Obj *obj) {
+    stats_.bytes_allocated_ -= obj->size_;
+    uint8_t size_class = obj->size_class_;
+    obj->~Obj();
+
+    if (size_class == LARGE_OBJECT) {
+        ::operator delete(obj);
+        return;
+    }
+    auto *block = reinterpret_cast<FreeBlock *>(obj);
+    block->next_ = classes_[size_class].free_list_;
+    classes_[size_class].free_list_ = block;
+}
+
+void Heap::BeginCycle() {
+    phase_ = Phase::MARKING;
+    if (mark_roots_) {
+        mark_roots_(*this);
+    }
+}
+
+// Traces at most `budget` gray objects.
+void Heap::MarkStep(size_t budget) {
+    stats_.mark_steps_++;
+    while (budget-- > 0 && !gray_.empty()) {
+        Obj *obj = gray_.back();
+        gray_.pop_back();
+        Blacken(obj);
+    }
+}
+
+// Rescans the roots, drains the gray set and sweeps. Registers are
+// written without barriers, so the final root scan is what makes
+// incremental marking safe.
+void Heap::FinishCycle() {
+    if (mark_roots_) {
+        mark_roots_(*this);
+    }
+    MarkStep(SIZE_MAX);
+    Sweep();
+
+    phase_ = Phase::IDLE;
+    stats_.collections_++;
+    stats_.live_bytes_ = stats_.bytes_allocated_;
+    next_gc_ = std::max(next_gc_, stats_.live_bytes_ * _STRONK_HEAP_GROW_FACTOR);
+}
+
+// Marks every object referenced by `obj`.
+void Heap::Blacken(Obj *obj) {
+    switch (obj->type_) {
+        case ObjType::STRING:
+            break;
+    }
+}
+
+void Heap::Sweep() {
+    Obj **link = &objects_;
+    size_t live = 0;
+    while (*link != nullptr) {
+        Obj *obj = *link;
+        if (obj->marked_) {
+            obj->marked_ = false;
+            link = &obj->next_;
+            live++;
+        } else {
+            *link = obj->next_;
+            FreeObject(obj);
+        }
+    }
+    stats_.live_objects_ = live;
+}
+
+void Heap::RecordPause(std::chrono::steady_clock::time_point start) {
+    auto pause = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    stats_.total_pause_ += pause;
+    stats_.max_pause_ = std::max(stats_.max_pause_, pause);
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(pause).count();
+    size_t bucket = 0;
+    while (bucket + 1 < stats_.pause_histogram_.size() && micros >= (1LL << bucket)) {
+        bucket++;
+    }
+    stats_.pause_histogram_[bucket]++;
+}
+
+} // namespace "stronk"
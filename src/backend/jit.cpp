@@ -0,0 +1,626 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <vector>
+#include "backend/jit.h"
+#include "backend/vm.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define STRONK_JIT_ENABLED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define STRONK_JIT_ENABLED 0
+#endif
+
+namespace stronk {
+
+static_assert(sizeof(Value) == 16, "compiled code assumes 16 byte frame slots");
+static_assert(offsetof(Value, type_) == 0, "compiled code assumes the tag leads the slot");
+static_assert(offsetof(Value, as_) == 8, "compiled code assumes the payload at offset 8");
+
+JitCode::~JitCode() {
+#if STRONK_JIT_ENABLED
+    munmap(memory_, size_);
+#endif
+}
+
+auto JitCode::Entry() const -> JitFunction {
+    return reinterpret_cast<JitFunction>(memory_);
+}
+
+auto JitCode::Size() const -> size_t {
+    return size_;
+}
+
+auto JitCompiler::IsSupported() -> bool {
+    return STRONK_JIT_ENABLED != 0;
+}
+
+#if STRONK_JIT_ENABLED
+
+namespace {
+
+// Entry point for instructions compiled code does not translate.
+auto JitSlowPath(VirtualMachine *vm, int pc) -> int {
+    return vm->ExecuteSlowPath(pc) ? 0 : -1;
+}
+
+enum Reg : uint8_t {
+    RAX = 0,
+    RCX = 1,
+    RDX = 2,
+    RBX = 3
+};
+
+// Condition codes, as encoded in the low nibble of Jcc/SETcc.
+enum Cond : uint8_t {
+    CC_B = 0x2,
+    CC_AE = 0x3,
+    CC_E = 0x4,
+    CC_NE = 0x5,
+    CC_A = 0x7,
+    CC_P = 0xA,
+    CC_NP = 0xB,
+    CC_L = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G = 0xF
+};
+
+// Minimal x86-64 encoder. Memory operands are always a frame
+// slot: [rbx + disp32].
+class Assembler {
+public:
+    using JumpLabel = int;
+
+    auto NewLabel() -> JumpLabel {
+        labels_.push_back(-1);
+        return static_cast<JumpLabel>(labels_.size() - 1);
+    }
+
+    void Bind(JumpLabel label) {
+        labels_[label] = static_cast<int>(code_.size());
+    }
+
+    void Emit(std::initializer_list<uint8_t> bytes) {
+        code_.insert(code_.end(), bytes);
+    }
+
+    void Emit32(uint32_t val) {
+        for (int i = 0; i < 4; i++) {
+            code_.push_back(static_cast<uint8_t>(val >> (8 * i)));
+        }
+    }
+
+    void Emit64(uint64_t val) {
+        for (int i = 0; i < 8; i++) {
+            code_.push_back(static_cast<uint8_t>(val >> (8 * i)));
+        }
+    }
+
+    // ModRM byte selecting [rbx + disp32] followed by the displacement.
+    void Slot(uint8_t reg, int32_t disp) {
+        code_.push_back(static_cast<uint8_t>(0x80 | (reg << 3) | RBX));
+        Emit32(static_cast<uint32_t>(disp));
+    }
+
+    void Jmp(JumpLabel label) {
+        Emit({ 0xE9 });
+        Fixup(label);
+    }
+
+    void Jcc(Cond cc, JumpLabel label) {
+        Emit({ 0x0F, static_cast<uint8_t>(0x80 | cc) });
+        Fixup(label);
+    }
+
+    void Setcc(Cond cc, Reg reg) {
+        Emit({ 0x0F, static_cast<uint8_t>(0x90 | cc), static_cast<uint8_t>(0xC0 | reg) });
+    }
+
+    // Patches every jump now that all labels are bound.
+    auto Finish() -> const std::vector<uint8_t> & {
+        for (const auto &[at, label] : fixups_) {
+            auto rel = static_cast<uint32_t>(labels_[label] - (at + 4));
+            std::memcpy(&code_[at], &rel, sizeof(rel));
+        }
+        return code_;
+    }
+private:
+    std::vector<uint8_t> code_;
+    std::vector<int> labels_;
+    std::vector<std::pair<int, JumpLabel>> fixups_;
+
+    void Fixup(JumpLabel label) {
+        fixups_.emplace_back(static_cast<int>(code_.size()), label);
+        Emit32(0);
+    }
+};
+
+constexpr auto TagOf(int slot) -> int32_t {
+    return slot * static_cast<int32_t>(sizeof(Value)) + static_cast<int32_t>(offsetof(Value, type_));
+}
+
+constexpr auto PayloadOf(int slot) -> int32_t {
+    return slot * static_cast<int32_t>(sizeof(Value)) + static_cast<int32_t>(offsetof(Value, as_));
+}
+
+// Translates the instructions [begin, end) of a program. Results
+// are computed in eax/xmm0 and written back to the destination
+// slot together with its tag. Jumps leaving the region return the
+// index to resume at, so the interpreter can pick up from there.
+class Translator {
+public:
+    Translator(const Program &program, const ValueArray &constants, int begin, int end)
+        : program_(program), constants_(constants), begin_(begin), end_(end) {}
+
+    auto Translate() -> const std::vector<uint8_t> & {
+        for (int pc = begin_; pc < end_; pc++) {
+            instr_labels_.push_back(as_.NewLabel());
+        }
+        error_ = as_.NewLabel();
+        exit_ = as_.NewLabel();
+
+        // push rbp; mov rbp, rsp; push rbx; push r13
+        as_.Emit({ 0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x55 });
+        // mov rbx, rdi (registers); mov r13, rsi (vm)
+        as_.Emit({ 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF5 });
+
+        for (int pc = begin_; pc < end_; pc++) {
+            as_.Bind(instr_labels_[pc - begin_]);
+            TranslateInstr(pc, program_.code_[pc]);
+        }
+        as_.Jmp(Target(end_));
+
+        as_.Bind(exit_);
+        as_.Emit({ 0x41, 0x5D, 0x5B, 0x5D, 0xC3 }); // pop r13; pop rbx; pop rbp; ret
+        as_.Bind(error_);
+        as_.Emit({ 0xB8 });                         // mov eax, -1
+        as_.Emit32(static_cast<uint32_t>(-1));
+        as_.Jmp(exit_);
+
+        for (const auto &[target, label] : exits_) {
+            as_.Bind(label);
+            as_.Emit({ 0xB8 });                     // mov eax, target
+            as_.Emit32(static_cast<uint32_t>(target));
+            as_.Jmp(exit_);
+        }
+        return as_.Finish();
+    }
+private:
+    const Program &program_;
+    const ValueArray &constants_;
+    int begin_;
+    int end_;
+    Assembler as_;
+    std::vector<Assembler::JumpLabel> instr_labels_;
+    std::map<int, Assembler::JumpLabel> exits_;
+    Assembler::JumpLabel error_ = 0;
+    Assembler::JumpLabel exit_ = 0;
+
+    // Label for instruction `pc`, or an exit stub if it lies
+    // outside the region.
+    auto Target(int pc) -> Assembler::JumpLabel {
+        if (pc >= begin_ && pc < end_) {
+            return instr_labels_[pc - begin_];
+        }
+        if (auto it = exits_.find(pc); it != exits_.end()) {
+            return it->second;
+        }
+        return exits_[pc] = as_.NewLabel();
+    }
+
+    void LoadInt(Reg reg, int slot) {
+        as_.Emit({ 0x8B });
+        as_.Slot(reg, PayloadOf(slot));
+    }
+
+    void LoadReal(int slot) {
+        as_.Emit({ 0xF3, 0x0F, 0x10 });
+        as_.Slot(0, PayloadOf(slot));
+    }
+
+    // Stores rax as the payload of `slot` and sets its tag.
+    void Store(int slot, ValueType type) {
+        as_.Emit({ 0x48, 0x89 });
+        as_.Slot(RAX, PayloadOf(slot));
+        as_.Emit({ 0xC6 });
+        as_.Slot(0, TagOf(slot));
+        as_.Emit({ static_cast<uint8_t>(type) });
+    }
+
+    void StoreReal(int slot) {
+        as_.Emit({ 0x66, 0x0F, 0x7E, 0xC0 }); // movd eax, xmm0
+        Store(slot, ValueType::REAL);
+    }
+
+    void StoreBool(int slot) {
+        as_.Emit({ 0x0F, 0xB6, 0xC0 });       // movzx eax, al
+        Store(slot, ValueType::BOOL);
+    }
+
+    // eax = eax <op> [b]
+    void IntOp(std::initializer_list<uint8_t> opcode, const ProgramInstr &instr) {
+        LoadInt(RAX, instr.a_);
+        as_.Emit(opcode);
+        as_.Slot(RAX, PayloadOf(instr.b_));
+        Store(instr.dest_, ValueType::INT);
+    }
+
+    // xmm0 = xmm0 <op> [b]
+    void RealOp(uint8_t opcode, const ProgramInstr &instr) {
+        LoadReal(instr.a_);
+        as_.Emit({ 0xF3, 0x0F, opcode });
+        as_.Slot(0, PayloadOf(instr.b_));
+        StoreReal(instr.dest_);
+    }
+
+    void IntCompare(Cond cc, const ProgramInstr &instr) {
+        LoadInt(RAX, instr.a_);
+        as_.Emit({ 0x3B });
+        as_.Slot(RAX, PayloadOf(instr.b_));
+        as_.Setcc(cc, RAX);
+        StoreBool(instr.dest_);
+    }
+
+    // eax = eax <op> k
+    void IntOpImm(std::initializer_list<uint8_t> opcode, const ProgramInstr &instr) {
+        LoadInt(RAX, instr.a_);
+        as_.Emit(opcode);
+        as_.Emit32(static_cast<uint32_t>(instr.b_));
+        Store(instr.dest_, ValueType::INT);
+    }
+
+    // xmm1 = k, through ecx.
+    void LoadRealImm(int bits) {
+        as_.Emit({ 0xB9 });                   // mov ecx, k
+        as_.Emit32(static_cast<uint32_t>(bits));
+        as_.Emit({ 0x66, 0x0F, 0x6E, 0xC9 }); // movd xmm1, ecx
+    }
+
+    // xmm0 = xmm0 <op> k
+    void RealOpImm(uint8_t opcode, const ProgramInstr &instr) {
+        LoadReal(instr.a_);
+        LoadRealImm(instr.b_);
+        as_.Emit({ 0xF3, 0x0F, opcode, 0xC1 });
+        StoreReal(instr.dest_);
+    }
+
+    void IntCompareImm(Cond cc, const ProgramInstr &instr) {
+        LoadInt(RAX, instr.a_);
+        as_.Emit({ 0x3D });                   // cmp eax, k
+        as_.Emit32(static_cast<uint32_t>(instr.b_));
+        as_.Setcc(cc, RAX);
+        StoreBool(instr.dest_);
+    }
+
+    // ucomiss sets CF/ZF like an unsigned compare, so `<` and `<=`
+    // swap their operands and test above / above-or-equal.
+    static auto SwapsOperands(OpCode code) -> bool {
+        return code == OpCode::FLT || code == OpCode::FLEQ || code == OpCode::FLTI || code == OpCode::FLEQI;
+    }
+
+    void RealCompare(OpCode code, const ProgramInstr &instr) {
+        bool swap = SwapsOperands(code);
+        LoadReal(swap ? instr.b_ : instr.a_);
+        as_.Emit({ 0x0F, 0x2E });
+        as_.Slot(0, PayloadOf(swap ? instr.a_ : instr.b_));
+        RealCondition(code);
+        StoreBool(instr.dest_);
+    }
+
+    void RealCompareImm(OpCode code, const ProgramInstr &instr) {
+        LoadReal(instr.a_);
+        LoadRealImm(instr.b_);
+        if (SwapsOperands(code)) {
+            as_.Emit({ 0x0F, 0x2E, 0xC8 });   // ucomiss xmm1, xmm0
+        } else {
+            as_.Emit({ 0x0F, 0x2E, 0xC1 });   // ucomiss xmm0, xmm1
+        }
+        RealCondition(code);
+        StoreBool(instr.dest_);
+    }
+
+    // al = the flags of a ucomiss tested for `code`.
+    void RealCondition(OpCode code) {
+        switch (code) {
+            case OpCode::FGT:
+            case OpCode::FLT:
+            case OpCode::FGTI:
+            case OpCode::FLTI:
+                as_.Setcc(CC_A, RAX);
+                break;
+            case OpCode::FGEQ:
+            case OpCode::FLEQ:
+            case OpCode::FGEQI:
+            case OpCode::FLEQI:
+                as_.Setcc(CC_AE, RAX);
+                break;
+            case OpCode::FEQ:
+            case OpCode::FEQI:
+                as_.Setcc(CC_E, RAX);
+                as_.Setcc(CC_NP, RCX);
+                as_.Emit({ 0x20, 0xC8 }); // and al, cl
+                break;
+            default:
+                as_.Setcc(CC_NE, RAX);
+                as_.Setcc(CC_P, RCX);
+                as_.Emit({ 0x08, 0xC8 }); // or al, cl
+                break;
+        }
+    }
+
+    // Compares eax with b_, a register or an immediate, and jumps
+    // to target_ if `cc` holds and to alt_ otherwise.
+    void BranchOn(Cond cc, const ProgramInstr &instr, bool immediate) {
+        if (immediate) {
+            as_.Emit({ 0x3D });               // cmp eax, k
+            as_.Emit32(static_cast<uint32_t>(instr.b_));
+        } else {
+            as_.Emit({ 0x3B });               // cmp eax, [b]
+            as_.Slot(RAX, PayloadOf(instr.b_));
+        }
+        as_.Jcc(cc, Target(instr.target_));
+        as_.Jmp(Target(instr.alt_));
+    }
+
+    void CompareBranch(Cond cc, const ProgramInstr &instr, bool immediate) {
+        LoadInt(RAX, instr.a_);
+        BranchOn(cc, instr, immediate);
+    }
+
+    void CounterBranch(Cond cc, const ProgramInstr &instr, bool immediate) {
+        LoadInt(RAX, instr.a_);
+        as_.Emit({ 0x05 });                   // add eax, step
+        as_.Emit32(static_cast<uint32_t>(instr.c_));
+        Store(instr.a_, ValueType::INT);
+        BranchOn(cc, instr, immediate);
+    }
+
+    // Calls back into the VM to execute instruction `pc`.
+    void SlowPath(int pc) {
+        as_.Emit({ 0x4C, 0x89, 0xEF });       // mov rdi, r13
+        as_.Emit({ 0xBE });                   // mov esi, pc
+        as_.Emit32(static_cast<uint32_t>(pc));
+        as_.Emit({ 0x48, 0xB8 });             // mov rax, JitSlowPath
+        as_.Emit64(reinterpret_cast<uint64_t>(&JitSlowPath));
+        as_.Emit({ 0xFF, 0xD0 });             // call rax
+        as_.Emit({ 0x85, 0xC0 });             // test eax, eax
+        as_.Jcc(CC_NE, error_);
+    }
+
+    void Div(int pc, const ProgramInstr &instr) {
+        auto divide = as_.NewLabel();
+        auto store = as_.NewLabel();
+        auto nonzero = as_.NewLabel();
+
+        LoadInt(RAX, instr.a_);
+        LoadInt(RCX, instr.b_);
+        as_.Emit({ 0x85, 0xC9 });             // test ecx, ecx
+        as_.Jcc(CC_NE, nonzero);
+        SlowPath(pc);                         // Reports division by zero.
+        as_.Jmp(error_);
+
+        as_.Bind(nonzero);
+        as_.Emit({ 0x83, 0xF9, 0xFF });       // cmp ecx, -1
+        as_.Jcc(CC_NE, divide);
+        as_.Emit({ 0xF7, 0xD8 });             // neg eax
+        as_.Jmp(store);
+        as_.Bind(divide);
+        as_.Emit({ 0x99, 0xF7, 0xF9 });       // cdq; idiv ecx
+        as_.Bind(store);
+        Store(instr.dest_, ValueType::INT);
+    }
+
+    void TranslateInstr(int pc, const ProgramInstr &instr) {
+        switch (instr.code_) {
+            case OpCode::ADD: IntOp({ 0x03 }, instr); break;
+            case OpCode::SUB: IntOp({ 0x2B }, instr); break;
+            case OpCode::MULT: IntOp({ 0x0F, 0xAF }, instr); break;
+            case OpCode::DIV: Div(pc, instr); break;
+            case OpCode::NEG:
+                LoadInt(RAX, instr.a_);
+                as_.Emit({ 0xF7, 0xD8 });       // neg eax
+                Store(instr.dest_, ValueType::INT);
+                break;
+
+            case OpCode::FADD: RealOp(0x58, instr); break;
+            case OpCode::FSUB: RealOp(0x5C, instr); break;
+            case OpCode::FMULT: RealOp(0x59, instr); break;
+            case OpCode::FDIV: RealOp(0x5E, instr); break;
+            case OpCode::FNEG:
+                as_.Emit({ 0x0F, 0x57, 0xC0 }); // xorps xmm0, xmm0
+                as_.Emit({ 0xF3, 0x0F, 0x5C }); // subss xmm0, [a]
+                as_.Slot(0, PayloadOf(instr.a_));
+                StoreReal(instr.dest_);
+                break;
+
+            case OpCode::EQ: IntCompare(CC_E, instr); break;
+            case OpCode::NEQ: IntCompare(CC_NE, instr); break;
+            case OpCode::GT: IntCompare(CC_G, instr); break;
+            case OpCode::LT: IntCompare(CC_L, instr); break;
+            case OpCode::GEQ: IntCompare(CC_GE, instr); break;
+            case OpCode::LEQ: IntCompare(CC_LE, instr); break;
+
+            case OpCode::FEQ:
+            case OpCode::FNEQ:
+            case OpCode::FGT:
+            case OpCode::FLT:
+            case OpCode::FGEQ:
+            case OpCode::FLEQ:
+                RealCompare(instr.code_, instr);
+                break;
+
+            case OpCode::ADDI: IntOpImm({ 0x05 }, instr); break;
+            case OpCode::SUBI: IntOpImm({ 0x2D }, instr); break;
+            case OpCode::MULTI: IntOpImm({ 0x69, 0xC0 }, instr); break;
+            case OpCode::EQI: IntCompareImm(CC_E, instr); break;
+            case OpCode::NEQI: IntCompareImm(CC_NE, instr); break;
+            case OpCode::GTI: IntCompareImm(CC_G, instr); break;
+            case OpCode::LTI: IntCompareImm(CC_L, instr); break;
+            case OpCode::GEQI: IntCompareImm(CC_GE, instr); break;
+            case OpCode::LEQI: IntCompareImm(CC_LE, instr); break;
+
+            case OpCode::FADDI: RealOpImm(0x58, instr); break;
+            case OpCode::FSUBI: RealOpImm(0x5C, instr); break;
+            case OpCode::FMULTI: RealOpImm(0x59, instr); break;
+            case OpCode::FDIVI: RealOpImm(0x5E, instr); break;
+            case OpCode::FEQI:
+            case OpCode::FNEQI:
+            case OpCode::FGTI:
+            case OpCode::FLTI:
+            case OpCode::FGEQI:
+            case OpCode::FLEQI:
+                RealCompareImm(instr.code_, instr);
+                break;
+
+            case OpCode::F2I:
+                as_.Emit({ 0xF3, 0x0F, 0x2C }); // cvttss2si eax, [a]
+                as_.Slot(RAX, PayloadOf(instr.a_));
+                Store(instr.dest_, ValueType::INT);
+                break;
+            case OpCode::I2F:
+                as_.Emit({ 0xF3, 0x0F, 0x2A }); // cvtsi2ss xmm0, [a]
+                as_.Slot(0, PayloadOf(instr.a_));
+                StoreReal(instr.dest_);
+                break;
+
+            // Booleans are 0 or 1 in a zeroed payload, so bitwise
+            // operations on the whole word are exact.
+            case OpCode::AND:
+                LoadInt(RAX, instr.a_);
+                as_.Emit({ 0x23 });
+                as_.Slot(RAX, PayloadOf(instr.b_));
+                Store(instr.dest_, ValueType::BOOL);
+                break;
+            case OpCode::OR:
+                LoadInt(RAX, instr.a_);
+                as_.Emit({ 0x0B });
+                as_.Slot(RAX, PayloadOf(instr.b_));
+                Store(instr.dest_, ValueType::BOOL);
+                break;
+            case OpCode::XOR:
+                LoadInt(RAX, instr.a_);
+                as_.Emit({ 0x33 });
+                as_.Slot(RAX, PayloadOf(instr.b_));
+                Store(instr.dest_, ValueType::BOOL);
+                break;
+
+            case OpCode::JMP:
+                as_.Jmp(Target(instr.target_));
+                break;
+            case OpCode::BR:
+                as_.Emit({ 0x80 });             // cmp byte [a], 0
+                as_.Slot(7, PayloadOf(instr.a_));
+                as_.Emit({ 0x00 });
+                as_.Jcc(CC_NE, Target(instr.target_));
+                as_.Jmp(Target(instr.alt_));
+                break;
+
+            case OpCode::BEQ: CompareBranch(CC_E, instr, false); break;
+            case OpCode::BNEQ: CompareBranch(CC_NE, instr, false); break;
+            case OpCode::BGT: CompareBranch(CC_G, instr, false); break;
+            case OpCode::BLT: CompareBranch(CC_L, instr, false); break;
+            case OpCode::BGEQ: CompareBranch(CC_GE, instr, false); break;
+            case OpCode::BLEQ: CompareBranch(CC_LE, instr, false); break;
+            case OpCode::BEQI: CompareBranch(CC_E, instr, true); break;
+            case OpCode::BNEQI: CompareBranch(CC_NE, instr, true); break;
+            case OpCode::BGTI: CompareBranch(CC_G, instr, true); break;
+            case OpCode::BLTI: CompareBranch(CC_L, instr, true); break;
+            case OpCode::BGEQI: CompareBranch(CC_GE, instr, true); break;
+            case OpCode::BLEQI: CompareBranch(CC_LE, instr, true); break;
+            case OpCode::INCBLT: CounterBranch(CC_L, instr, false); break;
+            case OpCode::INCBLEQ: CounterBranch(CC_LE, instr, false); break;
+            case OpCode::INCBLTI: CounterBranch(CC_L, instr, true); break;
+            case OpCode::INCBLEQI: CounterBranch(CC_LE, instr, true); break;
+
+            case OpCode::MADD:
+                LoadInt(RAX, instr.a_);
+                as_.Emit({ 0x0F, 0xAF });       // imul eax, [b]
+                as_.Slot(RAX, PayloadOf(instr.b_));
+                as_.Emit({ 0x03 });             // add eax, [c]
+                as_.Slot(RAX, PayloadOf(instr.c_));
+                Store(instr.dest_, ValueType::INT);
+                break;
+            case OpCode::FMADD:
+                LoadReal(instr.a_);
+                as_.Emit({ 0xF3, 0x0F, 0x59 }); // mulss xmm0, [b]
+                as_.Slot(0, PayloadOf(instr.b_));
+                as_.Emit({ 0xF3, 0x0F, 0x58 }); // addss xmm0, [c]
+                as_.Slot(0, PayloadOf(instr.c_));
+                StoreReal(instr.dest_);
+                break;
+
+            case OpCode::ID:
+                for (int offset = 0; offset < static_cast<int>(sizeof(Value)); offset += 8) {
+                    as_.Emit({ 0x48, 0x8B });   // mov rax, [a + offset]
+                    as_.Slot(RAX, instr.a_ * static_cast<int>(sizeof(Value)) + offset);
+                    as_.Emit({ 0x48, 0x89 });   // mov [dest + offset], rax
+                    as_.Slot(RAX, instr.dest_ * static_cast<int>(sizeof(Value)) + offset);
+                }
+                break;
+            case OpCode::CONST: {
+                const Value &val = constants_[instr.a_];
+                as_.Emit({ 0x48, 0xB8 });       // mov rax, imm64
+                as_.Emit64(val.as_.bits_);
+                Store(instr.dest_, val.type_);
+                break;
+            }
+
+            // Lowered programs only contain labels as no-ops left
+            // behind by optimization passes.
+            case OpCode::LABEL:
+                break;
+
+            default:
+                SlowPath(pc);
+                break;
+        }
+    }
+};
+
+} // namespace
+
+// Translates the whole program.
+auto JitCompiler::Compile(const Program &program, const ValueArray &constants) -> std::unique_ptr<JitCode> {
+    return CompileRegion(program, constants, 0, static_cast<int>(program.code_.size()));
+}
+
+// Translates instructions [begin, end) and copies them into
+// executable memory. The code is entered at `begin`. Constants are
+// embedded as immediates, so `constants` must stay alive (and
+// rooted) while the code runs.
+auto JitCompiler::CompileRegion(const Program &program, const ValueArray &constants, int begin, int end) -> std::unique_ptr<JitCode> {
+    Translator translator(program, constants, begin, end);
+    const std::vector<uint8_t> &code = translator.Translate();
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (code.size() + page - 1) / page * page;
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    return std::make_unique<JitCode>(memory, size);
+}
+
+#else
+
+auto JitCompiler::Compile(const Program &, const ValueArray &) -> std::unique_ptr<JitCode> {
+    return nullptr;
+}
+
+auto JitCompiler::CompileRegion(const Program &, const ValueArray &, int, int) -> std::unique_ptr<JitCode> {
+    return nullptr;
+}
+
+#endif // STRONK_JIT_ENABLED
+
+} // namespace "stronk"
@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <variant>
+#include <vector>
+#include "backend/optimizer.h"
+
+namespace stronk {
+
+// Whether `instr` writes a register through `dest_`.
+static auto HasDestination(const ProgramInstr &instr) -> bool {
+    if (IsBranch(instr.code_)) {
+        return false;
+    }
+    switch (instr.code_) {
+        case OpCode::LABEL:
+        case OpCode::PRINT:
+            return false;
+        default:
+            return instr.dest_ >= 0;
+    }
+}
+
+// Counts the reads of every register and marks jump targets.
+static void CountUses(const Program &program, std::vector<int> &uses, std::vector<bool> &is_target) {
+    uses.assign(program.num_registers_, 0);
+    is_target.assign(program.code_.size() + 1, false);
+    for (const auto &instr : program.code_) {
+        if (IsBranch(instr.code_)) {
+            is_target[instr.target_] = true;
+            if (instr.code_ != OpCode::JMP) {
+                is_target[instr.alt_] = true;
+            }
+        }
+        if (instr.code_ == OpCode::PRINT) {
+            for (int i = 0; i < instr.b_; i++) {
+                uses[program.operands_[instr.a_ + i]]++;
+            }
+        }
+        ForEachRegister(instr, [&](const int &slot) {
+            if (&slot != &instr.dest_) {
+                uses[slot]++;
+            }
+        });
+    }
+}
+
+// Compare-and-branch form of the int comparison `code`.
+static auto BranchForm(OpCode code) -> std::optional<OpCode> {
+    switch (code) {
+        case OpCode::EQ: return OpCode::BEQ;
+        case OpCode::NEQ: return OpCode::BNEQ;
+        case OpCode::GT: return OpCode::BGT;
+        case OpCode::LT: return OpCode::BLT;
+        case OpCode::GEQ: return OpCode::BGEQ;
+        case OpCode::LEQ: return OpCode::BLEQ;
+        case OpCode::EQI: return OpCode::BEQI;
+        case OpCode::NEQI: return OpCode::BNEQI;
+        case OpCode::GTI: return OpCode::BGTI;
+        case OpCode::LTI: return OpCode::BLTI;
+        case OpCode::GEQI: return OpCode::BGEQI;
+        case OpCode::LEQI: return OpCode::BLEQI;
+        default: return std::nullopt;
+    }
+}
+
+// Counter form of the compare-and-branch `code`.
+static auto IncrementForm(OpCode code) -> std::optional<OpCode> {
+    switch (code) {
+        case OpCode::BLT: return OpCode::INCBLT;
+        case OpCode::BLEQ: return OpCode::INCBLEQ;
+        case OpCode::BLTI: return OpCode::INCBLTI;
+        case OpCode::BLEQI: return OpCode::INCBLEQI;
+        default: return std::nullopt;
+    }
+}
+
+static void MakeNoOp(ProgramInstr &instr) {
+    int line = instr.line_;
+    instr = ProgramInstr{ OpCode::LABEL };
+    instr.line_ = line;
+}
+
+void CoalesceCopies(Program &program, int begin, int end) {
+    std::vector<int> uses;
+    std::vector<bool> is_target;
+    CountUses(program, uses, is_target);
+
+    int num_globals = static_cast<int>(program.globals_.size());
+    for (int pc = begin; pc + 1 < end; pc++) {
+        ProgramInstr &def = program.code_[pc];
+        ProgramInstr &copy = program.code_[pc + 1];
+        if (copy.code_ != OpCode::ID || !HasDestination(def) || copy.a_ != def.dest_) {
+            continue;
+        }
+        // Named variables stay observable and jumps straight to
+        // the copy would skip the rewritten definition.
+        if (def.dest_ < num_globals || uses[def.dest_] != 1 || is_target[pc + 1]) {
+            continue;
+        }
+        def.dest_ = copy.dest_;
+        copy = ProgramInstr{ OpCode::LABEL };
+        copy.line_ = def.line_;
+    }
+}
+
+// The register `instr` writes, if any. Counter branches write a_,
+// which they keep in dest_ too.
+static auto WrittenRegister(const ProgramInstr &instr) -> int {
+    return instr.code_ == OpCode::LABEL || instr.code_ == OpCode::PRINT ? -1 : instr.dest_;
+}
+
+// Converts the constant `value` like I2F / F2I would at run time.
+// Reals outside the int range are left alone, since converting
+// them is undefined.
+static auto ConvertConstant(OpCode code, const ConstantPool::ConstantValue &value)
+    -> std::optional<ConstantPool::ConstantValue> {
+    if (code == OpCode::I2F) {
+        if (auto i = std::get_if<int>(&value)) {
+            return static_cast<float>(*i);
+        }
+    } else if (auto f = std::get_if<float>(&value)) {
+        if (std::isfinite(*f) && *f > -2147483904.0f && *f < 2147483648.0f) {
+            return static_cast<int>(*f);
+        }
+    }
+    return std::nullopt;
+}
+
+// Constant pool index of `value`, appended when missing.
+static auto InternConstant(Program &program, const ConstantPool::ConstantValue &value) -> int {
+    auto it = std::find(program.constants_.begin(), program.constants_.end(), value);
+    if (it == program.constants_.end()) {
+        program.constants_.push_back(value);
+        return static_cast<int>(program.constants_.size()) - 1;
+    }
+    return static_cast<int>(it - program.constants_.begin());
+}
+
+void EliminateConversions(Program &program) {
+    int size = static_cast<int>(program.code_.size());
+    int num_globals = static_cast<int>(program.globals_.size());
+
+    // Writes and reads of every register, and the blocks.
+    std::vector<std::vector<int>> writes(program.num_registers_);
+    std::vector<std::vector<int>> readers(program.num_registers_);
+    std::vector<std::vector<int>> preds(size + 1);
+    std::vector<bool> is_leader(size + 1, false);
+    is_leader[0] = true;
+    for (int pc = 0; pc < size; pc++) {
+        const ProgramInstr &instr = program.code_[pc];
+        if (int written = WrittenRegister(instr); written >= 0) {
+            writes[written].push_back(pc);
+        }
+        if (instr.code_ == OpCode::PRINT) {
+            for (int i = 0; i < instr.b_; i++) {
+                readers[program.operands_[instr.a_ + i]].push_back(pc);
+            }
+        }
+        ForEachRegister(instr, [&](const int &slot) {
+            if (&slot != &instr.dest_) {
+                readers[slot].push_back(pc);
+            }
+        });
+        if (IsBranch(instr.code_)) {
+            preds[instr.target_].push_back(pc);
+            is_leader[instr.target_] = true;
+            if (instr.code_ != OpCode::JMP) {
+                preds[instr.alt_].push_back(pc);
+                is_leader[instr.alt_] = true;
+            }
+            is_leader[pc + 1] = true;
+        } else {
+            preds[pc + 1].push_back(pc);
+        }
+    }
+    std::vector<int> block(size, 0);
+    for (int pc = 1; pc < size; pc++) {
+        block[pc] = block[pc - 1] + (is_leader[pc] ? 1 : 0);
+    }
+    // A temporary only written once always holds the same value
+    // once written, so conversions into it can be reused and a
+    // constant in it can be converted while lowering.
+    auto is_single = [&](int slot) { return slot >= num_globals && writes[slot].size() == 1; };
+    auto written_in = [&](int slot, int begin, int end) {
+        auto it = std::lower_bound(writes[slot].begin(), writes[slot].end(), begin);
+        return it != writes[slot].end() && *it <= end;
+    };
+
+    // `dest_` holds `code_` applied to `a_`.
+    struct Conversion {
+        OpCode code_;
+        int a_;
+        int dest_;
+
+        auto operator==(const Conversion &other) const -> bool {
+            return code_ == other.code_ && a_ == other.a_ && dest_ == other.dest_;
+        }
+    };
+    std::vector<Conversion> available;
+    std::vector<std::vector<Conversion>> block_exit(size);
+    std::vector<int> dropped_reads(program.num_registers_, 0);
+
+    for (int pc = 0; pc < size; pc++) {
+        if (is_leader[pc]) {
+            // Forward predecessors were walked already. Lowered code
+            // is structured, so a loop spans its header up to its
+            // back-edge, and a conversion stays available around the
+            // loop when the body overwrites neither side of it.
+            bool first = true;
+            available.clear();
+            for (int pred : preds[pc]) {
+                if (pred >= pc) {
+                    continue;
+                }
+                if (first) {
+                    available = block_exit[pred];
+                    first = false;
+                    continue;
+                }
+                const auto &other = block_exit[pred];
+                available.erase(std::remove_if(available.begin(), available.end(), [&](const Conversion &c) {
+                    return std::find(other.begin(), other.end(), c) == other.end();
+                }), available.end());
+            }
+            for (int pred : preds[pc]) {
+                if (pred < pc) {
+                    continue;
+                }
+                available.erase(std::remove_if(available.begin(), available.end(), [&](const Conversion &c) {
+                    return written_in(c.a_, pc, pred) || written_in(c.dest_, pc, pred);
+                }), available.end());
+            }
+        }
+
+        ProgramInstr &instr = program.code_[pc];
+        bool conversion = (instr.code_ == OpCode::I2F || instr.code_ == OpCode::F2I) && is_single(instr.dest_);
+        if (conversion && is_single(instr.a_) && program.code_[writes[instr.a_][0]].code_ == OpCode::CONST) {
+            const ProgramInstr &constant = program.code_[writes[instr.a_][0]];
+            if (auto value = ConvertConstant(instr.code_, program.constants_[constant.a_])) {
+                dropped_reads[instr.a_]++;
+                instr.code_ = OpCode::CONST;
+                instr.a_ = InternConstant(program, *value);
+                conversion = false;
+            }
+        }
+        if (conversion) {
+            auto it = std::find_if(available.begin(), available.end(), [&](const Conversion &c) {
+                return c.code_ == instr.code_ && c.a_ == instr.a_;
+            });
+            // Readers of the repeated conversion must see the first
+            // one's result unchanged, so they have to follow it in
+            // its block.
+            int dest = instr.dest_;
+            bool local = std::all_of(readers[dest].begin(), readers[dest].end(), [&](int reader) {
+                return reader > pc && block[reader] == block[pc];
+            });
+            if (it != available.end() && local && !readers[dest].empty()
+                && !written_in(it->dest_, pc, readers[dest].back())) {
+                int reuse = it->dest_;
+                for (int reader : readers[dest]) {
+                    ProgramInstr &user = program.code_[reader];
+                    ForEachRegister(user, [&](int &slot) {
+                        if (&slot != &user.dest_ && slot == dest) {
+                            slot = reuse;
+                        }
+                    });
+                    if (user.code_ == OpCode::PRINT) {
+                        for (int i = 0; i < user.b_; i++) {
+                            int &slot = program.operands_[user.a_ + i];
+                            slot = slot == dest ? reuse : slot;
+                        }
+                    }
+                }
+                dropped_reads[instr.a_]++;
+                MakeNoOp(instr);
+            } else {
+                available.push_back({ instr.code_, instr.a_, dest });
+            }
+        } else if (int written = WrittenRegister(instr); written >= 0) {
+            available.erase(std::remove_if(available.begin(), available.end(), [&](const Conversion &c) {
+                return c.a_ == written || c.dest_ == written;
+            }), available.end());
+        }
+        if (pc + 1 >= size || is_leader[pc + 1]) {
+            block_exit[pc] = available;
+        }
+    }
+
+    // Constants whose every read was converted at compile time.
+    for (int slot = num_globals; slot < program.num_registers_; slot++) {
+        if (is_single(slot) && !readers[slot].empty() && dropped_reads[slot] == static_cast<int>(readers[slot].size())
+            && program.code_[writes[slot][0]].code_ == OpCode::CONST) {
+            MakeNoOp(program.code_[writes[slot][0]]);
+        }
+    }
+}
+
+void ThreadBranches(Program &program) {
+    int size = static_cast<int>(program.code_.size());
+    for (auto &instr : program.code_) {
+        if (instr.code_ != OpCode::BR) {
+            continue;
+        }
+        for (int *side : { &instr.target_, &instr.alt_ }) {
+            bool condition = side == &instr.target_;
+            // The hop limit stops on branches that loop to themselves.
+            for (int hops = 0; hops < size; hops++) {
+                int next = *side;
+                while (next < size && program.code_[next].code_ == OpCode::LABEL) {
+                    next++;
+                }
+                if (next >= size || program.code_[next].code_ != OpCode::BR || program.code_[next].a_ != instr.a_) {
+                    break;
+                }
+                *side = condition ? program.code_[next].target_ : program.code_[next].alt_;
+            }
+        }
+    }
+}
+
+void SelectSuperinstructions(Program &program) {
+    int size = static_cast<int>(program.code_.size());
+    int num_globals = static_cast<int>(program.globals_.size());
+    std::vector<int> uses;
+    std::vector<bool> is_target;
+    CountUses(program, uses, is_target);
+
+    // A temporary defined at `pc` and only read by the instruction
+    // after it, which nothing else jumps to.
+    auto feeds_next = [&](int pc) {
+        const ProgramInstr &def = program.code_[pc];
+        return HasDestination(def) && def.dest_ >= num_globals && uses[def.dest_] == 1 && !is_target[pc + 1];
+    };
+    // An int compare read by the BR after it, which nothing else
+    // jumps to. The register may have several definitions, like the
+    // merge register of a short-circuit chain; the compare can still
+    // be dropped when every read of the register is fed like this,
+    // right by the instruction before it.
+    auto feeds_branch = [&](int pc) {
+        const ProgramInstr &def = program.code_[pc];
+        const ProgramInstr &next = program.code_[pc + 1];
+        return HasDestination(def) && def.dest_ >= num_globals && BranchForm(def.code_).has_value()
+               && next.code_ == OpCode::BR && next.a_ == def.dest_ && !is_target[pc + 1];
+    };
+    std::vector<int> local_reads(program.num_registers_, 0);
+    for (int pc = 0; pc + 1 < size; pc++) {
+        const ProgramInstr &def = program.code_[pc];
+        const ProgramInstr &next = program.code_[pc + 1];
+        if (!HasDestination(def) || is_target[pc + 1] || next.code_ == OpCode::PRINT) {
+            continue;
+        }
+        ForEachRegister(next, [&](const int &slot) {
+            if (&slot != &next.dest_ && slot == def.dest_) {
+                local_reads[slot]++;
+            }
+        });
+    }
+
+    // Compare + BR, and multiply + add.
+    for (int pc = 0; pc + 1 < size; pc++) {
+        ProgramInstr &def = program.code_[pc];
+        ProgramInstr &next = program.code_[pc + 1];
+        if (feeds_branch(pc) && local_reads[def.dest_] == uses[def.dest_]) {
+            next.code_ = *BranchForm(def.code_);
+            next.a_ = def.a_;
+            next.b_ = def.b_;
+            MakeNoOp(def);
+            continue;
+        }
+        if (!feeds_next(pc)) {
+            continue;
+        }
+        bool int_madd = def.code_ == OpCode::MULT && next.code_ == OpCode::ADD;
+        bool real_madd = def.code_ == OpCode::FMULT && next.code_ == OpCode::FADD;
+        if ((int_madd || real_madd) && (next.a_ == def.dest_ || next.b_ == def.dest_)) {
+            int addend = next.a_ == def.dest_ ? next.b_ : next.a_;
+            next.code_ = int_madd ? OpCode::MADD : OpCode::FMADD;
+            next.a_ = def.a_;
+            next.b_ = def.b_;
+            next.c_ = addend;
+            MakeNoOp(def);
+        }
+    }
+
+    // Jumps to a conditional branch take the branch themselves, so
+    // loops no longer jump back to their condition. Targets are
+    // absolute, so the copy behaves exactly like the original.
+    for (auto &instr : program.code_) {
+        if (instr.code_ != OpCode::JMP) {
+            continue;
+        }
+        int target = instr.target_;
+        while (target < size && program.code_[target].code_ == OpCode::LABEL) {
+            target++;
+        }
+        if (target < size && IsBranch(program.code_[target].code_) && program.code_[target].code_ != OpCode::JMP) {
+            instr = program.code_[target];
+        }
+    }
+
+    // Counters: `x = x + k` right before a compare-and-branch on x.
+    for (int pc = 0; pc + 1 < size; pc++) {
+        ProgramInstr &def = program.code_[pc];
+        ProgramInstr &next = program.code_[pc + 1];
+        std::optional<OpCode> counter = IncrementForm(next.code_);
+        if (def.code_ != OpCode::ADDI || def.dest_ != def.a_ || !counter.has_value()
+            || next.a_ != def.dest_ || is_target[pc + 1]) {
+            continue;
+        }
+        next.code_ = *counter;
+        next.dest_ = next.a_;
+        next.c_ = def.b_;
+        MakeNoOp(def);
+    }
+}
+
+} // namespace "stronk"
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <iomanip>
+#include "backend/profiler.h"
+
+namespace stronk {
+
+// Prepares counters for `program` and splits it into basic blocks.
+// Leaders are the first instruction, jump targets and instructions
+// following a jump.
+void Profiler::Reset(const Program &program) {
+    int size = static_cast<int>(program.code_.size());
+    program_ = &program;
+    counts_.assign(size, 0);
+    block_of_.assign(size, -1);
+    current_.clear();
+    timed_block_ = -1;
+
+    std::vector<bool> leader(size + 1, false);
+    leader[0] = true;
+    for (int pc = 0; pc < size; pc++) {
+        const ProgramInstr &instr = program.code_[pc];
+        if (IsBranch(instr.code_)) {
+            leader[instr.target_] = true;
+            if (instr.code_ != OpCode::JMP) {
+                leader[instr.alt_] = true;
+            }
+            leader[pc + 1] = true;
+        }
+    }
+    for (int pc = 0; pc < size; pc++) {
+        if (!leader[pc]) {
+            continue;
+        }
+        if (!current_.empty()) {
+            current_.back().end_ = pc;
+        }
+        block_of_[pc] = static_cast<int>(current_.size());
+        current_.push_back(BlockProfile{ pc });
+    }
+    if (!current_.empty()) {
+        current_.back().end_ = size;
+    }
+}
+
+// Folds the counts of the program that just ran into the totals.
+void Profiler::Flush() {
+    if (program_ == nullptr) {
+        return;
+    }
+    if (timed_block_ >= 0) {
+        StopTiming();
+    }
+    for (size_t pc = 0; pc < counts_.size(); pc++) {
+        const ProgramInstr &instr = program_->code_[pc];
+        opcode_counts_[instr.code_] += counts_[pc];
+        line_counts_[instr.line_] += counts_[pc];
+        total_instrs_ += counts_[pc];
+    }
+    // Inside a block the next instruction only runs after this one;
+    // unconditional jumps always reach their target. Pairs across
+    // conditional branches are not attributed.
+    int size = static_cast<int>(counts_.size());
+    for (int pc = 0; pc < size; pc++) {
+        const ProgramInstr &instr = program_->code_[pc];
+        if (instr.code_ == OpCode::JMP) {
+            if (instr.target_ < size) {
+                pair_counts_[{ instr.code_, program_->code_[instr.target_].code_ }] += counts_[pc];
+            }
+        } else if (pc + 1 < size && block_of_[pc + 1] < 0) {
+            pair_counts_[{ instr.code_, program_->code_[pc + 1].code_ }] += counts_[pc + 1];
+        }
+    }
+    for (auto &block : current_) {
+        block.executions_ = counts_[block.begin_];
+        block.first_line_ = program_->code_[block.begin_].line_;
+        block.last_line_ = program_->code_[block.end_ - 1].line_;
+        if (block.executions_ > 0) {
+            blocks_.push_back(block);
+        }
+    }
+    program_ = nullptr;
+}
+
+namespace {
+
+template <class Key>
+auto SortedByCount(const std::map<Key, uint64_t> &counts) -> std::vector<std::pair<Key, uint64_t>> {
+    std::vector<std::pair<Key, uint64_t>> sorted(counts.begin(), counts.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    return sorted;
+}
+
+auto Percent(double part, double total) -> double {
+    return total == 0 ? 0.0 : 100.0 * part / total;
+}
+
+} // namespace
+
+void Profiler::Report(std::ostream &out, size_t limit) const {
+    out << std::fixed << std::setprecision(1);
+    out << "== Opcodes (" << total_instrs_ << " instructions) ==\n";
+    auto opcodes = SortedByCount(opcode_counts_);
+    for (size_t i = 0; i < opcodes.size() && i < limit; i++) {
+        out << std::setw(14) << opcodes[i].second << std::setw(7) << Percent(opcodes[i].second, total_instrs_) << "%  "
+            << Instr(opcodes[i].first, 0, 0).ToString() << "\n";
+    }
+
+    out << "== Opcode pairs ==\n";
+    auto pairs = SortedByCount(pair_counts_);
+    for (size_t i = 0; i < pairs.size() && i < limit; i++) {
+        out << std::setw(14) << pairs[i].second << std::setw(7) << Percent(pairs[i].second, total_instrs_) << "%  "
+            << Instr(pairs[i].first.first, 0, 0).ToString() << " + " << Instr(pairs[i].first.second, 0, 0).ToString() << "\n";
+    }
+
+    out << "== Lines ==\n";
+    auto lines = SortedByCount(line_counts_);
+    for (size_t i = 0; i < lines.size() && i < limit; i++) {
+        out << std::setw(14) << lines[i].second << std::setw(7) << Percent(lines[i].second, total_instrs_) << "%  "
+            << "line " << lines[i].first << "\n";
+    }
+
+    out << "== Blocks (cycles sampled every " << _STRONK_PROFILE_SAMPLE_PERIOD << " block entries) ==\n";
+    std::vector<BlockProfile> blocks = blocks_;
+    std::stable_sort(blocks.begin(), blocks.end(), [](const auto &a, const auto &b) {
+        return a.EstimatedCycles() > b.EstimatedCycles();
+    });
+    double total_cycles = 0;
+    for (const auto &block : blocks) {
+        total_cycles += block.EstimatedCycles();
+    }
+    for (size_t i = 0; i < blocks.size() && i < limit; i++) {
+        const BlockProfile &block = blocks[i];
+        out << std::setw(14) << block.executions_ << std::setw(7) << Percent(block.EstimatedCycles(), total_cycles) << "%  "
+            << "[" << block.begin_ << ", " << block.end_ << ") lines " << block.first_line_ << "-" << block.last_line_
+            << ", " << block.AverageCycles() << " cycles/entry\n";
+    }
+    out << std::defaultfloat;
+}
+
+} // namespace "stronk"
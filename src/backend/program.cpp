@@ -0,0 +1,416 @@
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <variant>
+#include "backend/optimizer.h"
+#include "backend/program.h"
+#include "backend/verifier.h"
+#include "common/mem_stats.h"
+
+namespace stronk {
+
+namespace {
+
+// Assigns register slots to addresses: globals first, block locals
+// and temporaries afterwards.
+class RegisterAllocator {
+public:
+    void Collect(const Address &address) {
+        if (slots_.find(address) != slots_.end()) {
+            return;
+        }
+        slots_[address] = -1;
+        if (address.rfind(TEMP_VAR_PREFIX, 0) == 0 || address.rfind(LOCAL_VAR_PREFIX, 0) == 0) {
+            temps_.push_back(address);
+        } else {
+            globals_.push_back(address);
+        }
+    }
+
+    void Assign(Program &program) {
+        int next = 0;
+        for (const auto &name : globals_) {
+            slots_[name] = next++;
+        }
+        for (const auto &name : temps_) {
+            slots_[name] = next++;
+        }
+        program.globals_ = globals_;
+        program.num_registers_ = next;
+    }
+
+    auto Slot(const Address &address) const -> int {
+        return slots_.at(address);
+    }
+private:
+    std::unordered_map<Address, int> slots_;
+    std::vector<Address> globals_;
+    std::vector<Address> temps_;
+};
+
+auto ResolveLabel(const std::unordered_map<Label, int> &labels, const Label &label) -> int {
+    auto it = labels.find(label);
+    if (it == labels.end()) {
+        throw std::invalid_argument("Jump to undefined label '" + label + "'.");
+    }
+    return it->second;
+}
+
+// Immediate form of the binary instruction `code` when its constant
+// is the second operand, or the first if `swapped`.
+auto ImmediateForm(OpCode code, bool swapped) -> std::optional<OpCode> {
+    switch (code) {
+        case OpCode::ADD: return OpCode::ADDI;
+        case OpCode::MULT: return OpCode::MULTI;
+        case OpCode::EQ: return OpCode::EQI;
+        case OpCode::NEQ: return OpCode::NEQI;
+        case OpCode::GT: return swapped ? OpCode::LTI : OpCode::GTI;
+        case OpCode::LT: return swapped ? OpCode::GTI : OpCode::LTI;
+        case OpCode::GEQ: return swapped ? OpCode::LEQI : OpCode::GEQI;
+        case OpCode::LEQ: return swapped ? OpCode::GEQI : OpCode::LEQI;
+        case OpCode::FADD: return OpCode::FADDI;
+        case OpCode::FMULT: return OpCode::FMULTI;
+        case OpCode::FEQ: return OpCode::FEQI;
+        case OpCode::FNEQ: return OpCode::FNEQI;
+        case OpCode::FGT: return swapped ? OpCode::FLTI : OpCode::FGTI;
+        case OpCode::FLT: return swapped ? OpCode::FGTI : OpCode::FLTI;
+        case OpCode::FGEQ: return swapped ? OpCode::FLEQI : OpCode::FGEQI;
+        case OpCode::FLEQ: return swapped ? OpCode::FGEQI : OpCode::FLEQI;
+        case OpCode::SUB: return swapped ? std::nullopt : std::optional(OpCode::SUBI);
+        case OpCode::FSUB: return swapped ? std::nullopt : std::optional(OpCode::FSUBI);
+        case OpCode::FDIV: return swapped ? std::nullopt : std::optional(OpCode::FDIVI);
+        default: return std::nullopt;
+    }
+}
+
+// Encodes `constant` as the immediate of `form`, if its type is the
+// one the instruction reads.
+auto EncodeImmediate(OpCode form, const ConstantPool::ConstantValue &constant) -> std::optional<int> {
+    switch (form) {
+        case OpCode::FADDI:
+        case OpCode::FSUBI:
+        case OpCode::FMULTI:
+        case OpCode::FDIVI:
+        case OpCode::FEQI:
+        case OpCode::FNEQI:
+        case OpCode::FGTI:
+        case OpCode::FLTI:
+        case OpCode::FGEQI:
+        case OpCode::FLEQI:
+            if (auto f = std::get_if<float>(&constant)) {
+                return EncodeReal(*f);
+            }
+            return std::nullopt;
+        default:
+            if (auto i = std::get_if<int>(&constant)) {
+                return *i;
+            }
+            return std::nullopt;
+    }
+}
+
+// Drops the LABEL no-ops left by the passes, retargets jumps, and
+// renumbers the registers and constants still referenced. Globals
+// keep their slots.
+void Compact(Program &program) {
+    int size = static_cast<int>(program.code_.size());
+    std::vector<int> new_index(size + 1);
+    int kept = 0;
+    for (int pc = 0; pc < size; pc++) {
+        new_index[pc] = kept;
+        kept += program.code_[pc].code_ == OpCode::LABEL ? 0 : 1;
+    }
+    new_index[size] = kept;
+
+    int num_globals = static_cast<int>(program.globals_.size());
+    std::vector<int> new_slot(program.num_registers_, -1);
+    std::vector<int> new_constant(program.constants_.size(), -1);
+    for (int slot = 0; slot < num_globals; slot++) {
+        new_slot[slot] = slot;
+    }
+    int next_slot = num_globals;
+    int next_constant = 0;
+    auto renumber = [&](int &slot) {
+        if (new_slot[slot] < 0) {
+            new_slot[slot] = next_slot++;
+        }
+        slot = new_slot[slot];
+    };
+    for (int &slot : program.operands_) {
+        renumber(slot);
+    }
+
+    std::vector<ProgramInstr> code;
+    std::vector<ConstantPool::ConstantValue> constants;
+    code.reserve(kept);
+    for (int pc = 0; pc < size; pc++) {
+        if (program.code_[pc].code_ == OpCode::LABEL) {
+            continue;
+        }
+        ProgramInstr instr = program.code_[pc];
+        ForEachRegister(instr, renumber);
+        if (instr.code_ == OpCode::CONST) {
+            if (new_constant[instr.a_] < 0) {
+                new_constant[instr.a_] = next_constant++;
+                constants.push_back(std::move(program.constants_[instr.a_]));
+            }
+            instr.a_ = new_constant[instr.a_];
+        }
+        if (instr.target_ >= 0) {
+            instr.target_ = new_index[instr.target_];
+        }
+        if (instr.alt_ >= 0) {
+            instr.alt_ = new_index[instr.alt_];
+        }
+        code.push_back(instr);
+    }
+    program.code_ = std::move(code);
+    program.constants_ = std::move(constants);
+    program.num_registers_ = next_slot;
+}
+
+// Turns constants used once into immediate operands. A CONST is
+// folded when its register has no other definition and its only
+// use is a binary instruction later in the same block; the CONST
+// becomes a LABEL no-op.
+void FoldImmediates(Program &program) {
+    int size = static_cast<int>(program.code_.size());
+    std::vector<int> defs(program.num_registers_, 0);
+    std::vector<int> uses(program.num_registers_, 0);
+    std::vector<int> const_at(program.num_registers_, -1);
+    std::vector<bool> is_target(size + 1, false);
+
+    for (int pc = 0; pc < size; pc++) {
+        ProgramInstr &instr = program.code_[pc];
+        if (instr.target_ >= 0) {
+            is_target[instr.target_] = true;
+        }
+        if (instr.alt_ >= 0) {
+            is_target[instr.alt_] = true;
+        }
+        if (instr.code_ == OpCode::PRINT) {
+            for (int i = 0; i < instr.b_; i++) {
+                uses[program.operands_[instr.a_ + i]]++;
+            }
+        }
+        ForEachRegister(instr, [&](int &slot) {
+            if (&slot == &instr.dest_) {
+                defs[slot]++;
+            } else {
+                uses[slot]++;
+            }
+        });
+        if (instr.code_ == OpCode::CONST) {
+            const_at[instr.dest_] = pc;
+        }
+    }
+
+    // Blocks are numbered so that "same block" is one comparison.
+    std::vector<int> block(size, 0);
+    for (int pc = 0, current = 0; pc < size; pc++) {
+        if (is_target[pc]) {
+            current++;
+        }
+        block[pc] = current;
+        if (program.code_[pc].code_ == OpCode::JMP || program.code_[pc].code_ == OpCode::BR) {
+            current++;
+        }
+    }
+
+    auto foldable = [&](int slot, int pc) {
+        int def = const_at[slot];
+        return def >= 0 && def < pc && defs[slot] == 1 && uses[slot] == 1 && block[def] == block[pc];
+    };
+    for (int pc = 0; pc < size; pc++) {
+        ProgramInstr &instr = program.code_[pc];
+        if (instr.a_ < 0 || instr.b_ < 0 || instr.dest_ < 0) {
+            continue;
+        }
+        for (bool swapped : { false, true }) {
+            int slot = swapped ? instr.a_ : instr.b_;
+            std::optional<OpCode> form = ImmediateForm(instr.code_, swapped);
+            if (!form.has_value() || !foldable(slot, pc)) {
+                continue;
+            }
+            int def = const_at[slot];
+            std::optional<int> imm = EncodeImmediate(*form, program.constants_[program.code_[def].a_]);
+            if (!imm.has_value()) {
+                continue;
+            }
+            if (swapped) {
+                instr.a_ = instr.b_;
+            }
+            instr.code_ = *form;
+            instr.b_ = *imm;
+            program.code_[def] = ProgramInstr{ OpCode::LABEL };
+            break;
+        }
+    }
+}
+
+} // namespace
+
+auto HasImmediate(OpCode code) -> bool {
+    switch (code) {
+        case OpCode::ADDI:
+        case OpCode::SUBI:
+        case OpCode::MULTI:
+        case OpCode::EQI:
+        case OpCode::NEQI:
+        case OpCode::GTI:
+        case OpCode::LTI:
+        case OpCode::GEQI:
+        case OpCode::LEQI:
+        case OpCode::FADDI:
+        case OpCode::FSUBI:
+        case OpCode::FMULTI:
+        case OpCode::FDIVI:
+        case OpCode::FEQI:
+        case OpCode::FNEQI:
+        case OpCode::FGTI:
+        case OpCode::FLTI:
+        case OpCode::FGEQI:
+        case OpCode::FLEQI:
+        case OpCode::BEQI:
+        case OpCode::BNEQI:
+        case OpCode::BGTI:
+        case OpCode::BLTI:
+        case OpCode::BGEQI:
+        case OpCode::BLEQI:
+        case OpCode::INCBLTI:
+        case OpCode::INCBLEQI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+auto IsBranch(OpCode code) -> bool {
+    switch (code) {
+        case OpCode::JMP:
+        case OpCode::BR:
+        case OpCode::BEQ:
+        case OpCode::BNEQ:
+        case OpCode::BGT:
+        case OpCode::BLT:
+        case OpCode::BGEQ:
+        case OpCode::BLEQ:
+        case OpCode::BEQI:
+        case OpCode::BNEQI:
+        case OpCode::BGTI:
+        case OpCode::BLTI:
+        case OpCode::BGEQI:
+        case OpCode::BLEQI:
+        case OpCode::INCBLT:
+        case OpCode::INCBLEQ:
+        case OpCode::INCBLTI:
+        case OpCode::INCBLEQI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Lowers bytecode into a program. Labels disappear and every
+// jump refers to the index of the instruction that followed its
+// label. Redundant conversions are removed, constants used once
+// become immediate operands, copies
+// are coalesced into the instruction computing their source and
+// frequent pairs are fused into superinstructions. The result is
+// verified; invalid bytecode throws std::invalid_argument.
+auto LowerBytecode(const Bytecode &bytecode, const ConstantPool &constant_pool) -> Program {
+    // Lowering is accounted to the VM, which owns its result.
+    MemPhaseScope scope(MemPhase::VM);
+    Program program;
+    RegisterAllocator registers;
+    std::unordered_map<Label, int> labels;
+
+    // First pass: find label positions and every address used.
+    int index = 0;
+    for (const auto &instr : bytecode) {
+        if (auto label = dynamic_cast<const LabelInstr *>(instr.get())) {
+            labels[label->label_] = index;
+            continue;
+        }
+        if (auto pure = dynamic_cast<const PureInstr *>(instr.get())) {
+            registers.Collect(pure->dest_);
+            for (const auto &arg : pure->args_) {
+                registers.Collect(arg);
+            }
+        } else if (auto impure = dynamic_cast<const ImpureInstr *>(instr.get())) {
+            for (const auto &arg : impure->args_) {
+                registers.Collect(arg);
+            }
+        } else if (auto constant = dynamic_cast<const ConstInstr *>(instr.get())) {
+            registers.Collect(constant->dest_);
+        } else {
+            throw std::invalid_argument("Unsupported instruction " + instr->ToString() + ".");
+        }
+        index++;
+    }
+    registers.Assign(program);
+
+    // Second pass: emit lowered instructions. Only constants the
+    // bytecode references are copied, so programs compiled from a
+    // long lived constant pool (the REPL) stay small.
+    std::unordered_map<int, int> constant_slots;
+    program.code_.reserve(index);
+    for (const auto &instr : bytecode) {
+        ProgramInstr lowered;
+        lowered.code_ = instr->code_;
+        lowered.line_ = instr->line_;
+
+        if (instr->code_ == OpCode::LABEL) {
+            continue;
+        }
+        if (auto pure = dynamic_cast<const PureInstr *>(instr.get())) {
+            lowered.dest_ = registers.Slot(pure->dest_);
+            if (!pure->args_.empty()) {
+                lowered.a_ = registers.Slot(pure->args_[0]);
+            }
+            if (pure->args_.size() > 1) {
+                lowered.b_ = registers.Slot(pure->args_[1]);
+            }
+        } else if (auto constant = dynamic_cast<const ConstInstr *>(instr.get())) {
+            lowered.dest_ = registers.Slot(constant->dest_);
+            auto [it, inserted] = constant_slots.try_emplace(constant->index_, static_cast<int>(program.constants_.size()));
+            if (inserted) {
+                program.constants_.push_back(constant_pool.GetConstant(constant->index_));
+            }
+            lowered.a_ = it->second;
+        } else if (auto impure = dynamic_cast<const ImpureInstr *>(instr.get())) {
+            switch (impure->code_) {
+                case OpCode::JMP:
+                    lowered.target_ = ResolveLabel(labels, impure->labels_.at(0));
+                    break;
+                case OpCode::BR:
+                    lowered.a_ = registers.Slot(impure->args_.at(0));
+                    lowered.target_ = ResolveLabel(labels, impure->labels_.at(0));
+                    lowered.alt_ = ResolveLabel(labels, impure->labels_.at(1));
+                    break;
+                default:
+                    lowered.a_ = static_cast<int>(program.operands_.size());
+                    lowered.b_ = static_cast<int>(impure->args_.size());
+                    for (const auto &arg : impure->args_) {
+                        program.operands_.push_back(registers.Slot(arg));
+                    }
+                    break;
+            }
+        }
+        program.code_.push_back(lowered);
+    }
+    EliminateConversions(program);
+    FoldImmediates(program);
+    CoalesceCopies(program, 0, static_cast<int>(program.code_.size()));
+    Compact(program);
+    ThreadBranches(program);
+    SelectSuperinstructions(program);
+    Compact(program);
+    if (auto error = VerifyProgram(program)) {
+        throw std::invalid_argument(*error);
+    }
+    program.verified_ = true;
+    return program;
+}
+
+} // namespace "stronk"
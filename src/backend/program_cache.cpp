@@ -0,0 +1,268 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include "backend/program_cache.h"
+#include "backend/verifier.h"
+
+namespace stronk {
+
+namespace {
+
+const char MAGIC[8] = { 'S', 'T', 'R', 'K', 'B', 'C', '0', '1' };
+
+struct CacheHeader {
+    char magic_[8];
+    uint32_t compiler_version_;
+    uint32_t instr_size_;
+    uint64_t source_hash_;
+    uint32_t num_registers_;
+    uint32_t code_count_;
+    uint32_t operand_count_;
+    uint32_t constant_count_;
+    uint32_t global_count_;
+    uint32_t reserved_;
+};
+
+static_assert(std::is_trivially_copyable_v<ProgramInstr>, "Instructions are stored as raw bytes.");
+
+enum class ConstantTag : uint8_t {
+    INT,
+    REAL,
+    CHAR,
+    BOOL,
+    STRING
+};
+
+class Writer {
+public:
+    template <class T>
+    void Put(const T &val) {
+        out_.append(reinterpret_cast<const char *>(&val), sizeof(T));
+    }
+    void PutBytes(const void *data, size_t size) {
+        out_.append(static_cast<const char *>(data), size);
+    }
+    void PutString(const std::string &str) {
+        Put<uint32_t>(static_cast<uint32_t>(str.size()));
+        PutBytes(str.data(), str.size());
+    }
+    auto Take() -> std::string { return std::move(out_); }
+private:
+    std::string out_;
+};
+
+// Bounds checked reader over a mapped entry.
+class Reader {
+public:
+    Reader(const char *data, size_t size) : data_(data), size_(size) {}
+
+    template <class T>
+    auto Get(T &val) -> bool {
+        return GetBytes(&val, sizeof(T));
+    }
+    auto GetBytes(void *dest, size_t size) -> bool {
+        if (size > size_ - offset_) {
+            return false;
+        }
+        std::memcpy(dest, data_ + offset_, size);
+        offset_ += size;
+        return true;
+    }
+    auto GetString(std::string &str) -> bool {
+        uint32_t size;
+        if (!Get(size) || size > size_ - offset_) {
+            return false;
+        }
+        str.assign(data_ + offset_, size);
+        offset_ += size;
+        return true;
+    }
+    auto AtEnd() const -> bool { return offset_ == size_; }
+private:
+    const char *data_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+} // namespace
+
+auto HashSource(std::string_view source) -> uint64_t {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : source) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+auto SerializeProgram(const Program &program, uint64_t source_hash) -> std::string {
+    CacheHeader header = {};
+    std::memcpy(header.magic_, MAGIC, sizeof(MAGIC));
+    header.compiler_version_ = _STRONK_COMPILER_VERSION;
+    header.instr_size_ = sizeof(ProgramInstr);
+    header.source_hash_ = source_hash;
+    header.num_registers_ = static_cast<uint32_t>(program.num_registers_);
+    header.code_count_ = static_cast<uint32_t>(program.code_.size());
+    header.operand_count_ = static_cast<uint32_t>(program.operands_.size());
+    header.constant_count_ = static_cast<uint32_t>(program.constants_.size());
+    header.global_count_ = static_cast<uint32_t>(program.globals_.size());
+
+    Writer writer;
+    writer.Put(header);
+    writer.PutBytes(program.code_.data(), program.code_.size() * sizeof(ProgramInstr));
+    writer.PutBytes(program.operands_.data(), program.operands_.size() * sizeof(int));
+    for (const auto &constant : program.constants_) {
+        if (auto i = std::get_if<int>(&constant)) {
+            writer.Put(ConstantTag::INT);
+            writer.Put(*i);
+        } else if (auto f = std::get_if<float>(&constant)) {
+            writer.Put(ConstantTag::REAL);
+            writer.Put(*f);
+        } else if (auto c = std::get_if<char>(&constant)) {
+            writer.Put(ConstantTag::CHAR);
+            writer.Put(*c);
+        } else if (auto b = std::get_if<bool>(&constant)) {
+            writer.Put(ConstantTag::BOOL);
+            writer.Put(*b);
+        } else {
+            writer.Put(ConstantTag::STRING);
+            writer.PutString(std::get<std::string>(constant));
+        }
+    }
+    for (const auto &name : program.globals_) {
+        writer.PutString(name);
+    }
+    return writer.Take();
+}
+
+// Returns nothing when the entry is truncated, corrupt or was
+// written by another compiler version or for another source.
+auto DeserializeProgram(const char *data, size_t size, uint64_t source_hash) -> std::optional<Program> {
+    Reader reader(data, size);
+    CacheHeader header;
+    if (!reader.Get(header) || std::memcmp(header.magic_, MAGIC, sizeof(MAGIC)) != 0
+        || header.compiler_version_ != _STRONK_COMPILER_VERSION || header.instr_size_ != sizeof(ProgramInstr)
+        || header.source_hash_ != source_hash) {
+        return std::nullopt;
+    }
+    if (header.code_count_ > size / sizeof(ProgramInstr) || header.operand_count_ > size / sizeof(int)) {
+        return std::nullopt;
+    }
+
+    Program program;
+    program.num_registers_ = static_cast<int>(header.num_registers_);
+    program.code_.resize(header.code_count_);
+    program.operands_.resize(header.operand_count_);
+    if (!reader.GetBytes(program.code_.data(), header.code_count_ * sizeof(ProgramInstr))
+        || !reader.GetBytes(program.operands_.data(), header.operand_count_ * sizeof(int))) {
+        return std::nullopt;
+    }
+
+    for (uint32_t i = 0; i < header.constant_count_; i++) {
+        ConstantTag tag;
+        if (!reader.Get(tag)) {
+            return std::nullopt;
+        }
+        bool ok = false;
+        switch (tag) {
+            case ConstantTag::INT: { int val; ok = reader.Get(val); program.constants_.emplace_back(val); break; }
+            case ConstantTag::REAL: { float val; ok = reader.Get(val); program.constants_.emplace_back(val); break; }
+            case ConstantTag::CHAR: { char val; ok = reader.Get(val); program.constants_.emplace_back(val); break; }
+            case ConstantTag::BOOL: { uint8_t val; ok = reader.Get(val); program.constants_.emplace_back(val != 0); break; }
+            case ConstantTag::STRING: { std::string val; ok = reader.GetString(val); program.constants_.emplace_back(val); break; }
+        }
+        if (!ok) {
+            return std::nullopt;
+        }
+    }
+    program.globals_.resize(header.global_count_);
+    for (auto &name : program.globals_) {
+        if (!reader.GetString(name)) {
+            return std::nullopt;
+        }
+    }
+    // Verification guards against corrupt entries sending the VM
+    // out of bounds.
+    if (!reader.AtEnd() || VerifyProgram(program)) {
+        return std::nullopt;
+    }
+    program.verified_ = true;
+    return program;
+}
+
+auto ProgramCache::DefaultDirectory() -> std::filesystem::path {
+    if (const char *dir = std::getenv("STRONK_CACHE_DIR")) {
+        return dir;
+    }
+    if (const char *dir = std::getenv("XDG_CACHE_HOME")) {
+        return std::filesystem::path(dir) / "stronk";
+    }
+    if (const char *home = std::getenv("HOME")) {
+        return std::filesystem::path(home) / ".cache" / "stronk";
+    }
+    return std::filesystem::temp_directory_path() / "stronk-cache";
+}
+
+auto ProgramCache::EntryPath(std::string_view source) const -> std::filesystem::path {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-v%d.sbc",
+                  static_cast<unsigned long long>(HashSource(source)), _STRONK_COMPILER_VERSION);
+    return directory_ / name;
+}
+
+auto ProgramCache::Load(std::string_view source) const -> std::optional<Program> {
+    std::string path = EntryPath(source).string();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return std::nullopt;
+    }
+    auto size = static_cast<size_t>(info.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return std::nullopt;
+    }
+    std::optional<Program> program = DeserializeProgram(static_cast<const char *>(data), size, HashSource(source));
+    munmap(data, size);
+    return program;
+}
+
+auto ProgramCache::Store(std::string_view source, const Program &program) const -> bool {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        return false;
+    }
+
+    std::filesystem::path path = EntryPath(source);
+    // Unique per writer, so concurrent stores of one entry (batch
+    // compiles) each rename a complete file.
+    static std::atomic<uint64_t> next_temp{0};
+    std::filesystem::path temp = path;
+    temp += "." + std::to_string(getpid()) + "." + std::to_string(next_temp++) + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary);
+        std::string image = SerializeProgram(program, HashSource(source));
+        out.write(image.data(), static_cast<std::streamsize>(image.size()));
+        if (!out) {
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, error);
+    return !error;
+}
+
+} // namespace "stronk"
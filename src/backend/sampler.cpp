@@ -0,0 +1,133 @@
+#include <algorithm>
+#include "backend/sampler.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STRONK_SAMPLING_ENABLED 1
+#include <csignal>
+#include <sys/time.h>
+#else
+#define STRONK_SAMPLING_ENABLED 0
+#endif
+
+namespace stronk {
+
+namespace {
+
+std::atomic<SamplingProfiler *> active_sampler{nullptr};
+
+#if STRONK_SAMPLING_ENABLED
+struct sigaction previous_action;
+#endif
+
+// Samples are the instruction index in the low 32 bits and the
+// native flag above it.
+constexpr uint64_t NATIVE_BIT = uint64_t(1) << 32;
+
+} // namespace
+
+SamplingProfiler::~SamplingProfiler() {
+    Stop();
+}
+
+auto SamplingProfiler::IsSupported() -> bool {
+    return STRONK_SAMPLING_ENABLED;
+}
+
+#if STRONK_SAMPLING_ENABLED
+
+// Installs the SIGPROF handler and arms the profiling timer, which
+// counts CPU time of the whole process.
+auto SamplingProfiler::Start(int hz) -> bool {
+    SamplingProfiler *expected = nullptr;
+    if (running_ || hz <= 0 || !active_sampler.compare_exchange_strong(expected, this)) {
+        return false;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = &SamplingProfiler::OnSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &previous_action) != 0) {
+        active_sampler.store(nullptr);
+        return false;
+    }
+
+    // tv_usec must stay below one second, so low rates carry whole
+    // seconds in tv_sec.
+    struct itimerval timer = {};
+    int period = std::max(1, 1000000 / hz);
+    timer.it_interval.tv_sec = period / 1000000;
+    timer.it_interval.tv_usec = period % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sigaction(SIGPROF, &previous_action, nullptr);
+        active_sampler.store(nullptr);
+        return false;
+    }
+    running_ = true;
+    return true;
+}
+
+void SamplingProfiler::Stop() {
+    if (!running_) {
+        return;
+    }
+    struct itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &previous_action, nullptr);
+    active_sampler.store(nullptr);
+    running_ = false;
+}
+
+#else
+
+auto SamplingProfiler::Start(int) -> bool {
+    return false;
+}
+
+void SamplingProfiler::Stop() {}
+
+#endif // STRONK_SAMPLING_ENABLED
+
+void SamplingProfiler::OnSignal(int) {
+    if (SamplingProfiler *sampler = active_sampler.load(std::memory_order_relaxed)) {
+        sampler->Record();
+    }
+}
+
+// Runs in the signal handler: async-signal-safe operations only.
+void SamplingProfiler::Record() {
+    int pc = pc_.load(std::memory_order_relaxed);
+    if (pc == IDLE) {
+        return;
+    }
+    bool native = native_.load(std::memory_order_relaxed);
+    ring_.Push(static_cast<uint32_t>(pc) | (native ? NATIVE_BIT : 0));
+}
+
+// Attributes buffered samples to `program`, which must be the
+// program the samples were taken in.
+void SamplingProfiler::Drain(const Program &program) {
+    uint64_t sample;
+    while (ring_.Pop(sample)) {
+        auto pc = static_cast<size_t>(sample & 0xffffffff);
+        std::string stack = "stronk";
+        if (pc < program.code_.size()) {
+            const ProgramInstr &instr = program.code_[pc];
+            stack += ";line " + std::to_string(instr.line_);
+            stack += (sample & NATIVE_BIT) != 0 ? std::string(";[jit]") : ";" + Instr(instr.code_, 0, 0).ToString();
+        }
+        stacks_[stack]++;
+        samples_++;
+    }
+}
+
+// One "frame;frame;frame count" line per distinct stack, as read
+// by flamegraph.pl and compatible tools.
+void SamplingProfiler::WriteCollapsed(std::ostream &out) const {
+    for (const auto &[stack, count] : stacks_) {
+        out << stack << " " << count << "\n";
+    }
+}
+
+} // namespace "stronk"
@@ -0,0 +1,311 @@
+#include <variant>
+#include <vector>
+#include "backend/verifier.h"
+#include "common/value.h"
+
+namespace stronk {
+
+namespace {
+
+auto ConstantType(const ConstantPool::ConstantValue &constant) -> ValueType {
+    if (std::holds_alternative<int>(constant)) {
+        return ValueType::INT;
+    }
+    if (std::holds_alternative<float>(constant)) {
+        return ValueType::REAL;
+    }
+    if (std::holds_alternative<char>(constant)) {
+        return ValueType::CHAR;
+    }
+    if (std::holds_alternative<bool>(constant)) {
+        return ValueType::BOOL;
+    }
+    return ValueType::OBJ;
+}
+
+// Tracks the type of every register while walking the program in
+// order. NIL stands for a type that is not known, which only globals
+// bound by earlier programs have.
+class Verifier {
+public:
+    explicit Verifier(const Program &program) : program_(program) {}
+
+    auto Run() -> std::optional<std::string> {
+        int globals = static_cast<int>(program_.globals_.size());
+        if (program_.num_registers_ < 0 || globals > program_.num_registers_) {
+            return "Frame has fewer registers than globals.";
+        }
+        types_.assign(program_.num_registers_, ValueType::NIL);
+        defined_.assign(program_.num_registers_, false);
+        for (int slot = 0; slot < globals; slot++) {
+            defined_[slot] = true;
+        }
+        for (int slot : program_.operands_) {
+            if (!IsRegister(slot)) {
+                return "Print operand out of range.";
+            }
+        }
+        for (pc_ = 0; pc_ < static_cast<int>(program_.code_.size()) && !error_; pc_++) {
+            Verify(program_.code_[pc_]);
+        }
+        return error_;
+    }
+private:
+    const Program &program_;
+    std::vector<ValueType> types_;
+    std::vector<bool> defined_;
+    int pc_ = 0;
+    std::optional<std::string> error_;
+
+    void Fail(std::string_view message) {
+        if (!error_) {
+            int line = program_.code_[pc_].line_;
+            error_ = "Instruction " + std::to_string(pc_) + " (line " + std::to_string(line) + "): "
+                     + std::string(message);
+        }
+    }
+
+    auto IsRegister(int slot) const -> bool {
+        return slot >= 0 && slot < program_.num_registers_;
+    }
+
+    // Checks a read of `slot` and returns its type. `expected` NIL
+    // accepts any type.
+    auto Read(int slot, ValueType expected) -> ValueType {
+        if (!IsRegister(slot)) {
+            Fail("Register " + std::to_string(slot) + " out of range.");
+            return ValueType::NIL;
+        }
+        if (!defined_[slot]) {
+            Fail("Register " + std::to_string(slot) + " is read before it is defined.");
+            return ValueType::NIL;
+        }
+        ValueType type = types_[slot];
+        if (expected != ValueType::NIL && type != ValueType::NIL && type != expected) {
+            Fail("Register " + std::to_string(slot) + " has the wrong type for this instruction.");
+        }
+        return type;
+    }
+
+    void Write(int slot, ValueType type) {
+        if (!IsRegister(slot)) {
+            Fail("Register " + std::to_string(slot) + " out of range.");
+            return;
+        }
+        if (types_[slot] == ValueType::NIL) {
+            types_[slot] = type;
+        } else if (type != ValueType::NIL && type != types_[slot]) {
+            Fail("Register " + std::to_string(slot) + " is redefined with another type.");
+        }
+        defined_[slot] = true;
+    }
+
+    void Target(int pc) {
+        // One past the end halts the program.
+        if (pc < 0 || pc > static_cast<int>(program_.code_.size())) {
+            Fail("Branch target out of range.");
+        }
+    }
+
+    void Unary(const ProgramInstr &instr, ValueType operand, ValueType result) {
+        Read(instr.a_, operand);
+        Write(instr.dest_, result);
+    }
+
+    void Binary(const ProgramInstr &instr, ValueType operand, ValueType result) {
+        Read(instr.a_, operand);
+        Read(instr.b_, operand);
+        Write(instr.dest_, result);
+    }
+
+    // Equality compares the raw bits of ints, bools, chars and
+    // objects, so its operands only need to share a type that is not
+    // real; reals have FEQ. Immediate forms compare with an int.
+    void Equality(const ProgramInstr &instr) {
+        ValueType type = Read(instr.a_, ValueType::NIL);
+        if (!HasImmediate(instr.code_)) {
+            Read(instr.b_, type);
+        }
+        if (type == ValueType::REAL) {
+            Fail("Reals are compared with FEQ and FNEQ.");
+        }
+    }
+
+    // Compare-and-branch forms; INC forms also step their counter.
+    void Branch(const ProgramInstr &instr) {
+        Read(instr.a_, ValueType::INT);
+        if (!HasImmediate(instr.code_)) {
+            Read(instr.b_, ValueType::INT);
+        }
+        Target(instr.target_);
+        Target(instr.alt_);
+    }
+
+    void Verify(const ProgramInstr &instr) {
+        switch (instr.code_) {
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MULT:
+            case OpCode::DIV:
+                Binary(instr, ValueType::INT, ValueType::INT);
+                break;
+            case OpCode::NEG:
+            case OpCode::ADDI:
+            case OpCode::SUBI:
+            case OpCode::MULTI:
+                Unary(instr, ValueType::INT, ValueType::INT);
+                break;
+            case OpCode::FADD:
+            case OpCode::FSUB:
+            case OpCode::FMULT:
+            case OpCode::FDIV:
+                Binary(instr, ValueType::REAL, ValueType::REAL);
+                break;
+            case OpCode::FNEG:
+            case OpCode::FADDI:
+            case OpCode::FSUBI:
+            case OpCode::FMULTI:
+            case OpCode::FDIVI:
+                Unary(instr, ValueType::REAL, ValueType::REAL);
+                break;
+            case OpCode::MADD:
+            case OpCode::FMADD: {
+                ValueType type = instr.code_ == OpCode::MADD ? ValueType::INT : ValueType::REAL;
+                Read(instr.a_, type);
+                Read(instr.b_, type);
+                Read(instr.c_, type);
+                Write(instr.dest_, type);
+                break;
+            }
+
+            case OpCode::EQ:
+            case OpCode::NEQ:
+            case OpCode::EQI:
+            case OpCode::NEQI:
+                Equality(instr);
+                Write(instr.dest_, ValueType::BOOL);
+                break;
+            case OpCode::GT:
+            case OpCode::LT:
+            case OpCode::GEQ:
+            case OpCode::LEQ:
+                Binary(instr, ValueType::INT, ValueType::BOOL);
+                break;
+            case OpCode::GTI:
+            case OpCode::LTI:
+            case OpCode::GEQI:
+            case OpCode::LEQI:
+                Unary(instr, ValueType::INT, ValueType::BOOL);
+                break;
+            case OpCode::FEQ:
+            case OpCode::FNEQ:
+            case OpCode::FGT:
+            case OpCode::FLT:
+            case OpCode::FGEQ:
+            case OpCode::FLEQ:
+                Binary(instr, ValueType::REAL, ValueType::BOOL);
+                break;
+            case OpCode::FEQI:
+            case OpCode::FNEQI:
+            case OpCode::FGTI:
+            case OpCode::FLTI:
+            case OpCode::FGEQI:
+            case OpCode::FLEQI:
+                Unary(instr, ValueType::REAL, ValueType::BOOL);
+                break;
+
+            case OpCode::F2I:
+                Unary(instr, ValueType::REAL, ValueType::INT);
+                break;
+            case OpCode::I2F:
+                Unary(instr, ValueType::INT, ValueType::REAL);
+                break;
+
+            // Logical on bools, bitwise on ints.
+            case OpCode::NOT: {
+                ValueType type = Read(instr.a_, ValueType::NIL);
+                if (type != ValueType::NIL && type != ValueType::BOOL && type != ValueType::INT) {
+                    Fail("NOT takes a bool or an int.");
+                }
+                Write(instr.dest_, type);
+                break;
+            }
+            case OpCode::AND:
+            case OpCode::OR:
+            case OpCode::XOR:
+                Binary(instr, ValueType::BOOL, ValueType::BOOL);
+                break;
+
+            case OpCode::LABEL:
+                break;
+            case OpCode::JMP:
+                Target(instr.target_);
+                break;
+            case OpCode::BR:
+                Read(instr.a_, ValueType::BOOL);
+                Target(instr.target_);
+                Target(instr.alt_);
+                break;
+            case OpCode::BEQ:
+            case OpCode::BNEQ:
+            case OpCode::BEQI:
+            case OpCode::BNEQI:
+                Equality(instr);
+                Target(instr.target_);
+                Target(instr.alt_);
+                break;
+            case OpCode::BGT:
+            case OpCode::BLT:
+            case OpCode::BGEQ:
+            case OpCode::BLEQ:
+            case OpCode::BGTI:
+            case OpCode::BLTI:
+            case OpCode::BGEQI:
+            case OpCode::BLEQI:
+                Branch(instr);
+                break;
+            case OpCode::INCBLT:
+            case OpCode::INCBLEQ:
+            case OpCode::INCBLTI:
+            case OpCode::INCBLEQI:
+                if (instr.dest_ != instr.a_) {
+                    Fail("Counter branches write their counter.");
+                }
+                Branch(instr);
+                break;
+
+            case OpCode::ID:
+                Write(instr.dest_, Read(instr.a_, ValueType::NIL));
+                break;
+            case OpCode::PRINT:
+                if (instr.a_ < 0 || instr.b_ < 0
+                    || instr.a_ + instr.b_ > static_cast<int>(program_.operands_.size())) {
+                    Fail("Print operands out of range.");
+                    break;
+                }
+                for (int i = 0; i < instr.b_; i++) {
+                    Read(program_.operands_[instr.a_ + i], ValueType::NIL);
+                }
+                break;
+            case OpCode::CONST:
+                if (instr.a_ < 0 || instr.a_ >= static_cast<int>(program_.constants_.size())) {
+                    Fail("Constant index out of range.");
+                    break;
+                }
+                Write(instr.dest_, ConstantType(program_.constants_[instr.a_]));
+                break;
+
+            default:
+                Fail("Unsupported instruction.");
+                break;
+        }
+    }
+};
+
+} // namespace
+
+auto VerifyProgram(const Program &program) -> std::optional<std::string> {
+    return Verifier(program).Run();
+}
+
+} // namespace "stronk"
@@ -1,11 +1,576 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include "backend/verifier.h"
 #include "backend/vm.h"
+#include "common/mem_stats.h"
 
 namespace stronk {
 
-// Interprets the given bytecode.
-auto VirtualMachine::Interpret(Bytecode &bytecode) -> bool {
-    bytecode_ = bytecode;
-    return false;
+// Integer arithmetic wraps instead of invoking undefined behavior.
+static auto WrapAdd(int a, int b) -> int { return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b)); }
+static auto WrapSub(int a, int b) -> int { return static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b)); }
+static auto WrapMult(int a, int b) -> int { return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b)); }
+
+VirtualMachine::VirtualMachine(std::ostream &out) : out_(&out) {
+    heap_.SetRootMarker([this](Heap &heap) { MarkRoots(heap); });
+}
+
+// Selects how programs are executed. The JIT silently falls back
+// to the interpreter on hosts it does not support.
+void VirtualMachine::SetEngine(ExecutionEngine engine) {
+    engine_ = engine;
+}
+
+// Number of back-edges a loop takes in the interpreter before it
+// is compiled in tiered mode.
+void VirtualMachine::SetTierUpThreshold(uint32_t threshold) {
+    tier_up_threshold_ = std::max<uint32_t>(threshold, 1);
+}
+
+// Publishes the executing instruction to `sampler` while programs
+// run. Pass nullptr to stop.
+void VirtualMachine::SetSampler(SamplingProfiler *sampler) {
+    sampler_ = sampler;
+}
+
+// Records executed instructions and register writes in `tracer`
+// when those categories are enabled. Tracing execution keeps
+// programs in the interpreter. Pass nullptr to stop.
+void VirtualMachine::SetTracer(Tracer *tracer) {
+    tracer_ = tracer;
+}
+
+// Counts every instruction the interpreter dispatches. Counting
+// keeps the whole program in the interpreter, so the total does not
+// depend on the engine.
+void VirtualMachine::SetCountInstructions(bool count) {
+    count_instructions_ = count;
+}
+
+// Stops each program with a runtime error once it has dispatched
+// `limit` instructions; 0 means no limit. The limit is enforced by
+// the counting interpreter, so limited programs never run compiled.
+void VirtualMachine::SetInstructionLimit(uint64_t limit) {
+    instruction_limit_ = limit;
+}
+
+// Lowers the module and runs it.
+auto VirtualMachine::Interpret(Module module) -> InterpretResult {
+    Program program;
+    try {
+        program = LowerBytecode(module.code_, module.constants_);
+    } catch (const std::exception &e) {
+        std::cerr << "Invalid bytecode: " << e.what() << "\n";
+        return InterpretResult::COMPILE_ERROR;
+    }
+    // Only the lowered program is needed from here on.
+    module = Module();
+    return Execute(std::move(program));
+}
+
+// Runs an already lowered program, e.g. one loaded from the
+// program cache. Programs that did not come from LowerBytecode or
+// the cache are verified first.
+auto VirtualMachine::Execute(Program program) -> InterpretResult {
+    MemPhaseScope scope(MemPhase::VM);
+    if (!program.verified_) {
+        if (auto error = VerifyProgram(program)) {
+            std::cerr << "Invalid bytecode: " << *error << "\n";
+            return InterpretResult::COMPILE_ERROR;
+        }
+        program.verified_ = true;
+    }
+    program_ = std::move(program);
+    LoadConstants();
+#if STRONK_VM_PROFILE
+    profiler_.Reset(program_);
+#endif
+
+    // Bind the program's named variables to the globals table.
+    registers_.assign(program_.num_registers_, Value{});
+    for (size_t i = 0; i < program_.globals_.size(); i++) {
+        if (auto it = globals_.find(program_.globals_[i]); it != globals_.end()) {
+            registers_[i] = it->second;
+        }
+    }
+
+    if (engine_ == ExecutionEngine::TIERED) {
+        backedge_counts_.assign(program_.code_.size(), 0);
+        osr_code_.clear();
+        osr_code_.resize(program_.code_.size());
+    }
+
+    bool trace_execution = tracer_ != nullptr
+        && (tracer_->IsEnabled(TraceCategory::INSTRUCTIONS) || tracer_->IsEnabled(TraceCategory::REGISTERS));
+
+    std::optional<InterpretResult> compiled;
+    bool count = count_instructions_ || instruction_limit_ != 0;
+    if (engine_ == ExecutionEngine::JIT && !trace_execution && !count) {
+        compiled = RunCompiled();
+    }
+    InterpretResult result;
+    if (compiled) {
+        result = *compiled;
+    } else if (sampler_ != nullptr || trace_execution || count) {
+        result = Run<true>();
+    } else {
+        result = Run<false>();
+    }
+    if (sampler_ != nullptr) {
+        sampler_->Leave();
+        sampler_->Drain(program_);
+    }
+#if STRONK_VM_PROFILE
+    profiler_.Flush();
+#endif
+
+    for (size_t i = 0; i < program_.globals_.size(); i++) {
+        globals_[program_.globals_[i]] = registers_[i];
+    }
+    registers_.clear();
+    osr_code_.clear();
+    return result;
+}
+
+auto VirtualMachine::GetGlobal(const std::string &name) const -> Value {
+    if (auto it = globals_.find(name); it != globals_.end()) {
+        return it->second;
+    }
+    return {};
+}
+
+auto VirtualMachine::GetHeap() -> Heap & {
+    return heap_;
+}
+
+auto VirtualMachine::GetHeapStats() const -> const HeapStats & {
+    return heap_.GetStats();
+}
+
+auto VirtualMachine::GetTieringStats() const -> const TieringStats & {
+    return tiering_stats_;
+}
+
+auto VirtualMachine::GetProfiler() const -> const Profiler & {
+    return profiler_;
+}
+
+auto VirtualMachine::GetInstructionsExecuted() const -> uint64_t {
+    return instructions_executed_;
+}
+
+// Roots are the current register frame, the globals table and
+// the constants of the running program.
+void VirtualMachine::MarkRoots(Heap &heap) {
+    for (const auto &val : registers_) {
+        heap.MarkValue(val);
+    }
+    for (const auto &[name, val] : globals_) {
+        heap.MarkValue(val);
+    }
+    for (const auto &val : constants_) {
+        heap.MarkValue(val);
+    }
+}
+
+// Converts the program's constant pool into runtime values.
+void VirtualMachine::LoadConstants() {
+    constants_.clear();
+    constants_.reserve(program_.constants_.size());
+    for (const auto &constant : program_.constants_) {
+        Value val;
+        if (auto i = std::get_if<int>(&constant)) {
+            val = Value::Int(*i);
+        } else if (auto f = std::get_if<float>(&constant)) {
+            val = Value::Real(*f);
+        } else if (auto c = std::get_if<char>(&constant)) {
+            val = Value::Char(*c);
+        } else if (auto b = std::get_if<bool>(&constant)) {
+            val = Value::Bool(*b);
+        } else if (auto s = std::get_if<std::string>(&constant)) {
+            val = Value::Object(heap_.AllocateString(*s));
+        }
+        constants_.push_back(val);
+    }
+}
+
+#define INT_BINARY(op) \
+    regs[instr.dest_] = Value::Int(op(regs[instr.a_].as_.int_, regs[instr.b_].as_.int_)); \
+    break
+
+#define REAL_BINARY(op) \
+    regs[instr.dest_] = Value::Real(regs[instr.a_].as_.real_ op regs[instr.b_].as_.real_); \
+    break
+
+#define INT_COMPARE(op) \
+    regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.int_ op regs[instr.b_].as_.int_); \
+    break
+
+#define REAL_COMPARE(op) \
+    regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.real_ op regs[instr.b_].as_.real_); \
+    break
+
+// Immediate forms read their second operand from b_ itself.
+#define INT_BINARY_IMM(op) \
+    regs[instr.dest_] = Value::Int(op(regs[instr.a_].as_.int_, instr.b_)); \
+    break
+
+#define REAL_BINARY_IMM(op) \
+    regs[instr.dest_] = Value::Real(regs[instr.a_].as_.real_ op DecodeReal(instr.b_)); \
+    break
+
+#define INT_COMPARE_IMM(op) \
+    regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.int_ op instr.b_); \
+    break
+
+#define REAL_COMPARE_IMM(op) \
+    regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.real_ op DecodeReal(instr.b_)); \
+    break
+
+// Once jumps to them are threaded, conditional branches close loops
+// too, so their back-edges drain the sampler and tier up like JMP.
+#define BRANCH(cond) { \
+        int next = (cond) ? instr.target_ : instr.alt_; \
+        if constexpr (INSTRUMENTED) { \
+            if (next < pc && sampler_ != nullptr && sampler_->ShouldDrain()) { \
+                sampler_->Drain(program_); \
+            } \
+        } \
+        pc = next < pc && tiered ? TakeBackEdge<INSTRUMENTED>(next, pc - 1) : next; \
+        if (pc < 0) { \
+            return InterpretResult::RUNTIME_ERROR; \
+        } \
+        break; \
+    }
+
+#define INT_BRANCH(op) BRANCH(regs[instr.a_].as_.int_ op regs[instr.b_].as_.int_)
+#define INT_BRANCH_IMM(op) BRANCH(regs[instr.a_].as_.int_ op instr.b_)
+
+// Adds the immediate c_ to the counter a_ and branches on it.
+#define COUNTER_BRANCH(op, limit) { \
+        int counter = WrapAdd(regs[instr.a_].as_.int_, instr.c_); \
+        regs[instr.a_] = Value::Int(counter); \
+        BRANCH(counter op (limit)); \
+    }
+
+// Follows the back-edge from `jump` to the loop header `header`,
+// entering the loop as compiled code once it is hot. Returns the
+// index to continue at, or -1 after a runtime error.
+template <bool INSTRUMENTED>
+auto VirtualMachine::TakeBackEdge(int header, int jump) -> int {
+    JitCode *osr = OnBackEdge(header, jump);
+    if (osr == nullptr) {
+        return header;
+    }
+    tiering_stats_.osr_entries_++;
+    if constexpr (INSTRUMENTED) {
+        if (sampler_ != nullptr) {
+            sampler_->EnterNative(header);
+        }
+    }
+    int next = osr->Entry()(registers_.data(), this);
+    if constexpr (INSTRUMENTED) {
+        if (sampler_ != nullptr) {
+            sampler_->Leave();
+        }
+    }
+    return next;
+}
+
+// Runs the loaded program. It was verified before, so handlers
+// read the union member their opcode family implies without
+// checking tags, registers or branch targets. The INSTRUMENTED instantiation
+// feeds the sampler, the execution tracer and the instruction
+// counter; the other one has no hooks at all.
+template <bool INSTRUMENTED>
+auto VirtualMachine::Run() -> InterpretResult {
+    const ProgramInstr *code = program_.code_.data();
+    const int size = static_cast<int>(program_.code_.size());
+    Value *regs = registers_.data();
+    int pc = 0;
+
+    const bool trace_instrs = INSTRUMENTED && tracer_ != nullptr && tracer_->IsEnabled(TraceCategory::INSTRUCTIONS);
+    const bool trace_regs = INSTRUMENTED && tracer_ != nullptr && tracer_->IsEnabled(TraceCategory::REGISTERS);
+    const bool count = INSTRUMENTED && (count_instructions_ || instruction_limit_ != 0);
+    const uint64_t limit = instruction_limit_ != 0 ? instructions_executed_ + instruction_limit_ : UINT64_MAX;
+    // Traced and counted programs stay in the interpreter.
+    const bool tiered = engine_ == ExecutionEngine::TIERED && !trace_instrs && !trace_regs && !count;
+
+    while (pc < size) {
+#if STRONK_VM_PROFILE
+        profiler_.OnInstr(pc);
+#endif
+        const ProgramInstr &instr = code[pc++];
+        if constexpr (INSTRUMENTED) {
+            instructions_executed_ += count;
+            if (instructions_executed_ > limit) {
+                RuntimeError(instr, "Instruction limit exceeded.");
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            if (sampler_ != nullptr) {
+                sampler_->Enter(pc - 1);
+            }
+            if (trace_instrs) {
+                tracer_->Instruction(pc - 1, instr.code_, instr.line_);
+            }
+        }
+        switch (instr.code_) {
+            case OpCode::ADD: INT_BINARY(WrapAdd);
+            case OpCode::SUB: INT_BINARY(WrapSub);
+            case OpCode::MULT: INT_BINARY(WrapMult);
+            case OpCode::DIV: {
+                int b = regs[instr.b_].as_.int_;
+                if (b == 0 || b == -1) {
+                    if (!ExecuteSlowPath(pc - 1)) {
+                        return InterpretResult::RUNTIME_ERROR;
+                    }
+                    break;
+                }
+                regs[instr.dest_] = Value::Int(regs[instr.a_].as_.int_ / b);
+                break;
+            }
+            case OpCode::NEG:
+                regs[instr.dest_] = Value::Int(WrapSub(0, regs[instr.a_].as_.int_));
+                break;
+
+            case OpCode::FADD: REAL_BINARY(+);
+            case OpCode::FSUB: REAL_BINARY(-);
+            case OpCode::FMULT: REAL_BINARY(*);
+            case OpCode::FDIV: REAL_BINARY(/);
+            case OpCode::FNEG:
+                regs[instr.dest_] = Value::Real(0.0f - regs[instr.a_].as_.real_);
+                break;
+
+            // Verified operands have equal, non-real types, and
+            // values zero the unused bytes of `as_`, so bools and
+            // chars compare as ints.
+            case OpCode::EQ: INT_COMPARE(==);
+            case OpCode::NEQ: INT_COMPARE(!=);
+            case OpCode::GT: INT_COMPARE(>);
+            case OpCode::LT: INT_COMPARE(<);
+            case OpCode::GEQ: INT_COMPARE(>=);
+            case OpCode::LEQ: INT_COMPARE(<=);
+
+            case OpCode::FEQ: REAL_COMPARE(==);
+            case OpCode::FNEQ: REAL_COMPARE(!=);
+            case OpCode::FGT: REAL_COMPARE(>);
+            case OpCode::FLT: REAL_COMPARE(<);
+            case OpCode::FGEQ: REAL_COMPARE(>=);
+            case OpCode::FLEQ: REAL_COMPARE(<=);
+
+            case OpCode::ADDI: INT_BINARY_IMM(WrapAdd);
+            case OpCode::SUBI: INT_BINARY_IMM(WrapSub);
+            case OpCode::MULTI: INT_BINARY_IMM(WrapMult);
+            case OpCode::EQI: INT_COMPARE_IMM(==);
+            case OpCode::NEQI: INT_COMPARE_IMM(!=);
+            case OpCode::GTI: INT_COMPARE_IMM(>);
+            case OpCode::LTI: INT_COMPARE_IMM(<);
+            case OpCode::GEQI: INT_COMPARE_IMM(>=);
+            case OpCode::LEQI: INT_COMPARE_IMM(<=);
+
+            case OpCode::FADDI: REAL_BINARY_IMM(+);
+            case OpCode::FSUBI: REAL_BINARY_IMM(-);
+            case OpCode::FMULTI: REAL_BINARY_IMM(*);
+            case OpCode::FDIVI: REAL_BINARY_IMM(/);
+            case OpCode::FEQI: REAL_COMPARE_IMM(==);
+            case OpCode::FNEQI: REAL_COMPARE_IMM(!=);
+            case OpCode::FGTI: REAL_COMPARE_IMM(>);
+            case OpCode::FLTI: REAL_COMPARE_IMM(<);
+            case OpCode::FGEQI: REAL_COMPARE_IMM(>=);
+            case OpCode::FLEQI: REAL_COMPARE_IMM(<=);
+
+            case OpCode::F2I:
+                regs[instr.dest_] = Value::Int(static_cast<int>(regs[instr.a_].as_.real_));
+                break;
+            case OpCode::I2F:
+                regs[instr.dest_] = Value::Real(static_cast<float>(regs[instr.a_].as_.int_));
+                break;
+
+            case OpCode::AND:
+                regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.bool_ && regs[instr.b_].as_.bool_);
+                break;
+            case OpCode::OR:
+                regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.bool_ || regs[instr.b_].as_.bool_);
+                break;
+            case OpCode::XOR:
+                regs[instr.dest_] = Value::Bool(regs[instr.a_].as_.bool_ != regs[instr.b_].as_.bool_);
+                break;
+
+            case OpCode::JMP:
+                if constexpr (INSTRUMENTED) {
+                    if (sampler_ != nullptr && sampler_->ShouldDrain()) {
+                        sampler_->Drain(program_);
+                    }
+                }
+                pc = instr.target_ < pc && tiered ? TakeBackEdge<INSTRUMENTED>(instr.target_, pc - 1) : instr.target_;
+                if (pc < 0) {
+                    return InterpretResult::RUNTIME_ERROR;
+                }
+                break;
+            case OpCode::BR:
+                pc = regs[instr.a_].as_.bool_ ? instr.target_ : instr.alt_;
+                break;
+            case OpCode::LABEL:
+                break;
+
+            case OpCode::BEQ: INT_BRANCH(==);
+            case OpCode::BNEQ: INT_BRANCH(!=);
+            case OpCode::BGT: INT_BRANCH(>);
+            case OpCode::BLT: INT_BRANCH(<);
+            case OpCode::BGEQ: INT_BRANCH(>=);
+            case OpCode::BLEQ: INT_BRANCH(<=);
+            case OpCode::BEQI: INT_BRANCH_IMM(==);
+            case OpCode::BNEQI: INT_BRANCH_IMM(!=);
+            case OpCode::BGTI: INT_BRANCH_IMM(>);
+            case OpCode::BLTI: INT_BRANCH_IMM(<);
+            case OpCode::BGEQI: INT_BRANCH_IMM(>=);
+            case OpCode::BLEQI: INT_BRANCH_IMM(<=);
+            case OpCode::INCBLT: COUNTER_BRANCH(<, regs[instr.b_].as_.int_);
+            case OpCode::INCBLEQ: COUNTER_BRANCH(<=, regs[instr.b_].as_.int_);
+            case OpCode::INCBLTI: COUNTER_BRANCH(<, instr.b_);
+            case OpCode::INCBLEQI: COUNTER_BRANCH(<=, instr.b_);
+
+            case OpCode::MADD:
+                regs[instr.dest_] = Value::Int(WrapAdd(WrapMult(regs[instr.a_].as_.int_, regs[instr.b_].as_.int_),
+                                                       regs[instr.c_].as_.int_));
+                break;
+            case OpCode::FMADD:
+                regs[instr.dest_] = Value::Real(regs[instr.a_].as_.real_ * regs[instr.b_].as_.real_ + regs[instr.c_].as_.real_);
+                break;
+
+            case OpCode::ID:
+                regs[instr.dest_] = regs[instr.a_];
+                break;
+            case OpCode::PRINT:
+                Print(instr);
+                break;
+
+            case OpCode::CONST:
+                regs[instr.dest_] = constants_[instr.a_];
+                break;
+
+            default:
+                if (!ExecuteSlowPath(pc - 1)) {
+                    return InterpretResult::RUNTIME_ERROR;
+                }
+                break;
+        }
+        if constexpr (INSTRUMENTED) {
+            if (trace_regs && instr.dest_ >= 0) {
+                tracer_->RegisterWrite(static_cast<int>(&instr - code), instr.dest_, regs[instr.dest_]);
+            }
+        }
+    }
+    return InterpretResult::OK;
+}
+
+// Compiles the loaded program to machine code and runs it. Returns
+// nothing when the program could not be compiled.
+auto VirtualMachine::RunCompiled() -> std::optional<InterpretResult> {
+    if (!JitCompiler::IsSupported()) {
+        return std::nullopt;
+    }
+    JitCompiler jit;
+    std::unique_ptr<JitCode> code = jit.Compile(program_, constants_);
+    if (code == nullptr) {
+        return std::nullopt;
+    }
+    if (sampler_ != nullptr) {
+        sampler_->EnterNative(0);
+    }
+    int status = code->Entry()(registers_.data(), this);
+    return status < 0 ? InterpretResult::RUNTIME_ERROR : InterpretResult::OK;
+}
+
+// Counts a back-edge from `jump` to the loop header `header` and
+// returns the compiled loop once it is hot. The region compiled
+// spans the header through the back-edge, so nested loops are
+// included and every exit leaves through a resume index.
+auto VirtualMachine::OnBackEdge(int header, int jump) -> JitCode * {
+    if (osr_code_[header] != nullptr) {
+        return osr_code_[header].get();
+    }
+    if (++backedge_counts_[header] < tier_up_threshold_ || !JitCompiler::IsSupported()) {
+        return nullptr;
+    }
+    backedge_counts_[header] = 0;
+
+    JitCompiler jit;
+    osr_code_[header] = jit.CompileRegion(program_, constants_, header, jump + 1);
+    if (osr_code_[header] != nullptr) {
+        tiering_stats_.regions_compiled_++;
+    }
+    return osr_code_[header].get();
+}
+
+// Executes a single instruction outside the main loop. Used for
+// rare instructions and by compiled code for everything it does
+// not translate itself. Returns false after a runtime error.
+auto VirtualMachine::ExecuteSlowPath(int pc) -> bool {
+    const ProgramInstr &instr = program_.code_[pc];
+    Value *regs = registers_.data();
+
+    switch (instr.code_) {
+        case OpCode::DIV: {
+            int a = regs[instr.a_].as_.int_;
+            int b = regs[instr.b_].as_.int_;
+            if (b == 0) {
+                RuntimeError(instr, "Division by zero.");
+                return false;
+            }
+            regs[instr.dest_] = Value::Int(b == -1 ? WrapSub(0, a) : a / b);
+            return true;
+        }
+        case OpCode::NOT:
+            regs[instr.dest_] = regs[instr.a_].type_ == ValueType::BOOL
+                ? Value::Bool(!regs[instr.a_].as_.bool_)
+                : Value::Int(~regs[instr.a_].as_.int_);
+            return true;
+        case OpCode::PRINT:
+            Print(instr);
+            return true;
+        default:
+            RuntimeError(instr, "Unsupported instruction.");
+            return false;
+    }
+}
+
+#undef INT_BINARY
+#undef REAL_BINARY
+#undef INT_COMPARE
+#undef REAL_COMPARE
+#undef INT_BINARY_IMM
+#undef REAL_BINARY_IMM
+#undef INT_COMPARE_IMM
+#undef REAL_COMPARE_IMM
+#undef BRANCH
+#undef INT_BRANCH
+#undef INT_BRANCH_IMM
+#undef COUNTER_BRANCH
+
+// Prints the operands of a PRINT instruction on one line.
+void VirtualMachine::Print(const ProgramInstr &instr) {
+    for (int i = 0; i < instr.b_; i++) {
+        if (i != 0) {
+            *out_ << " ";
+        }
+        PrintValue(registers_[program_.operands_[instr.a_ + i]]);
+    }
+    *out_ << "\n";
+}
+
+void VirtualMachine::PrintValue(const Value &val) {
+    if (IsString(val)) {
+        *out_ << AsString(val)->View();
+        return;
+    }
+    *out_ << ScalarToString(val);
+}
+
+void VirtualMachine::RuntimeError(const ProgramInstr &instr, std::string_view message) {
+    std::cerr << "[line " << instr.line_ << "] Runtime error: " << message << "\n";
 }
 
 } // namespace "stronk"
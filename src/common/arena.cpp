@@ -0,0 +1,16 @@
+#include "common/arena.h"
+
+namespace stronk {
+
+Arena::Arena(size_t first_chunk) : chunks_(first_chunk) {}
+
+auto Arena::do_allocate(size_t bytes, size_t alignment) -> void * {
+    allocated_ += bytes;
+    return chunks_.allocate(bytes, alignment);
+}
+
+auto Arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool {
+    return this == &other;
+}
+
+} // namespace "stronk"
@@ -0,0 +1,163 @@
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include "common/mem_stats.h"
+
+namespace stronk {
+
+namespace {
+
+// Plain thread locals: no constructor runs, so operator new can
+// use them on any thread at any time, including during startup.
+thread_local PhaseAllocations counters[_STRONK_MEM_PHASES];
+#if STRONK_MEM_STATS
+thread_local MemPhase current_phase = MemPhase::OTHER;
+#endif
+
+} // namespace
+
+auto MemPhaseName(MemPhase phase) -> const char * {
+    switch (phase) {
+        case MemPhase::OTHER: return "other";
+        case MemPhase::SCANNER: return "scanner";
+        case MemPhase::PARSER: return "parser";
+        case MemPhase::CODE_GENERATOR: return "code generator";
+        case MemPhase::CONSTANT_POOL: return "constant pool";
+        case MemPhase::VM: return "vm";
+        default: return "unknown";
+    }
+}
+
+auto MemStats::Current() -> MemStats {
+    MemStats stats;
+    for (size_t i = 0; i < _STRONK_MEM_PHASES; i++) {
+        stats.phases_[i] = counters[i];
+    }
+    return stats;
+}
+
+auto MemStats::operator-(const MemStats &other) const -> MemStats {
+    MemStats stats;
+    for (size_t i = 0; i < _STRONK_MEM_PHASES; i++) {
+        stats.phases_[i].allocations_ = phases_[i].allocations_ - other.phases_[i].allocations_;
+        stats.phases_[i].bytes_ = phases_[i].bytes_ - other.phases_[i].bytes_;
+    }
+    return stats;
+}
+
+auto MemStats::operator+=(const MemStats &other) -> MemStats & {
+    for (size_t i = 0; i < _STRONK_MEM_PHASES; i++) {
+        phases_[i].allocations_ += other.phases_[i].allocations_;
+        phases_[i].bytes_ += other.phases_[i].bytes_;
+    }
+    return *this;
+}
+
+auto MemStats::Total() const -> PhaseAllocations {
+    PhaseAllocations total;
+    for (const auto &phase : phases_) {
+        total.allocations_ += phase.allocations_;
+        total.bytes_ += phase.bytes_;
+    }
+    return total;
+}
+
+void MemStats::Report(std::ostream &out, size_t source_bytes) const {
+    auto row = [&](const char *name, const PhaseAllocations &phase) {
+        out << std::left << std::setw(16) << name << std::right << std::setw(12) << phase.allocations_
+            << std::setw(14) << phase.bytes_;
+        if (source_bytes > 0) {
+            out << std::setw(16) << std::fixed << std::setprecision(1)
+                << phase.bytes_ / (source_bytes / 1024.0);
+        }
+        out << "\n";
+    };
+    out << std::left << std::setw(16) << "phase" << std::right << std::setw(12) << "allocations"
+        << std::setw(14) << "bytes" << (source_bytes > 0 ? "  bytes/source KB" : "") << "\n";
+    for (size_t i = 0; i < _STRONK_MEM_PHASES; i++) {
+        row(MemPhaseName(static_cast<MemPhase>(i)), phases_[i]);
+    }
+    row("total", Total());
+}
+
+#if STRONK_MEM_STATS
+
+MemPhaseScope::MemPhaseScope(MemPhase phase) : previous_(current_phase) {
+    current_phase = phase;
+}
+
+MemPhaseScope::~MemPhaseScope() {
+    current_phase = previous_;
+}
+
+namespace {
+
+void Count(size_t size) {
+    PhaseAllocations &phase = counters[static_cast<size_t>(current_phase)];
+    phase.allocations_++;
+    phase.bytes_ += size;
+}
+
+auto Allocate(size_t size) -> void * {
+    Count(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+auto AllocateAligned(size_t size, std::align_val_t align) -> void * {
+    Count(size);
+    auto alignment = static_cast<size_t>(align);
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+} // namespace
+
+#endif // STRONK_MEM_STATS
+
+} // namespace "stronk"
+
+#if STRONK_MEM_STATS
+
+// Replacements of the global allocation functions; every form
+// ends up in malloc/free.
+auto operator new(size_t size) -> void * {
+    if (void *ptr = stronk::Allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new[](size_t size) -> void * {
+    return operator new(size);
+}
+
+auto operator new(size_t size, const std::nothrow_t &) noexcept -> void * {
+    return stronk::Allocate(size);
+}
+
+auto operator new[](size_t size, const std::nothrow_t &) noexcept -> void * {
+    return stronk::Allocate(size);
+}
+
+auto operator new(size_t size, std::align_val_t align) -> void * {
+    if (void *ptr = stronk::AllocateAligned(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new[](size_t size, std::align_val_t align) -> void * {
+    return operator new(size, align);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#endif // STRONK_MEM_STATS
@@ -0,0 +1,178 @@
+#include <cstring>
+#include <iomanip>
+#include "common/trace.h"
+
+namespace stronk {
+
+namespace {
+
+const char MAGIC[] = "STRKTRC1";
+constexpr size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+
+enum class RecordKind : uint8_t {
+    TOKEN = 1,
+    IR = 2,
+    INSTRUCTION = 3,
+    REGISTER = 4
+};
+
+} // namespace
+
+Tracer::Tracer(std::ostream &out, uint32_t categories) : out_(&out), categories_(categories) {
+    buffer_.reserve(_STRONK_TRACE_BUFFER_SIZE);
+    buffer_.insert(buffer_.end(), MAGIC, MAGIC + MAGIC_SIZE);
+}
+
+Tracer::~Tracer() {
+    Flush();
+}
+
+auto Tracer::ParseCategories(std::string_view list) -> std::optional<uint32_t> {
+    uint32_t categories = 0;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+        if (name == "tokens") {
+            categories |= static_cast<uint32_t>(TraceCategory::TOKENS);
+        } else if (name == "ir") {
+            categories |= static_cast<uint32_t>(TraceCategory::IR);
+        } else if (name == "instrs") {
+            categories |= static_cast<uint32_t>(TraceCategory::INSTRUCTIONS);
+        } else if (name == "regs") {
+            categories |= static_cast<uint32_t>(TraceCategory::REGISTERS);
+        } else if (name == "all") {
+            categories = ~uint32_t(0);
+        } else {
+            return std::nullopt;
+        }
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return categories;
+}
+
+template <class T>
+void Tracer::Put(T val) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &val, sizeof(T));
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+}
+
+void Tracer::PutString(std::string_view str) {
+    Put<uint32_t>(static_cast<uint32_t>(str.size()));
+    buffer_.insert(buffer_.end(), str.begin(), str.end());
+}
+
+void Tracer::EndRecord() {
+    if (buffer_.size() >= _STRONK_TRACE_BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+void Tracer::Token(int line, std::string_view form) {
+    Put(RecordKind::TOKEN);
+    Put<int32_t>(line);
+    PutString(form);
+    EndRecord();
+}
+
+void Tracer::Ir(const Instr &instr) {
+    Put(RecordKind::IR);
+    Put<int32_t>(instr.line_);
+    PutString(instr.ToString());
+    EndRecord();
+}
+
+void Tracer::Instruction(int pc, OpCode code, int line) {
+    Put(RecordKind::INSTRUCTION);
+    Put<int32_t>(pc);
+    Put<uint16_t>(static_cast<uint16_t>(code));
+    Put<int32_t>(line);
+    EndRecord();
+}
+
+void Tracer::RegisterWrite(int pc, int reg, const Value &val) {
+    Put(RecordKind::REGISTER);
+    Put<int32_t>(pc);
+    Put<int32_t>(reg);
+    Put(val.type_);
+    Put<uint64_t>(val.as_.bits_);
+    EndRecord();
+}
+
+void Tracer::Flush() {
+    out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_->flush();
+    buffer_.clear();
+}
+
+namespace {
+
+template <class T>
+auto Get(std::istream &in, T &val) -> bool {
+    char bytes[sizeof(T)];
+    if (!in.read(bytes, sizeof(T))) {
+        return false;
+    }
+    std::memcpy(&val, bytes, sizeof(T));
+    return true;
+}
+
+auto GetString(std::istream &in, std::string &str) -> bool {
+    uint32_t size;
+    if (!Get(in, size)) {
+        return false;
+    }
+    str.resize(size);
+    return static_cast<bool>(in.read(str.data(), size));
+}
+
+} // namespace
+
+auto DecodeTrace(std::istream &in, std::ostream &out) -> bool {
+    char magic[MAGIC_SIZE];
+    if (!in.read(magic, MAGIC_SIZE) || std::memcmp(magic, MAGIC, MAGIC_SIZE) != 0) {
+        return false;
+    }
+
+    RecordKind kind;
+    while (Get(in, kind)) {
+        switch (kind) {
+            case RecordKind::TOKEN:
+            case RecordKind::IR: {
+                int32_t line;
+                std::string form;
+                if (!Get(in, line) || !GetString(in, form)) {
+                    return false;
+                }
+                out << (kind == RecordKind::TOKEN ? "token " : "ir    ") << std::setw(4) << line << "  " << form << "\n";
+                break;
+            }
+            case RecordKind::INSTRUCTION: {
+                int32_t pc;
+                uint16_t code;
+                int32_t line;
+                if (!Get(in, pc) || !Get(in, code) || !Get(in, line)) {
+                    return false;
+                }
+                out << "exec  " << std::setw(4) << line << "  " << std::setw(6) << pc << "  "
+                    << Instr(static_cast<OpCode>(code), line, 0).ToString() << "\n";
+                break;
+            }
+            case RecordKind::REGISTER: {
+                int32_t pc;
+                int32_t reg;
+                Value val;
+                if (!Get(in, pc) || !Get(in, reg) || !Get(in, val.type_) || !Get(in, val.as_.bits_)) {
+                    return false;
+                }
+                out << "write       " << std::setw(6) << pc << "  r" << reg << " = " << ScalarToString(val) << "\n";
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return in.eof();
+}
+
+} // namespace "stronk"
@@ -5,25 +5,31 @@
 
 #include "common/utils.h"
 #include "frontend/scanner.h"
+#include "backend/vm.h"
 #include "config.h" // Generated file from CMakeLists.txt. Make sure to build that first!
 
 namespace stronk {
 
-auto ReadTokensFromSource(const std::string &source) -> std::vector<std::shared_ptr<Token>> {
+auto ReadMockSource(const std::string &source) -> std::string {
     std::string base = BASE_DIR;
     std::string filepath = base + "/test/mock/" + source;
-    Scanner scanner;
     std::ifstream istream(filepath);
 
     if (!istream.is_open()) {
         std::cerr << "File does not exist" << "\n";
         exit(74);
     }
-    
-    // Load source file into scanner buffer.
+
     std::stringstream buffer;
     buffer << istream.rdbuf();
-    std::string str = buffer.str();
+    return buffer.str();
+}
+
+auto ReadTokensFromSource(const std::string &source) -> std::vector<std::shared_ptr<Token>> {
+    Scanner scanner;
+
+    // Load source file into scanner buffer.
+    std::string str = ReadMockSource(source);
     scanner.LoadSource(str);
 
     std::vector<std::shared_ptr<Token>> tokens;
@@ -47,7 +53,24 @@ auto ReadBytecodeFromTokens(const std::vector<std::shared_ptr<Token>> &tokens) -
         }
     }
     parser.Parse();
-    return parser.GetBytecode();
+    return parser.TakeModule().code_;
+}
+
+// Compiles and runs a mock source file, returning everything it printed.
+auto InterpretSource(const std::string &source, ExecutionEngine engine) -> std::string {
+    std::string str = ReadMockSource(source);
+    Compiler compiler;
+    if (!compiler.Compile(str)) {
+        return "<compile error>";
+    }
+
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    vm.SetEngine(engine);
+    if (vm.Interpret(compiler.TakeModule()) != InterpretResult::OK) {
+        out << "<runtime error>";
+    }
+    return out.str();
 }
 
 auto BuildToken(TokenType token_type) -> std::shared_ptr<Token> {
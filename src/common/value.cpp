@@ -1,24 +1,20 @@
-#include <iostream>
-#include <iomanip>
+#include <sstream>
 #include "common/value.h"
 
 namespace stronk {
 
-// Prints a single value with precision 6.
-void PrintValue(Value* val) {
-    if (auto bool_val = dynamic_cast<BoolValue*>(val)) {
-        std::cout << "BoolValue: " << bool_val->val_ << std::endl;
-    } else if (auto real_val = dynamic_cast<RealValue*>(val)) {
-        std::cout << "RealValue: " << real_val->val_ << std::endl;
-    } else if (auto int_val = dynamic_cast<IntValue*>(val)) {
-        std::cout << "IntValue: " << int_val->val_ << std::endl;
-    } else if (auto char_val = dynamic_cast<CharValue*>(val)) {
-        std::cout << "CharValue: " << char_val->val_ << std::endl;
-    } else if (dynamic_cast<NilValue*>(val) != nullptr) {
-        std::cout << "NilValue" << std::endl;
-    } else {
-        std::cout << "Unknown Value Type" << std::endl;
+// Formats a single scalar value with precision 6.
+auto ScalarToString(const Value &val) -> std::string {
+    std::ostringstream oss;
+    switch (val.type_) {
+        case ValueType::BOOL: oss << (val.as_.bool_ ? "true" : "false"); break;
+        case ValueType::INT: oss << val.as_.int_; break;
+        case ValueType::REAL: oss << val.as_.real_; break;
+        case ValueType::CHAR: oss << val.as_.char_; break;
+        case ValueType::NIL: oss << "nil"; break;
+        case ValueType::OBJ: oss << "<object>"; break;
     }
+    return oss.str();
 }
 
 } // namespace "stronk"
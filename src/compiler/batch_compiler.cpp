@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "common/thread_pool.h"
+#include "compiler/batch_compiler.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+using Clock = std::chrono::steady_clock;
+
+auto BatchResult::Failures() const -> size_t {
+    return std::count_if(files_.begin(), files_.end(), [](const auto &file) { return !file.ok_; });
+}
+
+auto BatchResult::TotalBytes() const -> size_t {
+    size_t bytes = 0;
+    for (const auto &file : files_) {
+        bytes += file.bytes_;
+    }
+    return bytes;
+}
+
+auto FindSources(const std::filesystem::path &directory) -> std::vector<std::filesystem::path> {
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".stronk") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+namespace {
+
+void CompileFile(BatchFileResult &result, const ProgramCache *cache) {
+    auto start = Clock::now();
+    std::ifstream istream(result.path_);
+    std::stringstream buffer;
+    buffer << istream.rdbuf();
+    std::string source = buffer.str();
+    result.bytes_ = source.size();
+
+    Compiler compiler;
+    if (istream && compiler.Compile(source)) {
+        try {
+            Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+            result.instructions_ = program.code_.size();
+            result.ok_ = cache == nullptr || cache->Store(source, program);
+        } catch (const std::invalid_argument &) {
+            result.ok_ = false;
+        }
+    }
+    result.elapsed_ = Clock::now() - start;
+}
+
+} // namespace
+
+auto CompileAll(const std::vector<std::filesystem::path> &files, size_t threads,
+                const ProgramCache *cache) -> BatchResult {
+    BatchResult result;
+    result.files_.resize(files.size());
+    auto start = Clock::now();
+    {
+        ThreadPool pool(threads);
+        result.threads_ = pool.Size();
+        for (size_t i = 0; i < files.size(); i++) {
+            result.files_[i].path_ = files[i];
+            pool.Submit([&file = result.files_[i], cache] { CompileFile(file, cache); });
+        }
+        pool.Wait();
+        result.steals_ = pool.GetSteals();
+    }
+    result.wall_ = Clock::now() - start;
+    return result;
+}
+
+} // namespace "stronk"
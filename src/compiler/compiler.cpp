@@ -1,55 +1,96 @@
-#include <iomanip>
-#include <iostream>
 #include <string>
 #include "compiler/compiler.h"
 
 namespace stronk {
 
-// Compiles the source after scanning it.
+// Compiles the source after scanning it. Returns false if
+// an error was reported. Declarations from earlier calls stay
+// visible and the module only holds the code for `source`.
 auto Compiler::Compile(std::string_view source) -> bool {
+    MemStats before = MemStats::Current();
+    // Tokens and instructions come from one arena per call. It is
+    // freed in one go once the compiler and everything allocated
+    // from it, the module included, are gone.
+    arena_ = std::make_shared<Arena>();
+    scanner_.SetArena(arena_);
+    parser_.SetArena(arena_);
     scanner_.LoadSource(source);
-    std::vector<Token> tokens;
-    
-    #ifdef DEBUG_TRACE_EXECUTION
-    int line = -1;
-    #endif
+    bool trace_tokens = tracer_ != nullptr && tracer_->IsEnabled(TraceCategory::TOKENS);
 
     for (;;) {
-        std::shared_ptr<Token> token = scanner_.ScanNextToken();
-
-        #if DEBUG_TRACE_EXECUTION
-        auto token_line = token->line_;
-        #endif
-        
+        std::shared_ptr<Token> token;
+        {
+            MemPhaseScope scope(MemPhase::SCANNER);
+            token = scanner_.ScanNextToken();
+        }
         auto token_type = token->type_;
-        std::string token_form = token->ToString();
-        parser_.AddToken(std::move(token));
-
-        #if DEBUG_TRACE_EXECUTION
-        if (token_line != line) {
-            std::cout << std::setw(4) << std::setfill(' ') << " " + std::to_string(token_line);
-            line = token_line;
-        } else {
-            std::cout << "   |";
+        if (trace_tokens) {
+            tracer_->Token(token->line_, token->ToString());
+        }
+        {
+            MemPhaseScope scope(MemPhase::PARSER);
+            parser_.AddToken(std::move(token));
         }
-
-        std::cout << " " << token_form << "\n";
-        #endif
 
         if (token_type == TokenType::TOKEN_EOF) {
             break;
         }
     }
 
-    parser_.Parse();
+    {
+        MemPhaseScope scope(MemPhase::PARSER);
+        parser_.Parse();
+    }
 
-    bytecode_ = parser_.GetBytecode();
+    {
+        MemPhaseScope scope(MemPhase::CODE_GENERATOR);
+        module_ = parser_.TakeModule();
+    }
+    if (tracer_ != nullptr && tracer_->IsEnabled(TraceCategory::IR)) {
+        for (const auto &instr : module_.code_) {
+            tracer_->Ir(*instr);
+        }
+    }
+    if (disassembly_ != nullptr) {
+        module_.Disassemble(*disassembly_);
+    }
+    mem_stats_ += MemStats::Current() - before;
     
-    return true;
+    return !parser_.HadError();
+}
+
+// Records tokens and emitted instructions in `tracer` when those
+// categories are enabled. Pass nullptr to stop.
+void Compiler::SetTracer(Tracer *tracer) {
+    tracer_ = tracer;
+}
+
+// Writes the disassembly of every compiled module to `out`. Pass
+// nullptr to stop.
+void Compiler::SetDisassembly(std::ostream *out) {
+    disassembly_ = out;
+}
+
+auto Compiler::GetBytecode() const -> const Bytecode & {
+    return module_.code_;
+}
+
+// Allocations of every `Compile` call so far, by phase. Only
+// counted in STRONK_MEM_STATS builds.
+auto Compiler::GetMemStats() const -> const MemStats & {
+    return mem_stats_;
+}
+
+auto Compiler::GetConstantPool() const -> const ConstantPool & {
+    return module_.constants_;
 }
 
-auto Compiler::GetBytecode() -> Bytecode {
-    return bytecode_;
+// Hands the last compiled module to the caller, e.g. the VM,
+// without copying it. The compiler is left without code.
+auto Compiler::TakeModule() -> Module {
+    Module module = std::move(module_);
+    module_ = Module();
+    return module;
 }
 
 } // namespace "stronk"
\ No newline at end of file
@@ -4,7 +4,7 @@
 namespace stronk {
 
 // Gets a constant from constant pool by id.
-auto ConstantPool::GetConstant(int id) -> ConstantValue {
+auto ConstantPool::GetConstant(int id) const -> ConstantValue {
     if (id < 0 || id >= next_id_) {
         throw std::out_of_range("Invalid constant pool id.");
     }
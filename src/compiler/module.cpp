@@ -0,0 +1,19 @@
+#include <sstream>
+#include "compiler/module.h"
+
+namespace stronk {
+
+Module::Module(Bytecode code, ConstantPool constants)
+    : code_(std::move(code)), constants_(std::move(constants)) {}
+
+// Formats into a buffer first so a large program costs one write
+// to `out` instead of one per instruction.
+void Module::Disassemble(std::ostream &out) const {
+    std::ostringstream buffer;
+    for (const auto &instr : code_) {
+        buffer << instr->line_ << " " << instr->ToString() << "\n";
+    }
+    out << buffer.str();
+}
+
+} // namespace "stronk"
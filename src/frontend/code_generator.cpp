@@ -1,16 +1,30 @@
 #include "frontend/code_generator.h"
-#include <iostream>
+#include "common/mem_stats.h"
 
 namespace stronk {
+
+// Allocates instructions from `arena` from now on. Pass nullptr
+// to go back to the heap.
+void CodeGenerator::SetArena(std::shared_ptr<Arena> arena) {
+    arena_ = std::move(arena);
+}
+
 // Adds an instruction.
 void CodeGenerator::AddInstruction(const std::shared_ptr<Instr> &instr) {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     bytecode_.push_back(instr);
 }
 
 // Utility method for adding value to the constant
 // pool and an instruction that references that constant.
 void CodeGenerator::AddConstantInstruction(Address &dest, const ConstantPool::ConstantValue &value, int line, int pos) {
-    AddInstruction(std::make_shared<ConstInstr>(dest, constant_pool_.AddConstant(value), line, pos));
+    int index;
+    {
+        MemPhaseScope scope(MemPhase::CONSTANT_POOL);
+        index = constant_pool_.AddConstant(value);
+    }
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
+    AddInstruction(MakeShared<ConstInstr>(arena_, dest, index, line, pos));
 }
 
 // Gets the number of instructions.
@@ -18,16 +32,15 @@ auto CodeGenerator::Size() -> size_t {
     return bytecode_.size();
 }
 
-// Prints each instruction.
-void CodeGenerator::DissasembleCode() {
-    for (const auto &instr : bytecode_) {
-        std::cout << instr->line_ << " " << instr->ToString() << "\n";
-    }
-}
-
-// Bytecode getter method.
-auto CodeGenerator::GetCode() -> Bytecode {
-    return bytecode_;
+// Hands out the instructions added since the previous call along
+// with their constants, leaving the generator empty. Constant ids
+// only have to be valid within one module, so the next one starts
+// a fresh pool.
+auto CodeGenerator::TakeModule() -> Module {
+    Module module(std::move(bytecode_), std::move(constant_pool_));
+    bytecode_.clear();
+    constant_pool_ = ConstantPool();
+    return module;
 }
 
 } // namespace "stronk"
\ No newline at end of file
@@ -1,8 +1,83 @@
+#include <array>
 #include <iostream>
+#include "common/mem_stats.h"
 #include "frontend/parser.h"
 
 namespace stronk {
 
+// How a binary operator types its operands.
+enum class OperandKind : uint8_t {
+    LOGIC,      // Both converted to bool, short-circuited.
+    EQUALITY,   // Equal types.
+    COMPARISON, // Equal types, int or real.
+    ARITHMETIC  // Int or real; an int meeting a real becomes real.
+};
+
+// One row of the binary operator table. `int_op_` is emitted for
+// int and bool operands and `real_op_` for real ones.
+struct BinaryRule {
+    Precedence precedence_ = Precedence::NONE;
+    OperandKind kind_ = OperandKind::LOGIC;
+    OpCode int_op_ = OpCode::ADD;
+    OpCode real_op_ = OpCode::ADD;
+    const char *type_error_ = nullptr;
+};
+
+namespace {
+
+constexpr size_t TOKEN_TYPES = static_cast<size_t>(TokenType::TOKEN_EOF) + 1;
+
+constexpr auto BuildBinaryRules() -> std::array<BinaryRule, TOKEN_TYPES> {
+    std::array<BinaryRule, TOKEN_TYPES> rules = {};
+    auto add = [&rules](TokenType type, Precedence precedence, OperandKind kind, OpCode int_op, OpCode real_op,
+                        const char *type_error) {
+        rules[static_cast<size_t>(type)] = BinaryRule { precedence, kind, int_op, real_op, type_error };
+    };
+    const char *comparison_error = "Comparison is only possible between integers or floats.";
+    add(TokenType::OR, Precedence::OR, OperandKind::LOGIC, OpCode::OR, OpCode::OR, nullptr);
+    add(TokenType::AND, Precedence::AND, OperandKind::LOGIC, OpCode::AND, OpCode::AND, nullptr);
+    add(TokenType::EQUAL_EQUAL, Precedence::EQUALITY, OperandKind::EQUALITY, OpCode::EQ, OpCode::FEQ, nullptr);
+    add(TokenType::BANG_EQUAL, Precedence::EQUALITY, OperandKind::EQUALITY, OpCode::NEQ, OpCode::FNEQ, nullptr);
+    add(TokenType::GREATER, Precedence::COMPARISON, OperandKind::COMPARISON, OpCode::GT, OpCode::FGT,
+        comparison_error);
+    add(TokenType::GREATER_EQUAL, Precedence::COMPARISON, OperandKind::COMPARISON, OpCode::GEQ, OpCode::FGEQ,
+        comparison_error);
+    add(TokenType::LESS, Precedence::COMPARISON, OperandKind::COMPARISON, OpCode::LT, OpCode::FLT,
+        comparison_error);
+    add(TokenType::LESS_EQUAL, Precedence::COMPARISON, OperandKind::COMPARISON, OpCode::LEQ, OpCode::FLEQ,
+        comparison_error);
+    add(TokenType::PLUS, Precedence::TERM, OperandKind::ARITHMETIC, OpCode::ADD, OpCode::FADD,
+        "Addition is only possible between integers or floats.");
+    add(TokenType::MINUS, Precedence::TERM, OperandKind::ARITHMETIC, OpCode::SUB, OpCode::FSUB,
+        "Subtraction is only possible between integers or floats.");
+    add(TokenType::STAR, Precedence::FACTOR, OperandKind::ARITHMETIC, OpCode::MULT, OpCode::FMULT,
+        "Multiplication is only possible between integers or floats.");
+    add(TokenType::SLASH, Precedence::FACTOR, OperandKind::ARITHMETIC, OpCode::DIV, OpCode::FDIV,
+        "Division is only possible between integers or floats.");
+    return rules;
+}
+
+// Indexed by TokenType; tokens that are not binary operators have
+// precedence NONE.
+constexpr std::array<BinaryRule, TOKEN_TYPES> BINARY_RULES = BuildBinaryRules();
+
+// Thrown once expressions nest deeper than the limit. Unwinds the
+// recursive expression parser in one go; caught in `Parse`.
+struct NestingTooDeep {};
+
+// Counts one level of expression nesting while in scope.
+class NestingScope {
+public:
+    explicit NestingScope(int &depth) : depth_(depth) { depth_++; }
+    ~NestingScope() { depth_--; }
+    NestingScope(const NestingScope &) = delete;
+    auto operator=(const NestingScope &) -> NestingScope & = delete;
+private:
+    int &depth_;
+};
+
+} // namespace
+
 // ========================
 // Public Methods
 // ========================
@@ -12,19 +87,52 @@ void Parser::AddToken(std::shared_ptr<Token> token) {
     tokens_.push_back(std::move(token));
 }
 
-// Parses the token list and returns corresponding bytecode.
+// Parses the tokens added since the previous call. Consumed tokens
+// are dropped while the global variables, constant pool and label
+// and temporary counters persist, so a session (the REPL) can be
+// compiled one piece at a time.
 void Parser::Parse() {
     current_ = tokens_.begin();
     previous_ = tokens_.end();
 
     while (Peek()->type_ != TokenType::TOKEN_EOF) {
-        ParseDeclaration();
+        try {
+            ParseDeclaration();
+        } catch (const NestingTooDeep &) {
+            // Already reported; nothing after it is parsed.
+            statements_.clear();
+            while (symbols_.Depth() > 0) {
+                symbols_.ExitScope();
+            }
+            while (Peek()->type_ != TokenType::TOKEN_EOF) {
+                StepForward();
+            }
+        }
     }
+    tokens_.clear();
+}
+
+// Limits how deeply parentheses, unary operators and chained
+// assignments may nest, since expressions are parsed recursively.
+// Statements nest without limit.
+void Parser::SetMaxExpressionDepth(int depth) {
+    max_expression_depth_ = depth;
 }
 
-auto Parser::GetBytecode() -> Bytecode {
-    cg_.DissasembleCode();
-    return cg_.GetCode();
+// Allocates instructions from `arena` from now on. Pass nullptr to
+// go back to the heap.
+void Parser::SetArena(std::shared_ptr<Arena> arena) {
+    cg_.SetArena(std::move(arena));
+}
+
+// Returns the code emitted since the previous call.
+auto Parser::TakeModule() -> Module {
+    return cg_.TakeModule();
+}
+
+// Whether any syntax or type error was reported while parsing.
+auto Parser::HadError() const -> bool {
+    return error_occurred_;
 }
 
 // ========================
@@ -116,27 +224,27 @@ auto Parser::ExtractValue(std::string_view message) -> std::optional<T> {
 
 
 // Attempts to convert `source` to type2 if posisble.
-auto Parser::ConvertType(Address source, PrimitiveType type2) -> Address {
-    if (symbol_table_.find(source) == symbol_table_.end()) {
+auto Parser::ConvertType(const Operand &source, PrimitiveType type2) -> Operand {
+    if (!source.type_.has_value()) {
         Error("Cannot convert type from undefined to <type2>.");
         return source;
     }
 
-    PrimitiveType type1 = symbol_table_[source];
+    PrimitiveType type1 = *source.type_;
 
     if (type1 == type2) {
         return source;
     }
 
-    Address dest;
+    Operand dest = { {}, type2 };
     switch (type2) {
         case PrimitiveType::BOOL:
             Error("Cannot convert <type1> to bool.");
             break;
         case PrimitiveType::INT:
             if (type1 == PrimitiveType::REAL) {
-                dest = num_gen_.GenerateTemp();
-                EmitInstruction(dest, OpCode::F2I, source);
+                dest.address_ = num_gen_.GenerateTemp();
+                EmitInstruction(dest.address_, OpCode::F2I, source.address_);
             } else {
                 Error("Cannot convert <type1> to bool.");
             }
@@ -146,8 +254,8 @@ auto Parser::ConvertType(Address source, PrimitiveType type2) -> Address {
             break;
         case PrimitiveType::REAL:
             if (type1 == PrimitiveType::INT) {
-                dest = num_gen_.GenerateTemp();
-                EmitInstruction(dest, OpCode::I2F, source);
+                dest.address_ = num_gen_.GenerateTemp();
+                EmitInstruction(dest.address_, OpCode::I2F, source.address_);
             } else {
                 Error("Cannot convert <type1> to bool.");
             }
@@ -156,31 +264,11 @@ auto Parser::ConvertType(Address source, PrimitiveType type2) -> Address {
     return dest;
 }
 
-auto Parser::GetType(Address source) -> std::optional<PrimitiveType> {
-    if (symbol_table_.find(source) == symbol_table_.end()) {
+auto Parser::GetType(const Operand &source) -> std::optional<PrimitiveType> {
+    if (!source.type_.has_value()) {
         Error("Cannot get type of undefined.");
-        return std::nullopt;
-    }
-    return symbol_table_[source];
-}
-
-// ========================
-// Symbol Table Access Methods
-// ========================
-
-
-void Parser::AddToTable(Address dest, PrimitiveType type) {
-    if (symbol_table_.find(dest) != symbol_table_.end()) {
-        Error("Cannot redeclare.");
     }
-    symbol_table_[dest] = type;
-}
-
-void Parser::UpdateTable(Address dest, PrimitiveType type) {
-    if (symbol_table_.find(dest) == symbol_table_.end()) {
-        Error("Cannot find.");
-    }
-    symbol_table_[dest] = type;
+    return source.type_;
 }
 
 // ========================
@@ -190,53 +278,69 @@ void Parser::UpdateTable(Address dest, PrimitiveType type) {
 
 template <typename... Args>
 void Parser::EmitInstruction(Address &dest, OpCode op, Args... args) {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
-    std::vector<Address> args_vec = {args...};
-    cg_.AddInstruction(std::make_shared<PureInstr>(op, dest, args_vec, line, position));
+    std::vector<Address> args_vec;
+    args_vec.reserve(sizeof...(args));
+    (args_vec.push_back(std::move(args)), ...);
+    cg_.AddInstruction(MakeShared<PureInstr>(cg_.GetArena(), op, dest, std::move(args_vec), line, position));
 }
 
 template <typename... Args>
 void Parser::EmitInstruction(OpCode op, Args... args) {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
-    std::vector<Address> arg_vec = {args...};
-    std::vector<Address> label_vec;
-    cg_.AddInstruction(std::make_shared<ImpureInstr>(op, arg_vec, label_vec, line, position));
+    std::vector<Address> arg_vec;
+    arg_vec.reserve(sizeof...(args));
+    (arg_vec.push_back(std::move(args)), ...);
+    cg_.AddInstruction(MakeShared<ImpureInstr>(cg_.GetArena(), op, std::move(arg_vec), std::vector<Label>(), line,
+                                               position));
 }
 
 void Parser::EmitBr(Address cond, Label label1, Label label2) {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
-    std::vector<Address> arg_vec = { cond };
-    std::vector<Address> label_vec = { label1, label2 };
-    cg_.AddInstruction(std::make_shared<ImpureInstr>(OpCode::BR, arg_vec, label_vec, line, position));
+    std::vector<Address> arg_vec;
+    arg_vec.push_back(std::move(cond));
+    std::vector<Label> label_vec;
+    label_vec.reserve(2);
+    label_vec.push_back(std::move(label1));
+    label_vec.push_back(std::move(label2));
+    cg_.AddInstruction(MakeShared<ImpureInstr>(cg_.GetArena(), OpCode::BR, std::move(arg_vec), std::move(label_vec),
+                                               line, position));
 }
 
 void Parser::EmitLabel(Label label) {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
-    cg_.AddInstruction(std::make_shared<LabelInstr>(label, line, position));
+    cg_.AddInstruction(MakeShared<LabelInstr>(cg_.GetArena(), std::move(label), line, position));
 }
 
 void Parser::EmitJmp(Label label) {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
-    std::vector<Address> arg_vec;
-    std::vector<Address> label_vec = { label };
-    cg_.AddInstruction(std::make_shared<ImpureInstr>(OpCode::JMP, arg_vec, label_vec, line, position));
+    std::vector<Label> label_vec;
+    label_vec.push_back(std::move(label));
+    cg_.AddInstruction(MakeShared<ImpureInstr>(cg_.GetArena(), OpCode::JMP, std::vector<Address>(),
+                                               std::move(label_vec), line, position));
 }
 
-auto Parser::EmitConstInstruction(const ConstantPool::ConstantValue &val, PrimitiveType type) -> Address {
-    Address dest = num_gen_.GenerateTemp();
+auto Parser::EmitConstInstruction(const ConstantPool::ConstantValue &val, PrimitiveType type) -> Operand {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
+    Operand dest = { num_gen_.GenerateTemp(), type };
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
-    cg_.AddConstantInstruction(dest, val, line, position);
-    AddToTable(dest, type);
+    cg_.AddConstantInstruction(dest.address_, val, line, position);
     return dest;
 }
 
 auto Parser::EmitConstInstruction(Address &dest, const ConstantPool::ConstantValue &val) -> Address {
+    MemPhaseScope scope(MemPhase::CODE_GENERATOR);
     int line = previous_->get()->line_;
     int position = previous_->get()->position_;
     cg_.AddConstantInstruction(dest, val, line, position);
@@ -249,7 +353,20 @@ auto Parser::EmitConstInstruction(Address &dest, const ConstantPool::ConstantVal
 
 
 // Grammar: declaration -> TYPE var_declaration | statement
+//
+// Statements with a body (blocks, ifs and whiles) push a frame
+// rather than parsing the body recursively; the frames are resumed
+// here until the declaration is complete. Nesting depth is thus
+// bounded by memory instead of the native stack.
 void Parser::ParseDeclaration() {
+    BeginDeclaration();
+    while (!statements_.empty()) {
+        ResumeStatement();
+    }
+}
+
+// Parses a declaration, or starts it if it has a body.
+void Parser::BeginDeclaration() {
     Address var;
     switch (Peek()->type_) {
         case TokenType::PRIMITIVE:
@@ -261,6 +378,52 @@ void Parser::ParseDeclaration() {
     }
 }
 
+// Continues the innermost unfinished statement after its header or
+// one of its parts was parsed. Starting a nested statement may push
+// a frame, so `frame` is not used after that.
+void Parser::ResumeStatement() {
+    StatementFrame &frame = statements_.back();
+    switch (frame.kind_) {
+        case TokenType::LEFT_BRACE:
+            if (Peek()->type_ != TokenType::RIGHT_BRACE && Peek()->type_ != TokenType::TOKEN_EOF) {
+                BeginDeclaration();
+                return;
+            }
+            statements_.pop_back();
+            symbols_.ExitScope();
+            StepIfMatch(TokenType::RIGHT_BRACE, "Expected '}'.");
+            return;
+        case TokenType::IF:
+            if (frame.stage_ == 0) {
+                frame.stage_ = 1;
+                ParseStatement();
+            } else if (frame.stage_ == 1 && Peek()->type_ == TokenType::ELSE) {
+                StepForward();
+                EmitJmp(frame.exit_label_);
+                EmitLabel(frame.next_label_);
+                frame.stage_ = 2;
+                ParseStatement();
+            } else {
+                // Without an else the false branch is the exit.
+                EmitLabel(frame.stage_ == 1 ? frame.next_label_ : frame.exit_label_);
+                statements_.pop_back();
+            }
+            return;
+        case TokenType::WHILE:
+            if (frame.stage_ == 0) {
+                frame.stage_ = 1;
+                ParseStatement();
+            } else {
+                EmitJmp(frame.next_label_);
+                EmitLabel(frame.exit_label_);
+                statements_.pop_back();
+            }
+            return;
+        default:
+            throw std::invalid_argument("Unknown statement frame.");
+    }
+}
+
 // Grammar: var_declaration -> PRIMITIVE IDENTIFIER ( "=" expression )? ";"
 auto Parser::ParseVarDeclaration() -> Address {
     Match(TokenType::PRIMITIVE, "Expected typename.");
@@ -268,16 +431,18 @@ auto Parser::ParseVarDeclaration() -> Address {
     StepForward();
 
     Match(TokenType::IDENTIFIER, "Expected identifier.");
-    std::string dest = ExtractValue<std::string>().value();
+    std::string name = ExtractValue<std::string>().value();
     StepForward();
 
-    // Add variable to symbol table.
-    if (symbol_table_.find(dest) != symbol_table_.end()) {
+    // Globals keep their name, block locals get a slot.
+    const Symbol *symbol = symbols_.Declare(name, var_type);
+    if (symbol == nullptr) {
         Error("Cannot redeclare variables.");
+        symbol = symbols_.Lookup(name);
     }
-    symbol_table_[dest] = var_type;
+    Address dest = symbol->address_;
 
-    Address expression;
+    Operand expression;
     ConstantPool::ConstantValue default_val;
     switch (Peek()->type_) {
         case TokenType::EQUAL:
@@ -286,7 +451,8 @@ auto Parser::ParseVarDeclaration() -> Address {
 
             StepIfMatch(TokenType::SEMICOLON, "Expected ';'.");
 
-            EmitInstruction(dest, OpCode::ID, expression);
+            expression = ConvertType(expression, var_type);
+            EmitInstruction(dest, OpCode::ID, expression.address_);
             return dest;
         case TokenType::SEMICOLON:
             switch (var_type) {
@@ -314,6 +480,8 @@ auto Parser::ParseVarDeclaration() -> Address {
 }
 
 // Grammar: statement -> expression_statement | for_statement | if_statement | while_statement | block
+//
+// Statements with a body only have their header parsed here.
 void Parser::ParseStatement() {
     switch (Peek()->type_) {
         case TokenType::FOR:
@@ -357,32 +525,19 @@ void Parser::ParseIfStatement() {
     Label false_branch = ".if_" + if_num + ".false";
     Label exit_branch = ".if_" + if_num + ".exit";
 
-    Address cond = ParseExpression();
+    Operand cond = ParseExpression();
 
-    if (symbol_table_[cond] != PrimitiveType::BOOL) {
+    if (cond.type_ != PrimitiveType::BOOL) {
         Error("If statements must take booleans.");
     }
 
-    EmitBr(cond, true_branch, false_branch);
+    EmitBr(cond.address_, true_branch, false_branch);
     EmitLabel(true_branch);
 
     StepIfMatch(TokenType::RIGHT_PAREN, "Expected ')'.");
 
-    ParseStatement();
-    
-    if (Peek()->type_ != TokenType::ELSE) {
-        // Cut off early and use false branch as the exit label
-        EmitLabel(false_branch);
-        return;
-    }
-
-    StepForward();
-
-    EmitJmp(exit_branch);
-
-    EmitLabel(false_branch);
-    ParseStatement();
-    EmitLabel(exit_branch);
+    // The branches are parsed by ResumeStatement.
+    statements_.push_back({ TokenType::IF, 0, false_branch, exit_branch });
 }
 
 // Grammar: "while" "(" expression ")" statement
@@ -400,21 +555,19 @@ void Parser::ParseWhileStatement() {
 
     EmitLabel(condition_label);
 
-    Address cond = ParseExpression();
+    Operand cond = ParseExpression();
 
-    if (symbol_table_[cond] != PrimitiveType::BOOL) {
+    if (cond.type_ != PrimitiveType::BOOL) {
         Error("While loops must take booleans.");
     }
 
     StepIfMatch(TokenType::RIGHT_PAREN, "Expected ')'.");
 
-    EmitBr(cond, true_label, exit_label);
+    EmitBr(cond.address_, true_label, exit_label);
 
     EmitLabel(true_label);
-    ParseStatement();
-    EmitJmp(condition_label);
-
-    EmitLabel(exit_label);
+    // The body is parsed by ResumeStatement.
+    statements_.push_back({ TokenType::WHILE, 0, condition_label, exit_label });
 }
 
 // Grammar: print_statement -> "print" expression ";"
@@ -423,10 +576,10 @@ void Parser::ParsePrintStatement() {
         throw std::invalid_argument("Incorrect usage of ParsePrintStatement.");
     }
 
-    Address dest = ParseExpression();
+    Operand dest = ParseExpression();
 
     StepIfMatch(TokenType::SEMICOLON, "Expected ';'.");
-    EmitInstruction(OpCode::PRINT, dest);
+    EmitInstruction(OpCode::PRINT, dest.address_);
 }
 
 // Grammar: block_statement -> "{" declaration* "}"
@@ -435,11 +588,10 @@ void Parser::ParseBlock() {
         throw std::invalid_argument("Incorrect usage of ParseBlock.");
     }
 
-    while ( Peek()->type_ != TokenType::RIGHT_BRACE && Peek()->type_ != TokenType::TOKEN_EOF ) {
-        ParseDeclaration();
-    }
-
-    StepIfMatch(TokenType::RIGHT_BRACE, "Expected '}'.");
+    // The declarations are parsed by ResumeStatement, which also
+    // closes the scope.
+    symbols_.EnterScope();
+    statements_.push_back({ TokenType::LEFT_BRACE, 0, {}, {} });
 }
 
 // Grammar: expr_statement -> expression ";"
@@ -450,355 +602,184 @@ void Parser::ParseExprStatement() {
 }
 
 // Grammar: expression -> assignment
-auto Parser::ParseExpression() -> Address {
+auto Parser::ParseExpression() -> Operand {
     return ParseAssignment();
 }
 
+// Reports the error and abandons the parse once expressions nest
+// deeper than the limit, before the native stack runs out.
+void Parser::CheckExpressionDepth() {
+    if (expression_depth_ > max_expression_depth_) {
+        ErrorAt(*current_, "Expression nests too deeply.");
+        throw NestingTooDeep();
+    }
+}
+
 // Grammar: assignment -> IDENTIFER "=" assignment | logic_or
-auto Parser::ParseAssignment() -> Address {
+auto Parser::ParseAssignment() -> Operand {
+    NestingScope nesting(expression_depth_);
+    CheckExpressionDepth();
     if ((current_ + 1)->get()->type_ != TokenType::EQUAL) {
-        return ParseLogicOr();
+        return ParseBinary(Precedence::OR);
     }
 
-    auto dest = ExtractValue<std::string>().value();
+    auto name = ExtractValue<std::string>().value();
     StepForward();
 
     StepIfMatch(TokenType::EQUAL, "Expected '='.");
 
-    Address assignment = ParseAssignment();
+    Operand assignment = ParseAssignment();
 
-    if (symbol_table_.find(dest) == symbol_table_.end()) {
+    const Symbol *symbol = symbols_.Lookup(name);
+    if (symbol == nullptr) {
         Error("Cannot assign to undefined variable.");
+        return { name, std::nullopt };
     }
-    Address converted = ConvertType(assignment, symbol_table_[dest]);
+    Operand dest = { symbol->address_, symbol->type_ };
+    Operand converted = ConvertType(assignment, symbol->type_);
 
-    EmitInstruction(dest, OpCode::ID, converted);
+    EmitInstruction(dest.address_, OpCode::ID, converted.address_);
     return dest;
 }
 
-// Grammar: logic_or -> logic_and ( "or" logic_and )*
-auto Parser::ParseLogicOr() -> Address {
-    Address dest = ParseLogicAnd();
-    for(;;) {
-        Token &tok = **current_;
-        Address a;
-        Address b;
-        
-        Address converted_a;
-        Address converted_b;
-
-        switch (tok.type_) {
-            case TokenType::OR:
-                StepForward();
-                a = dest;
-                b = ParseLogicAnd();
-                converted_a = ConvertType(a, PrimitiveType::BOOL);
-                converted_b = ConvertType(b, PrimitiveType::BOOL);
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::OR, converted_a, converted_b);
-                break;
-            default: return dest;
+// Grammar:
+//      logic_or   -> logic_and ( "or" logic_and )*
+//      logic_and  -> equality ( "and" equality )*
+//      equality   -> comparison ( ( "!=" | "==" ) comparison )*
+//      comparison -> term ( ( ">" | ">=" | "<" | "<=" ) term )*
+//      term       -> factor ( ( "+" | "-" ) factor )*
+//      factor     -> unary ( ( "*" | "/" ) unary )*
+//
+// Parsed by precedence climbing over BINARY_RULES instead of one
+// function per level, so a leaf costs one call here rather than
+// one per level. Operators are left associative: the right operand
+// is parsed one level tighter than the operator.
+auto Parser::ParseBinary(Precedence precedence, const Address *merge) -> Operand {
+    Operand dest = ParseUnary();
+    for (;;) {
+        const BinaryRule &rule = BINARY_RULES[static_cast<size_t>(Peek()->type_)];
+        if (rule.precedence_ == Precedence::NONE || rule.precedence_ < precedence) {
+            return dest;
+        }
+        StepForward();
+        auto tighter = static_cast<Precedence>(static_cast<uint8_t>(rule.precedence_) + 1);
+        if (rule.kind_ == OperandKind::LOGIC) {
+            // Only logic operators follow one, and they all share
+            // its merge register.
+            dest = ParseLogic(rule, dest, tighter, merge);
+            merge = &dest.address_;
+            continue;
         }
+        Operand b = ParseBinary(tighter);
+        dest = EmitBinary(rule, dest, b);
     }
 }
 
-// Grammar: logic_and -> equality ( "and" equality )*
-auto Parser::ParseLogicAnd() -> Address {
-    Address dest = ParseEquality();
-    for(;;) {
-        Token &tok = **current_;
-        Address a;
-        Address b;
-        Address converted_a;
-        Address converted_b;
+// Short-circuits `a and b` / `a or b`: the result lives in a merge
+// register that takes `a` and is only overwritten by `b` when `a`
+// leaves the result open, so `b` is not evaluated otherwise. A
+// whole chain like `a or b and c` shares one merge register, given
+// as `merge`, which lets the lowering thread every branch of the
+// chain straight to where it ends.
+auto Parser::ParseLogic(const BinaryRule &rule, const Operand &a, Precedence precedence, const Address *merge)
+    -> Operand {
+    std::string logic_num = std::to_string(control_flow_gen_.GenerateNumber());
+    std::string logic_name = rule.int_op_ == OpCode::AND ? ".and_" : ".or_";
+    Label rhs_label = logic_name + logic_num + ".rhs";
+    Label exit_label = logic_name + logic_num + ".exit";
 
-        switch (tok.type_) {
-            case TokenType::AND:
-                StepForward();
-                a = dest;
-                b = ParseEquality();
-                converted_a = ConvertType(a, PrimitiveType::BOOL);
-                converted_b = ConvertType(b, PrimitiveType::BOOL);
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::AND, converted_a, converted_b);
-                break;
-            default: return dest;
-        }
+    Operand dest = { merge != nullptr ? *merge : num_gen_.GenerateTemp(), PrimitiveType::BOOL };
+    if (a.address_ != dest.address_) {
+        Operand converted_a = ConvertType(a, PrimitiveType::BOOL);
+        EmitInstruction(dest.address_, OpCode::ID, converted_a.address_);
     }
-    return dest;
-}
-
-// Grammar: equality -> comparison ( ( "!=" | "==" ) comparison )*
-auto Parser::ParseEquality() -> Address {
-    Address dest = ParseComparison();
-    for(;;) {
-        Token &tok = **current_;
-        Address a;
-        Address b;
+    if (rule.int_op_ == OpCode::AND) {
+        EmitBr(dest.address_, rhs_label, exit_label);
+    } else {
+        EmitBr(dest.address_, exit_label, rhs_label);
+    }
+    EmitLabel(rhs_label);
 
-        switch (tok.type_) {
-            case TokenType::EQUAL_EQUAL:
-                StepForward();
-                a = dest;
-                b = ParseComparison();
-                if (GetType(a).value() != GetType(b).value()) {
-                    Error("Checking equality is only possible on equal types.");
-                }
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::EQ, a, b);
-                break;
-            case TokenType::BANG_EQUAL:
-                StepForward();
-                a = dest;
-                b = ParseComparison();
-                if (GetType(a).value() != GetType(b).value()) {
-                    Error("Checking equality is only possible on equal types.");
-                }
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::NEQ, a, b);
-                break;
-            default: return dest;
-        }
+    Operand b = ParseBinary(precedence, &dest.address_);
+    if (b.address_ != dest.address_) {
+        Operand converted_b = ConvertType(b, PrimitiveType::BOOL);
+        EmitInstruction(dest.address_, OpCode::ID, converted_b.address_);
     }
+    EmitLabel(exit_label);
     return dest;
 }
 
-// Grammar: comparison -> term ( (">" | ">=" | "<" | "<=" ) term )*
-auto Parser::ParseComparison() -> Address {
-    Address dest = ParseTerm();
-    for(;;) {
-        Token &tok = **current_;
-        Address a;
-        Address b;
+// Type checks `a op b` for the operator's kind, promotes int
+// operands to real where the operator allows it and emits the
+// instruction into a new temporary.
+auto Parser::EmitBinary(const BinaryRule &rule, const Operand &a, const Operand &b) -> Operand {
+    Operand dest;
+    Operand converted_a;
+    Operand converted_b;
+    PrimitiveType type;
 
-        switch (tok.type_) {
-            case TokenType::GREATER:
-                StepForward();
-                a = dest;
-                b = ParseTerm();
-                if (GetType(a).value() != GetType(b).value()) {
-                    Error("Checking equality is only possible on equal types.");
-                }
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Comparison is only possible between integers or floats.");
-                }
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::GT, a, b);
-                break;
-            case TokenType::GREATER_EQUAL:
-                StepForward();
-                a = dest;
-                b = ParseTerm();
-                if (GetType(a).value() != GetType(b).value()) {
-                    Error("Checking equality is only possible on equal types.");
-                }
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Comparison is only possible between integers or floats.");
-                }
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::GEQ, a, b);
-                break;
-            case TokenType::LESS:
-                StepForward();
-                a = dest;
-                b = ParseTerm();
-                if (GetType(a).value() != GetType(b).value()) {
-                    Error("Checking equality is only possible on equal types.");
-                }
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Comparison is only possible between integers or floats.");
-                }
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::LT, a, b);
-                break;
-            case TokenType::LESS_EQUAL:
-                StepForward();
-                a = dest;
-                b = ParseTerm();
-                if (GetType(a).value() != GetType(b).value()) {
-                    Error("Checking equality is only possible on equal types.");
-                }
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Comparison is only possible between integers or floats.");
-                }
-            
-                dest = num_gen_.GenerateTemp();
-                AddToTable(dest, PrimitiveType::BOOL);
-            
-                EmitInstruction(dest, OpCode::LEQ, a, b);
-                break;
-            default: return dest;
-        }
-    }
-    return dest;
-}
+    switch (rule.kind_) {
+        case OperandKind::LOGIC:
+            // Short-circuited by ParseLogic instead.
+            break;
+        case OperandKind::EQUALITY:
+        case OperandKind::COMPARISON:
+            type = GetType(a).value();
+            if (type != GetType(b).value()) {
+                Error("Checking equality is only possible on equal types.");
+            }
+            if (rule.kind_ == OperandKind::COMPARISON && type != PrimitiveType::INT && type != PrimitiveType::REAL) {
+                Error(rule.type_error_);
+            }
 
-// Grammar: term -> factor ( (+ | -) factor )*
-auto Parser::ParseTerm() -> Address {
-    Address dest = ParseFactor();
-    for (;;) {
-        Token &tok = **current_;
-        Address a;
-        Address b;
-        Address converted_a;
-        Address converted_b;
-
-        switch (tok.type_) {
-            case TokenType::PLUS:
-                StepForward();
-                a = dest;
-                b = ParseFactor();
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Addition is only possible between integers or floats.");
-                }
-
-                // Convert to float if one of the two are floats.
-                if (GetType(a).value() != GetType(b).value()) {
-                    converted_a = ConvertType(a, PrimitiveType::REAL);
-                    converted_b = ConvertType(b, PrimitiveType::REAL);
-
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::REAL);
-
-                    EmitInstruction(dest, OpCode::FADD, converted_a, converted_b);
-                } else {
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::INT);
-                    EmitInstruction(dest, OpCode::ADD, a, b);
-                }
-                break;
-            case TokenType::MINUS:
-                StepForward();
-                a = dest;
-                b = ParseFactor();
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Subtraction is only possible between integers or floats.");
-                }
-
-                // Convert to float if one of the two are floats.
-                if (GetType(a).value() != GetType(b).value()) {
-                    converted_a = ConvertType(a, PrimitiveType::REAL);
-                    converted_b = ConvertType(b, PrimitiveType::REAL);
-
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::REAL);
-
-                    EmitInstruction(dest, OpCode::FSUB, converted_a, converted_b);
-                } else {
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::INT);
-                    EmitInstruction(dest, OpCode::SUB, a, b);
-                }
-                break;
-            default: return dest;
-        }
-    }
-    return dest;
-}
+            dest = { num_gen_.GenerateTemp(), PrimitiveType::BOOL };
 
-// Grammar: factor -> unary ( (* | /) unary )*
-auto Parser::ParseFactor() -> Address {
-    Address dest = ParseUnary();
-    for (;;) {
-        Token &tok = **current_;
-        Address a;
-        Address b;
-        Address converted_a;
-        Address converted_b;
-
-        switch (tok.type_) {
-            case TokenType::STAR:
-                StepForward();
-                a = dest;
-                b = ParseUnary();
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Multiplication is only possible between integers or floats.");
-                }
-
-                // Convert to float if one of the two are floats.
-                if (GetType(a).value() != GetType(b).value()) {
-                    converted_a = ConvertType(a, PrimitiveType::REAL);
-                    converted_b = ConvertType(b, PrimitiveType::REAL);
-
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::REAL);
-
-                    EmitInstruction(dest, OpCode::FMULT, converted_a, converted_b);
-                } else {
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::INT);
-                    EmitInstruction(dest, OpCode::MULT, a, b);
-                }
-                break;
-            case TokenType::SLASH:
-                StepForward();
-                a = dest;
-                b = ParseUnary();
-                if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
-                    Error("Division is only possible between integers or floats.");
-                }
-
-                // Convert to float if one of the two are floats.
-                if (GetType(a).value() != GetType(b).value()) {
-                    converted_a = ConvertType(a, PrimitiveType::REAL);
-                    converted_b = ConvertType(b, PrimitiveType::REAL);
-
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::REAL);
-
-                    EmitInstruction(dest, OpCode::FDIV, converted_a, converted_b);
-                } else {
-                    dest = num_gen_.GenerateTemp();
-                    AddToTable(dest, PrimitiveType::INT);
-                    EmitInstruction(dest, OpCode::DIV, a, b);
-                }
-                break;
-            default:
-                return dest;
-        }
+            EmitInstruction(dest.address_, type == PrimitiveType::REAL ? rule.real_op_ : rule.int_op_, a.address_,
+                            b.address_);
+            break;
+        case OperandKind::ARITHMETIC:
+            type = GetType(a).value();
+            if (type != PrimitiveType::INT && type != PrimitiveType::REAL) {
+                Error(rule.type_error_);
+            }
+
+            // Convert to float if one of the two are floats.
+            if (type != GetType(b).value()) {
+                converted_a = ConvertType(a, PrimitiveType::REAL);
+                converted_b = ConvertType(b, PrimitiveType::REAL);
+
+                dest = { num_gen_.GenerateTemp(), PrimitiveType::REAL };
+
+                EmitInstruction(dest.address_, rule.real_op_, converted_a.address_, converted_b.address_);
+            } else {
+                dest = { num_gen_.GenerateTemp(), type };
+                EmitInstruction(dest.address_, type == PrimitiveType::REAL ? rule.real_op_ : rule.int_op_,
+                                a.address_, b.address_);
+            }
+            break;
     }
     return dest;
 }
 
 // Grammar: unary -> - unary | primary
-auto Parser::ParseUnary() -> Address {
+auto Parser::ParseUnary() -> Operand {
     TokenType op = current_->get()->type_;
 
     if (op == TokenType::MINUS) {
+        NestingScope nesting(expression_depth_);
+        CheckExpressionDepth();
         StepForward();
 
-        Address a = ParseUnary();
+        Operand a = ParseUnary();
 
         if (GetType(a).value() != PrimitiveType::INT && GetType(a).value() != PrimitiveType::REAL) {
             Error("Negation is only possible on integers or floats.");
         }
         
-        Address temp = EmitConstInstruction(0, GetType(a).value());
-        Address dest = num_gen_.GenerateTemp();
-        AddToTable(dest, GetType(a).value());
-        
-        EmitInstruction(dest, OpCode::SUB, temp, a);
+        bool is_real = GetType(a).value() == PrimitiveType::REAL;
+        Operand dest = { num_gen_.GenerateTemp(), a.type_ };
+
+        EmitInstruction(dest.address_, is_real ? OpCode::FNEG : OpCode::NEG, a.address_);
         return dest;
     }
     return ParsePrimary();
@@ -807,10 +788,10 @@ auto Parser::ParseUnary() -> Address {
 // Grammar:
 //      primary -> TRUE | FALSE | INT | REAL | IDENTIFIER
 //              | "(" expression ")"
-auto Parser::ParsePrimary() -> Address {
+auto Parser::ParsePrimary() -> Operand {
     TokenType a = current_->get()->type_;
 
-    Address dest;
+    Operand dest;
     ValueToken<std::string> *b;
 
     ValueToken<float> *value_float;
@@ -850,8 +831,11 @@ auto Parser::ParsePrimary() -> Address {
             b = dynamic_cast<ValueToken<std::string> *>(previous_->get());
             if (b == nullptr) {
                 ErrorAt(*previous_, "Unexpected token.");
+            } else if (const Symbol *symbol = symbols_.Lookup(b->value_)) {
+                dest = { symbol->address_, symbol->type_ };
             } else {
-                dest = b->value_;
+                // Undefined variables still print, as nil.
+                dest.address_ = b->value_;
             }
             break;
         case TokenType::LEFT_PAREN:
@@ -870,9 +854,9 @@ auto Parser::ParsePrimary() -> Address {
 
 // Grammar:
 // string -> ( TEXT | "${" expression "}" )* QUOTE
-auto Parser::ParseString() -> Address {
+auto Parser::ParseString() -> Operand {
     // TODO: Add support back for strings.
-    Address res;
+    Operand res;
     return res;
 
     // Address dest;
@@ -14,7 +14,11 @@ auto IsAlpha(char c) -> bool {
 
 /***** Member Methods ********/
 
-std::unordered_map<std::string, TokenType> reserved_keywords {
+namespace {
+
+// Read-only after static initialization, so scanners on different
+// threads can share them.
+const std::unordered_map<std::string_view, TokenType> RESERVED_KEYWORDS {
     { "and", TokenType::AND },
     { "class", TokenType::CLASS },
     { "else", TokenType::ELSE },
@@ -33,13 +37,15 @@ std::unordered_map<std::string, TokenType> reserved_keywords {
     { "while", TokenType::WHILE },
 };
 
-std::unordered_map<std::string, std::pair<PrimitiveType, int>> reserved_typenames {
+const std::unordered_map<std::string_view, std::pair<PrimitiveType, int>> RESERVED_TYPENAMES {
     { "int", { PrimitiveType::INT, _STRONK_INT_WIDTH } },
     { "real", { PrimitiveType::REAL, _STRONK_FLOAT_WIDTH } },
     { "char", { PrimitiveType::CHAR, 1 } },
     { "bool", { PrimitiveType::BOOL, 1 } }
 };
 
+} // namespace
+
 // Loads source into buffer.
 void Scanner::LoadSource(std::string_view source) {
     source_ = source;
@@ -48,6 +54,12 @@ void Scanner::LoadSource(std::string_view source) {
     current_ = source_.begin();
 }
 
+// Allocates tokens from `arena` from now on. Pass nullptr to go
+// back to the heap.
+void Scanner::SetArena(std::shared_ptr<Arena> arena) {
+    arena_ = std::move(arena);
+}
+
 // Scans next token found in buffer.
 auto Scanner::ScanNextToken() -> std::shared_ptr<Token> {
     // String mode should leave whitespace alone.
@@ -305,12 +317,12 @@ auto Scanner::ScanIdentifier() -> std::shared_ptr<Token> {
     }
     std::string id = oss.str();
 
-    if (reserved_keywords.find(id) != reserved_keywords.end()) {
-        return MakeToken(reserved_keywords[id]);
+    if (auto keyword = RESERVED_KEYWORDS.find(id); keyword != RESERVED_KEYWORDS.end()) {
+        return MakeToken(keyword->second);
     }
     
-    if (reserved_typenames.find(id) != reserved_typenames.end()) {
-        auto [type, width] = reserved_typenames[id];
+    if (auto type_name = RESERVED_TYPENAMES.find(id); type_name != RESERVED_TYPENAMES.end()) {
+        auto [type, width] = type_name->second;
         return MakeTypeToken(type, width);
     }
 
@@ -319,24 +331,24 @@ auto Scanner::ScanIdentifier() -> std::shared_ptr<Token> {
 
 // Helper method to build a token with `type`.
 auto Scanner::MakeToken(TokenType type) -> std::shared_ptr<Token> {
-    return std::make_unique<Token>(type, 0, line_);
+    return MakeShared<Token>(arena_, type, 0, line_);
 }
 
 // Helper method to build a value token: One that contains additional value
 // information.
 template <class T>
 auto Scanner::MakeToken(TokenType type, T value) -> std::shared_ptr<ValueToken<T>> {
-    return std::make_unique<ValueToken<T>>(type, 0, line_, value);
+    return MakeShared<ValueToken<T>>(arena_, type, 0, line_, value);
 }
 
 // Helper method to build a type token, One with two pieces of information -- name and width.
 auto Scanner::MakeTypeToken(PrimitiveType type, int width) -> std::shared_ptr<TypeToken> {
-    return std::make_unique<TypeToken>(TokenType::PRIMITIVE, 0, line_, type, width);
+    return MakeShared<TypeToken>(arena_, TokenType::PRIMITIVE, 0, line_, type, width);
 }
 
 // Helper method to build a token with error message.
 auto Scanner::MakeErrorToken(std::string message) -> std::shared_ptr<ValueToken<std::string>> {
-    return std::make_unique<ValueToken<std::string>>(TokenType::ERROR, 0, line_, std::move(message));
+    return MakeShared<ValueToken<std::string>>(arena_, TokenType::ERROR, 0, line_, std::move(message));
 }
 
 } // namespace "stronk"
\ No newline at end of file
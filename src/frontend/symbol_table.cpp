@@ -0,0 +1,73 @@
+#include "frontend/symbol_table.h"
+
+namespace stronk {
+
+void SymbolTable::EnterScope() {
+    scopes_.push_back(symbols_.size());
+}
+
+// Unbinds the declarations of the innermost scope, uncovering the
+// symbols they shadowed, and frees their slots.
+void SymbolTable::ExitScope() {
+    if (scopes_.empty()) {
+        return;
+    }
+    size_t begin = scopes_.back();
+    scopes_.pop_back();
+    while (symbols_.size() > begin) {
+        const Symbol &symbol = symbols_.back();
+        bindings_[symbol.name_] = symbol.shadowed_;
+        free_slots_[static_cast<size_t>(symbol.type_)].push_back(symbol.slot_);
+        symbols_.pop_back();
+    }
+}
+
+auto SymbolTable::Depth() const -> int {
+    return static_cast<int>(scopes_.size());
+}
+
+auto SymbolTable::Declare(const std::string &name, PrimitiveType type) -> const Symbol * {
+    int id = Intern(name);
+    int shadowed = bindings_[id];
+    size_t scope_begin = scopes_.empty() ? 0 : scopes_.back();
+    if (shadowed >= 0 && static_cast<size_t>(shadowed) >= scope_begin) {
+        return nullptr;
+    }
+
+    Symbol symbol = { name, type, -1, id, shadowed };
+    if (!scopes_.empty()) {
+        symbol.slot_ = AllocateSlot(type);
+        symbol.address_ = LOCAL_VAR_PREFIX + std::to_string(symbol.slot_);
+    }
+    bindings_[id] = static_cast<int>(symbols_.size());
+    symbols_.push_back(std::move(symbol));
+    return &symbols_.back();
+}
+
+auto SymbolTable::Lookup(const std::string &name) const -> const Symbol * {
+    auto it = names_.find(name);
+    if (it == names_.end() || bindings_[it->second] < 0) {
+        return nullptr;
+    }
+    return &symbols_[bindings_[it->second]];
+}
+
+auto SymbolTable::Intern(const std::string &name) -> int {
+    auto [it, inserted] = names_.try_emplace(name, static_cast<int>(bindings_.size()));
+    if (inserted) {
+        bindings_.push_back(-1);
+    }
+    return it->second;
+}
+
+auto SymbolTable::AllocateSlot(PrimitiveType type) -> int {
+    std::vector<int> &free = free_slots_[static_cast<size_t>(type)];
+    if (free.empty()) {
+        return next_slot_++;
+    }
+    int slot = free.back();
+    free.pop_back();
+    return slot;
+}
+
+} // namespace "stronk"
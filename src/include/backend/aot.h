@@ -0,0 +1,29 @@
+#ifndef _STRONK_AOT_H
+#define _STRONK_AOT_H
+
+#include <string>
+#include "backend/program.h"
+
+namespace stronk {
+
+// Ahead-of-time backend. A lowered program is translated into a
+// single self-contained C file: every register becomes a typed
+// local of `main`, jump targets become C labels and jumps become
+// gotos. Printing and runtime errors go through a few static
+// helpers emitted at the top of the file.
+//
+// Register types are inferred from the instructions that define
+// them; a register that is never defined prints as nil. Throws
+// std::invalid_argument when a register is defined with two
+// different types.
+auto TranslateToC(const Program &program) -> std::string;
+
+// Writes `c_source` next to `output` and runs the C compiler
+// `compiler` on it to produce the executable `output`. Returns
+// false when the compiler failed.
+auto CompileExecutable(const std::string &c_source, const std::string &output,
+                       const std::string &compiler = "cc") -> bool;
+
+} // namespace "stronk"
+
+#endif // _STRONK_AOT_H
@@ -0,0 +1,101 @@
+#ifndef _STRONK_HEAP_H
+#define _STRONK_HEAP_H
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "backend/object.h"
+
+namespace stronk {
+
+enum HEAP_CONSTANTS {
+    _STRONK_HEAP_SIZE_CLASSES = 6,      // 16, 32, ..., 512 byte blocks.
+    _STRONK_HEAP_MIN_BLOCK = 16,
+    _STRONK_HEAP_CHUNK_SIZE = 64 * 1024,
+    _STRONK_HEAP_MARK_BUDGET = 64,      // Gray objects traced per incremental step.
+    _STRONK_HEAP_GROW_FACTOR = 2,
+    _STRONK_HEAP_PAUSE_BUCKETS = 16     // Bucket i counts pauses below 2^i microseconds.
+};
+
+// Counters describing the heap, meant to be polled while a
+// long running script executes.
+struct HeapStats {
+    size_t bytes_allocated_ = 0;  // Bytes currently handed out (live and unswept garbage).
+    size_t live_bytes_ = 0;       // Bytes surviving the last completed collection.
+    size_t live_objects_ = 0;
+    size_t total_allocated_ = 0;  // Bytes handed out over the lifetime of the heap.
+    size_t collections_ = 0;
+    size_t mark_steps_ = 0;
+    std::chrono::nanoseconds total_pause_{0};
+    std::chrono::nanoseconds max_pause_{0};
+    std::array<size_t, _STRONK_HEAP_PAUSE_BUCKETS> pause_histogram_{};
+};
+
+// Precise, non-moving mark-sweep collector. Small objects are
+// carved out of chunks and recycled through per size class free
+// lists; large objects get their own allocation. Marking is
+// incremental: a cycle starts once the allocation threshold is
+// crossed and every later allocation traces a bounded amount of
+// the gray set. Roots are rescanned when the cycle finishes, so
+// only heap-to-heap stores need `WriteBarrier`.
+class Heap {
+public:
+    using RootMarker = std::function<void(Heap &)>;
+
+    explicit Heap(size_t initial_threshold = 1024 * 1024);
+    ~Heap();
+    Heap(const Heap &) = delete;
+    auto operator=(const Heap &) -> Heap & = delete;
+
+    void SetRootMarker(RootMarker marker);
+    auto AllocateString(std::string_view chars) -> ObjString *;
+
+    void MarkValue(const Value &val);
+    void MarkObject(Obj *obj);
+    void WriteBarrier(Obj *owner, const Value &val);
+
+    void Collect();
+    auto IsMarking() const -> bool;
+    auto GetStats() const -> const HeapStats &;
+    void DumpStats(std::ostream &out) const;
+private:
+    enum class Phase {
+        IDLE,
+        MARKING
+    };
+
+    struct FreeBlock {
+        FreeBlock *next_;
+    };
+
+    struct SizeClass {
+        FreeBlock *free_list_ = nullptr;
+        char *bump_ = nullptr;   // Unused tail of the newest chunk.
+        char *limit_ = nullptr;
+    };
+
+    RootMarker mark_roots_;
+    Phase phase_ = Phase::IDLE;
+    size_t next_gc_;
+    Obj *objects_ = nullptr;
+    std::vector<Obj *> gray_;
+    std::vector<void *> chunks_;
+    std::array<SizeClass, _STRONK_HEAP_SIZE_CLASSES> classes_;
+    HeapStats stats_;
+
+    auto AllocateBlock(size_t size, uint8_t &size_class) -> void *;
+    void FreeObject(Obj *obj);
+    void BeginCycle();
+    void MarkStep(size_t budget);
+    void FinishCycle();
+    void Blacken(Obj *obj);
+    void Sweep();
+    void RecordPause(std::chrono::steady_clock::time_point start);
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_HEAP_H
@@ -0,0 +1,48 @@
+#ifndef _STRONK_JIT_H
+#define _STRONK_JIT_H
+
+#include <cstddef>
+#include <memory>
+#include "backend/program.h"
+#include "common/value.h"
+
+namespace stronk {
+
+class VirtualMachine;
+
+// Signature of compiled code. Returns the index of the instruction
+// the interpreter should resume at (the program size once it ran
+// to completion), or -1 after a runtime error was reported.
+using JitFunction = int (*)(Value *registers, VirtualMachine *vm);
+
+// Executable memory holding the machine code of one program or
+// region of a program.
+class JitCode {
+private:
+    void *memory_;
+    size_t size_;
+public:
+    JitCode(void *memory, size_t size) : memory_(memory), size_(size) {}
+    ~JitCode();
+    JitCode(const JitCode &) = delete;
+    auto operator=(const JitCode &) -> JitCode & = delete;
+
+    auto Entry() const -> JitFunction;
+    auto Size() const -> size_t;
+};
+
+// Baseline compiler from a lowered program to x86-64. Every
+// register stays in its frame slot in memory; instructions are
+// translated one at a time with no register allocation.
+// Instructions without a native translation (e.g. PRINT) call
+// back into the VM.
+class JitCompiler {
+public:
+    static auto IsSupported() -> bool;
+    auto Compile(const Program &program, const ValueArray &constants) -> std::unique_ptr<JitCode>;
+    auto CompileRegion(const Program &program, const ValueArray &constants, int begin, int end) -> std::unique_ptr<JitCode>;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_JIT_H
@@ -0,0 +1,50 @@
+#ifndef _STRONK_OBJECT_H
+#define _STRONK_OBJECT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "common/value.h"
+
+namespace stronk {
+
+enum class ObjType : uint8_t {
+    STRING
+};
+
+// Header shared by every heap allocated value. Objects are
+// threaded onto the heap's object list so the sweeper can find
+// them without a separate table.
+struct Obj {
+    ObjType type_;
+    bool marked_ = false;
+    uint8_t size_class_ = 0;
+    size_t size_ = 0;
+    Obj *next_ = nullptr;
+
+    explicit Obj(ObjType type) : type_(type) {}
+};
+
+// Immutable string. The characters are stored inline directly
+// after the header in the same allocation.
+struct ObjString : public Obj {
+    size_t length_;
+
+    explicit ObjString(size_t length) : Obj(ObjType::STRING), length_(length) {}
+
+    auto Chars() -> char * { return reinterpret_cast<char *>(this + 1); }
+    auto Chars() const -> const char * { return reinterpret_cast<const char *>(this + 1); }
+    auto View() const -> std::string_view { return { Chars(), length_ }; }
+};
+
+inline auto IsString(const Value &val) -> bool {
+    return val.IsObj() && val.as_.obj_->type_ == ObjType::STRING;
+}
+
+inline auto AsString(const Value &val) -> ObjString * {
+    return static_cast<ObjString *>(val.as_.obj_);
+}
+
+} // namespace "stronk"
+
+#endif // _STRONK_OBJECT_H
@@ -0,0 +1,37 @@
+#ifndef _STRONK_OPTIMIZER_H
+#define _STRONK_OPTIMIZER_H
+
+#include "backend/program.h"
+
+namespace stronk {
+
+// Folds `t = op ...; x = ID t` into `x = op ...` when the
+// temporary `t` has no other use. The copy is left as a LABEL
+// no-op, so jump targets keep their meaning.
+void CoalesceCopies(Program &program, int begin, int end);
+
+// Removes I2F / F2I work the parser's per-use conversions leave
+// behind. A conversion of a constant becomes a constant, and a
+// conversion repeated while its source is unchanged on every path
+// reuses the earlier result. Round trips like F2I(I2F(x)) are only
+// exact for constants, which the first rule already folds. Run on
+// whole programs while lowering, before immediates are folded.
+void EliminateConversions(Program &program);
+
+// Retargets a BR whose side lands on another BR of the same
+// register to where that one goes, since the value is known there.
+// Chains of short-circuit operators then jump straight out instead
+// of testing their merge register once per operator.
+void ThreadBranches(Program &program);
+
+// Fuses pairs that dominate the opcode pair profile: int compare +
+// BR into compare-and-branch, multiply + add into MADD / FMADD, and
+// `x = x + k` before a compare-and-branch on x into INCBLT and
+// friends. Jumps to a conditional branch are replaced by a copy of
+// it. Run once on whole programs while lowering; the instructions
+// consumed are left as LABEL no-ops.
+void SelectSuperinstructions(Program &program);
+
+} // namespace "stronk"
+
+#endif // _STRONK_OPTIMIZER_H
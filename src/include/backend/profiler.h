@@ -0,0 +1,116 @@
+#ifndef _STRONK_PROFILER_H
+#define _STRONK_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "backend/program.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace stronk {
+
+enum PROFILER_CONSTANTS {
+    _STRONK_PROFILE_SAMPLE_PERIOD = 64,  // Block entries between two timed blocks.
+    _STRONK_PROFILE_REPORT_LIMIT = 20    // Rows per section in the report.
+};
+
+// Time stamp counter, or a nanosecond clock where there is none.
+inline auto ReadCycleCounter() -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// A basic block of a profiled program: instructions [begin_, end_).
+struct BlockProfile {
+    int begin_ = 0;
+    int end_ = 0;
+    int first_line_ = 0;
+    int last_line_ = 0;
+    uint64_t executions_ = 0;
+    uint64_t sampled_cycles_ = 0;
+    uint64_t samples_ = 0;
+
+    auto AverageCycles() const -> double {
+        return samples_ == 0 ? 0.0 : static_cast<double>(sampled_cycles_) / samples_;
+    }
+    auto EstimatedCycles() const -> double { return AverageCycles() * executions_; }
+};
+
+// Two instructions executed back to back: the candidates for
+// superinstructions.
+using OpCodePair = std::pair<OpCode, OpCode>;
+
+// Execution profile of the interpreter. The VM only calls into the
+// profiler in builds configured with STRONK_VM_PROFILE, so the hooks
+// cost nothing otherwise.
+//
+// Every executed instruction bumps a counter indexed by its
+// position; opcode, opcode pair and line counts are derived from
+// those when the program finishes. Block times are sampled: every
+// _STRONK_PROFILE_SAMPLE_PERIOD-th block entry reads the cycle
+// counter and charges the cycles until the next block entry to the
+// block.
+class Profiler {
+public:
+    void Reset(const Program &program);
+    void Flush();
+
+    inline void OnInstr(int pc) {
+        counts_[pc]++;
+        if (int block = block_of_[pc]; block >= 0) {
+            EnterBlock(block);
+        }
+    }
+
+    auto GetOpcodeCounts() const -> const std::map<OpCode, uint64_t> & { return opcode_counts_; }
+    auto GetPairCounts() const -> const std::map<OpCodePair, uint64_t> & { return pair_counts_; }
+    auto GetLineCounts() const -> const std::map<int, uint64_t> & { return line_counts_; }
+    auto GetBlocks() const -> const std::vector<BlockProfile> & { return blocks_; }
+    void Report(std::ostream &out, size_t limit = _STRONK_PROFILE_REPORT_LIMIT) const;
+private:
+    const Program *program_ = nullptr;
+    std::vector<uint64_t> counts_;
+    std::vector<int> block_of_;           // Block index of leaders, -1 elsewhere.
+    std::vector<BlockProfile> current_;   // Blocks of the running program.
+    int timed_block_ = -1;
+    uint64_t timed_start_ = 0;
+    int countdown_ = _STRONK_PROFILE_SAMPLE_PERIOD;
+
+    // Totals over every program run so far.
+    std::map<OpCode, uint64_t> opcode_counts_;
+    std::map<OpCodePair, uint64_t> pair_counts_;
+    std::map<int, uint64_t> line_counts_;
+    std::vector<BlockProfile> blocks_;
+    uint64_t total_instrs_ = 0;
+
+    inline void EnterBlock(int block) {
+        if (timed_block_ >= 0) {
+            StopTiming();
+        }
+        if (--countdown_ == 0) {
+            countdown_ = _STRONK_PROFILE_SAMPLE_PERIOD;
+            timed_block_ = block;
+            timed_start_ = ReadCycleCounter();
+        }
+    }
+
+    inline void StopTiming() {
+        current_[timed_block_].sampled_cycles_ += ReadCycleCounter() - timed_start_;
+        current_[timed_block_].samples_++;
+        timed_block_ = -1;
+    }
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_PROFILER_H
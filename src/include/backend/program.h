@@ -0,0 +1,114 @@
+#ifndef _STRONK_PROGRAM_H
+#define _STRONK_PROGRAM_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "common/instruction.h"
+#include "compiler/constant_pool.h"
+#include "frontend/code_generator.h"
+
+namespace stronk {
+
+// A single lowered instruction. Addresses are resolved to
+// register slots and labels to instruction indices, so the
+// execution engines never touch strings.
+//
+//  - Pure instructions: dest_ = op(a_, b_).
+//  - Immediate forms (ADDI, LTI, ...): dest_ = op(a_, k) where
+//    b_ holds k itself, not a register.
+//  - MADD, FMADD: dest_ = a_ * b_ + c_.
+//  - CONST: dest_ = constants_[a_].
+//  - JMP: goto target_.
+//  - BR: a_ ? goto target_ : goto alt_.
+//  - Compare-and-branch (BLT, BLTI, ...): a_ <op> b_ ? goto
+//    target_ : goto alt_.
+//  - INCBLT, INCBLTI, ...: a_ += c_ (an immediate), then branch
+//    on a_ <op> b_. dest_ is a_.
+//  - PRINT: prints operands_[a_ .. a_ + b_).
+struct ProgramInstr {
+    OpCode code_;
+    int dest_ = -1;
+    int a_ = -1;
+    int b_ = -1;
+    int c_ = -1;
+    int target_ = -1;
+    int alt_ = -1;
+    int line_ = 0;
+};
+
+// Bytecode lowered into a flat, register based form. Global
+// variables occupy the first `globals_.size()` registers so the
+// VM can bind them to its persistent globals table; block locals
+// and temporaries follow.
+//
+// `verified_` is set once VerifyProgram accepted the program; it is
+// not part of cached images, which are verified again on load.
+struct Program {
+    std::vector<ProgramInstr> code_;
+    std::vector<int> operands_;
+    std::vector<ConstantPool::ConstantValue> constants_;
+    std::vector<std::string> globals_;
+    int num_registers_ = 0;
+    bool verified_ = false;
+};
+
+// Whether `b_` of instructions with `code` is an immediate.
+auto HasImmediate(OpCode code) -> bool;
+
+// Whether instructions with `code` jump to `target_`, and unless
+// they are a JMP, to `alt_` otherwise.
+auto IsBranch(OpCode code) -> bool;
+
+// Calls `fn` with every register field of `instr`, destination
+// first. PRINT reads its registers through the operand list.
+template <class InstrT, class Fn>
+void ForEachRegister(InstrT &instr, Fn &&fn) {
+    switch (instr.code_) {
+        case OpCode::LABEL:
+        case OpCode::JMP:
+        case OpCode::PRINT:
+            return;
+        case OpCode::CONST:
+            fn(instr.dest_);
+            return;
+        case OpCode::BR:
+            fn(instr.a_);
+            return;
+        case OpCode::MADD:
+        case OpCode::FMADD:
+            fn(instr.dest_);
+            fn(instr.a_);
+            fn(instr.b_);
+            fn(instr.c_);
+            return;
+        default:
+            break;
+    }
+    if (!IsBranch(instr.code_) || instr.dest_ >= 0) {
+        fn(instr.dest_);
+    }
+    fn(instr.a_);
+    if (instr.b_ != -1 && !HasImmediate(instr.code_)) {
+        fn(instr.b_);
+    }
+}
+
+// Float immediates are stored as their bit pattern.
+inline auto EncodeReal(float val) -> int {
+    int bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return bits;
+}
+
+inline auto DecodeReal(int bits) -> float {
+    float val;
+    std::memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+auto LowerBytecode(const Bytecode &bytecode, const ConstantPool &constant_pool) -> Program;
+
+} // namespace "stronk"
+
+#endif // _STRONK_PROGRAM_H
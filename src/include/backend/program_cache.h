@@ -0,0 +1,52 @@
+#ifndef _STRONK_PROGRAM_CACHE_H
+#define _STRONK_PROGRAM_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "backend/program.h"
+
+namespace stronk {
+
+enum PROGRAM_CACHE_CONSTANTS {
+    // Bump whenever the frontend or the lowering changes the code
+    // generated for a given source, so stale entries are ignored.
+    _STRONK_COMPILER_VERSION = 7
+};
+
+// Binary image of a lowered program. The fixed size header is
+// followed by the instruction array exactly as laid out in memory
+// (jump targets already resolved and the line table inline), the
+// PRINT operand array, the constants and the global names. Loading
+// copies the two arrays in bulk; only constants and names are
+// decoded one by one.
+auto SerializeProgram(const Program &program, uint64_t source_hash) -> std::string;
+auto DeserializeProgram(const char *data, size_t size, uint64_t source_hash) -> std::optional<Program>;
+
+// Content hash (64-bit FNV-1a) of a source file.
+auto HashSource(std::string_view source) -> uint64_t;
+
+// Directory of serialized programs keyed by the source hash and
+// the compiler version. Entries are written to a temporary file
+// and renamed into place, so concurrent runs never observe a
+// partial entry.
+class ProgramCache {
+public:
+    explicit ProgramCache(std::filesystem::path directory) : directory_(std::move(directory)) {}
+
+    // $STRONK_CACHE_DIR, else $XDG_CACHE_HOME/stronk, else
+    // ~/.cache/stronk.
+    static auto DefaultDirectory() -> std::filesystem::path;
+
+    auto Load(std::string_view source) const -> std::optional<Program>;
+    auto Store(std::string_view source, const Program &program) const -> bool;
+    auto EntryPath(std::string_view source) const -> std::filesystem::path;
+private:
+    std::filesystem::path directory_;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_PROGRAM_CACHE_H
@@ -0,0 +1,103 @@
+#ifndef _STRONK_SAMPLER_H
+#define _STRONK_SAMPLER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include "backend/program.h"
+
+namespace stronk {
+
+enum SAMPLER_CONSTANTS {
+    _STRONK_SAMPLE_RING_SIZE = 1 << 16,  // Must be a power of two.
+    _STRONK_SAMPLE_DEFAULT_HZ = 1000
+};
+
+// Single producer, single consumer ring of samples. The producer
+// is the SIGPROF handler, so pushing never blocks or allocates;
+// samples are dropped when the ring is full.
+class SampleRing {
+public:
+    auto Push(uint64_t sample) -> bool {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == _STRONK_SAMPLE_RING_SIZE) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        samples_[head & (_STRONK_SAMPLE_RING_SIZE - 1)] = sample;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto Pop(uint64_t &sample) -> bool {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        sample = samples_[tail & (_STRONK_SAMPLE_RING_SIZE - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto Size() const -> uint32_t {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    auto Dropped() const -> uint64_t { return dropped_.load(std::memory_order_relaxed); }
+private:
+    std::array<uint64_t, _STRONK_SAMPLE_RING_SIZE> samples_{};
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Statistical profiler driven by setitimer(ITIMER_PROF). The VM
+// publishes the index of the instruction it is executing (and
+// whether it runs compiled code); on every SIGPROF the handler
+// pushes that location into the ring. The VM drains the ring while
+// the program is still loaded and attributes samples to source
+// lines, producing collapsed stacks for flamegraph tools.
+//
+// Only one sampler can run per process.
+class SamplingProfiler {
+public:
+    static constexpr int IDLE = -1;
+
+    SamplingProfiler() = default;
+    ~SamplingProfiler();
+    SamplingProfiler(const SamplingProfiler &) = delete;
+    auto operator=(const SamplingProfiler &) -> SamplingProfiler & = delete;
+
+    static auto IsSupported() -> bool;
+    auto Start(int hz = _STRONK_SAMPLE_DEFAULT_HZ) -> bool;
+    void Stop();
+
+    // Called by the VM. `Enter` is a relaxed store so it can run on
+    // every instruction.
+    inline void Enter(int pc) { pc_.store(pc, std::memory_order_relaxed); }
+    inline void EnterNative(int pc) { native_.store(true, std::memory_order_relaxed); Enter(pc); }
+    inline void Leave() { native_.store(false, std::memory_order_relaxed); Enter(IDLE); }
+    inline auto ShouldDrain() const -> bool { return ring_.Size() >= _STRONK_SAMPLE_RING_SIZE / 2; }
+    void Drain(const Program &program);
+
+    auto GetSamples() const -> uint64_t { return samples_; }
+    auto GetDropped() const -> uint64_t { return ring_.Dropped(); }
+    void WriteCollapsed(std::ostream &out) const;
+private:
+    SampleRing ring_;
+    std::atomic<int> pc_{IDLE};
+    std::atomic<bool> native_{false};
+    bool running_ = false;
+
+    std::map<std::string, uint64_t> stacks_;
+    uint64_t samples_ = 0;
+
+    static void OnSignal(int signal);
+    void Record();
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_SAMPLER_H
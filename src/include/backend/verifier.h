@@ -0,0 +1,33 @@
+#ifndef _STRONK_VERIFIER_H
+#define _STRONK_VERIFIER_H
+
+#include <optional>
+#include <string>
+#include "backend/program.h"
+
+namespace stronk {
+
+// Checks a lowered program once, in a single pass, so the engines
+// can run it without validating anything per instruction:
+//
+//  - every register, operand, constant index and branch target is
+//    within the bounds of the program and its frame,
+//  - every register other than a global is written before, in
+//    program order, any instruction that reads it,
+//  - a register keeps one type over all its definitions and
+//    operands have the type their opcode family implies (ADD reads
+//    ints, FADD reals, BR a bool, EQ two of a kind but not reals,
+//    ...),
+//  - only opcodes the engines implement are used.
+//
+// Globals read before this program writes them come from earlier
+// programs of the session, which the compiler already type checked,
+// so they are accepted with any type.
+//
+// Returns a description of the first problem found, or nothing when
+// the program is valid.
+auto VerifyProgram(const Program &program) -> std::optional<std::string>;
+
+} // namespace "stronk"
+
+#endif // _STRONK_VERIFIER_H
@@ -1,18 +1,111 @@
 #ifndef _STRONK_VM_H
 #define _STRONK_VM_H
 
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "backend/heap.h"
+#include "backend/jit.h"
+#include "backend/profiler.h"
+#include "backend/program.h"
+#include "backend/sampler.h"
+#include "common/common.h"
+#include "common/trace.h"
+#include "common/value.h"
 #include "frontend/code_generator.h"
 
 namespace stronk {
 
+enum class ExecutionEngine {
+    INTERPRETER,
+    JIT,
+    TIERED
+};
+
+enum class InterpretResult {
+    OK,
+    COMPILE_ERROR,
+    RUNTIME_ERROR
+};
+
+struct TieringStats {
+    size_t regions_compiled_ = 0;
+    size_t osr_entries_ = 0;
+};
+
+// Register based interpreter. Each call to `Interpret` lowers
+// the bytecode into a `Program` and runs it against a fresh
+// register frame; named variables persist across calls in the
+// globals table.
+//
+// In tiered mode the interpreter counts loop back-edges. Once a
+// loop crosses the tier-up threshold its region is compiled, and
+// execution transfers into the compiled code at the loop header.
+// Compiled code works directly on the register frame, so no state
+// has to be copied on entry or exit.
+//
+// Tier-up only compiles; it runs no optimizing passes of its own.
+// The passes are linear and run once on every program while
+// lowering, because the interpreter tier depends on their
+// superinstructions and immediates too. Both tiers therefore run
+// the same code, and short scripts pay those passes as well.
 class VirtualMachine {
 private:
-    Bytecode bytecode_;
+    std::ostream *out_;
+    ExecutionEngine engine_ = ExecutionEngine::INTERPRETER;
+    Heap heap_;
+    Program program_;
+    ValueArray constants_;
+    ValueArray registers_;
+    std::unordered_map<std::string, Value> globals_;
+
+    // Tiered execution state, reset for every program.
+    uint32_t tier_up_threshold_ = 1000;
+    std::vector<uint32_t> backedge_counts_;
+    std::vector<std::unique_ptr<JitCode>> osr_code_;
+    TieringStats tiering_stats_;
+
+    // Only fed by the interpreter loop in STRONK_VM_PROFILE builds.
+    Profiler profiler_;
+    SamplingProfiler *sampler_ = nullptr;
+    Tracer *tracer_ = nullptr;
+    bool count_instructions_ = false;
+    uint64_t instructions_executed_ = 0;
+    uint64_t instruction_limit_ = 0;
+
+    void MarkRoots(Heap &heap);
+    void LoadConstants();
+    template <bool INSTRUMENTED>
+    auto Run() -> InterpretResult;
+    auto RunCompiled() -> std::optional<InterpretResult>;
+    auto OnBackEdge(int header, int jump) -> JitCode *;
+    template <bool INSTRUMENTED>
+    auto TakeBackEdge(int header, int jump) -> int;
+    void Print(const ProgramInstr &instr);
+    void PrintValue(const Value &val);
+    void RuntimeError(const ProgramInstr &instr, std::string_view message);
 public:
-    VirtualMachine() = default;
-    auto Interpret(Bytecode &bytecode) -> bool;
+    explicit VirtualMachine(std::ostream &out = std::cout);
+    void SetEngine(ExecutionEngine engine);
+    void SetTierUpThreshold(uint32_t threshold);
+    void SetSampler(SamplingProfiler *sampler);
+    void SetTracer(Tracer *tracer);
+    void SetCountInstructions(bool count);
+    void SetInstructionLimit(uint64_t limit);
+    auto Interpret(Module module) -> InterpretResult;
+    auto Execute(Program program) -> InterpretResult;
+    auto ExecuteSlowPath(int pc) -> bool;
+    auto GetGlobal(const std::string &name) const -> Value;
+    auto GetHeap() -> Heap &;
+    auto GetHeapStats() const -> const HeapStats &;
+    auto GetTieringStats() const -> const TieringStats &;
+    auto GetProfiler() const -> const Profiler &;
+    auto GetInstructionsExecuted() const -> uint64_t;
 };
 
 } // namespace "stronk"
 
-#endif // _STRONK_VM_H
\ No newline at end of file
+#endif // _STRONK_VM_H
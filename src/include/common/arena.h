@@ -0,0 +1,79 @@
+#ifndef _STRONK_ARENA_H
+#define _STRONK_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace stronk {
+
+enum ARENA_CONSTANTS {
+    _STRONK_ARENA_FIRST_CHUNK = 16 << 10
+};
+
+// Bump allocator for the data of one compilation. Memory comes from
+// a few growing chunks and is only returned, all at once, when the
+// arena is destroyed; deallocation is a no-op. Being a pmr memory
+// resource it can also back std::pmr containers.
+//
+// Not thread safe for allocation. Releasing objects from other
+// threads is fine since that does not touch the arena.
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t first_chunk = _STRONK_ARENA_FIRST_CHUNK);
+    Arena(const Arena &) = delete;
+    auto operator=(const Arena &) -> Arena & = delete;
+
+    // Bytes handed out so far.
+    auto Allocated() const -> size_t { return allocated_; }
+private:
+    std::pmr::monotonic_buffer_resource chunks_;
+    size_t allocated_ = 0;
+
+    auto do_allocate(size_t bytes, size_t alignment) -> void * override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override;
+};
+
+// Allocator over an arena that shares ownership of it, so objects
+// made with `MakeShared` keep their arena alive even when they
+// outlive the compiler that made them.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) : arena_(std::move(arena)) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_) {}
+
+    auto allocate(size_t n) -> T * {
+        return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *ptr, size_t n) {
+        arena_->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template <class U>
+    auto operator==(const ArenaAllocator<U> &other) const -> bool { return arena_ == other.arena_; }
+    template <class U>
+    auto operator!=(const ArenaAllocator<U> &other) const -> bool { return arena_ != other.arena_; }
+private:
+    template <class U> friend class ArenaAllocator;
+    std::shared_ptr<Arena> arena_;
+};
+
+// Object and control block in one arena allocation, or a plain
+// make_shared without an arena.
+template <class T, class... Args>
+auto MakeShared(const std::shared_ptr<Arena> &arena, Args &&...args) -> std::shared_ptr<T> {
+    if (arena == nullptr) {
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+} // namespace "stronk"
+
+#endif // _STRONK_ARENA_H
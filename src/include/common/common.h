@@ -1,9 +1,20 @@
 #ifndef _STRONK_COMMON_H
 #define _STRONK_COMMON_H
 
-// #define DEBUG_TRACE_EXECUTION
+// Counts executed instructions in the interpreter. Enabled with
+// -DSTRONK_VM_PROFILE=ON at configure time.
+#ifndef STRONK_VM_PROFILE
+#define STRONK_VM_PROFILE 0
+#endif
+
+// Counts allocations per compiler phase (see common/mem_stats.h).
+// Enabled with -DSTRONK_MEM_STATS=ON at configure time.
+#ifndef STRONK_MEM_STATS
+#define STRONK_MEM_STATS 0
+#endif
 
 #define TEMP_VAR_PREFIX "__stronk_temp"
+#define LOCAL_VAR_PREFIX "__stronk_local"
 
 namespace stronk {
 
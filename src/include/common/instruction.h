@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
 
 namespace stronk {
     
@@ -37,6 +38,12 @@ enum class OpCode {
     */
     DIV,
 
+    /** NEG x
+     * Args: x (int).
+     * Result: Returns 0 - x.
+    */
+    NEG,
+
     //// Float arithmetic ////
 
     /** FADD x y
@@ -63,6 +70,12 @@ enum class OpCode {
     */
     FDIV,
 
+    /** FNEG x
+     * Args: x (float).
+     * Result: Returns 0.0 - x.
+    */
+    FNEG,
+
     //// Comparison ////
     
     /** EQ x y
@@ -242,7 +255,108 @@ enum class OpCode {
      * Args: v (value index)
      * Result: Gets a value from constant pool and places it into <dest>.
     */
-    CONST
+    CONST,
+
+    //// Immediate operands ////
+    // Only produced when lowering: the second operand is a literal
+    // carried in the instruction instead of a register. Floats are
+    // carried as their bit pattern.
+
+    /** ADDI x k, SUBI x k, MULTI x k
+     * Args: x (int), k (int immediate).
+     * Result: Same as ADD, SUB and MULT with y = k.
+    */
+    ADDI,
+    SUBI,
+    MULTI,
+
+    /** EQI x k, NEQI x k, GTI x k, LTI x k, GEQI x k, LEQI x k
+     * Args: x (int), k (int immediate).
+     * Result: Same as the register comparison with y = k.
+    */
+    EQI,
+    NEQI,
+    GTI,
+    LTI,
+    GEQI,
+    LEQI,
+
+    /** FADDI x k, FSUBI x k, FMULTI x k, FDIVI x k
+     * Args: x (float), k (float immediate).
+     * Result: Same as FADD, FSUB, FMULT and FDIV with y = k.
+    */
+    FADDI,
+    FSUBI,
+    FMULTI,
+    FDIVI,
+
+    /** FEQI x k, FNEQI x k, FGTI x k, FLTI x k, FGEQI x k, FLEQI x k
+     * Args: x (float), k (float immediate).
+     * Result: Same as the register comparison with y = k.
+    */
+    FEQI,
+    FNEQI,
+    FGTI,
+    FLTI,
+    FGEQI,
+    FLEQI,
+
+    //// Superinstructions ////
+    // Only produced when lowering, for pairs that dominate the
+    // opcode pair profile. Booleans compare as the integers 0 and 1.
+
+    /** BEQ x y, L1, L2 (and BNEQ, BGT, BLT, BGEQ, BLEQ)
+     * Args: x (int), y (int).
+     * Labels: L1, L2
+     * Result: Jumps to L1 if the comparison holds, to L2 otherwise.
+    */
+    BEQ,
+    BNEQ,
+    BGT,
+    BLT,
+    BGEQ,
+    BLEQ,
+
+    /** BEQI x k, L1, L2 (and BNEQI, BGTI, BLTI, BGEQI, BLEQI)
+     * Args: x (int), k (int immediate).
+     * Labels: L1, L2
+     * Result: Same as the register form with y = k.
+    */
+    BEQI,
+    BNEQI,
+    BGTI,
+    BLTI,
+    BGEQI,
+    BLEQI,
+
+    /** MADD x y z
+     * Args: x (int), y (int), z (int).
+     * Result: Returns x * y + z.
+    */
+    MADD,
+
+    /** FMADD x y z
+     * Args: x (float), y (float), z (float).
+     * Result: Returns x * y + z, rounding the product first.
+    */
+    FMADD,
+
+    /** INCBLT x y k, L1, L2 (and INCBLEQ)
+     * Args: x (int), y (int), k (int immediate).
+     * Labels: L1, L2
+     * Result: Stores x + k into x, then jumps to L1 if x < y (x <= y)
+     * and to L2 otherwise.
+    */
+    INCBLT,
+    INCBLEQ,
+
+    /** INCBLTI x j k, L1, L2 (and INCBLEQI)
+     * Args: x (int), j (int immediate), k (int immediate).
+     * Labels: L1, L2
+     * Result: Same as the register form with y = j.
+    */
+    INCBLTI,
+    INCBLEQI
 };
 
 struct Instr {
@@ -263,10 +377,12 @@ struct Instr {
             case OpCode::SUB: return "SUB";
             case OpCode::MULT: return "MULT";
             case OpCode::DIV: return "DIV";
+            case OpCode::NEG: return "NEG";
             case OpCode::FADD: return "fADD";
             case OpCode::FSUB: return "fSUB";
             case OpCode::FMULT: return "fMULT";
             case OpCode::FDIV: return "fDIV";
+            case OpCode::FNEG: return "fNEG";
 
             case OpCode::F2I: return "FLOAT -> INT";
             case OpCode::I2F: return "INT -> FLOAT";
@@ -302,6 +418,45 @@ struct Instr {
 
             case OpCode::CONST: return "CONST";
 
+            case OpCode::ADDI: return "ADDI";
+            case OpCode::SUBI: return "SUBI";
+            case OpCode::MULTI: return "MULTI";
+            case OpCode::EQI: return "EQI";
+            case OpCode::NEQI: return "NEQI";
+            case OpCode::GTI: return "GTI";
+            case OpCode::LTI: return "LTI";
+            case OpCode::GEQI: return "GEQI";
+            case OpCode::LEQI: return "LEQI";
+            case OpCode::FADDI: return "fADDI";
+            case OpCode::FSUBI: return "fSUBI";
+            case OpCode::FMULTI: return "fMULTI";
+            case OpCode::FDIVI: return "fDIVI";
+            case OpCode::FEQI: return "fEQI";
+            case OpCode::FNEQI: return "fNEQI";
+            case OpCode::FGTI: return "fGTI";
+            case OpCode::FLTI: return "fLTI";
+            case OpCode::FGEQI: return "fGEQI";
+            case OpCode::FLEQI: return "fLEQI";
+
+            case OpCode::BEQ: return "BEQ";
+            case OpCode::BNEQ: return "BNEQ";
+            case OpCode::BGT: return "BGT";
+            case OpCode::BLT: return "BLT";
+            case OpCode::BGEQ: return "BGEQ";
+            case OpCode::BLEQ: return "BLEQ";
+            case OpCode::BEQI: return "BEQI";
+            case OpCode::BNEQI: return "BNEQI";
+            case OpCode::BGTI: return "BGTI";
+            case OpCode::BLTI: return "BLTI";
+            case OpCode::BGEQI: return "BGEQI";
+            case OpCode::BLEQI: return "BLEQI";
+            case OpCode::MADD: return "MADD";
+            case OpCode::FMADD: return "fMADD";
+            case OpCode::INCBLT: return "INCBLT";
+            case OpCode::INCBLEQ: return "INCBLEQ";
+            case OpCode::INCBLTI: return "INCBLTI";
+            case OpCode::INCBLEQI: return "INCBLEQI";
+
             default: return "UNKNOWN_INSTR";
         };
     };
@@ -311,7 +466,7 @@ struct Instr {
 struct LabelInstr : public Instr {
     Label label_;
 
-    explicit LabelInstr(Label &label, int line, int pos) : Instr(OpCode::LABEL, line, pos), label_(label) {}
+    explicit LabelInstr(Label label, int line, int pos) : Instr(OpCode::LABEL, line, pos), label_(std::move(label)) {}
 
     auto operator==(const Instr &other) const -> bool override {
         if (auto instr = dynamic_cast<const LabelInstr *>(&other)) {
@@ -332,7 +487,7 @@ struct ImpureInstr : public Instr {
     std::vector<Label> labels_;
     std::vector<Address> args_;
 
-    ImpureInstr(OpCode code, std::vector<Address> &args, std::vector<Label> &labels, int line, int pos) : Instr(code, line, pos), labels_(labels), args_(args) {}
+    ImpureInstr(OpCode code, std::vector<Address> args, std::vector<Label> labels, int line, int pos) : Instr(code, line, pos), labels_(std::move(labels)), args_(std::move(args)) {}
 
     virtual auto operator==(const Instr &other) const -> bool override {
         if (auto instr = dynamic_cast<const ImpureInstr *>(&other)) {
@@ -366,7 +521,7 @@ struct CallInstr : public Instr {
     int func_;
     std::vector<Address> args_;
 
-    CallInstr(Address &dest, std::vector<Address> &args, int func, int line, int pos) : Instr(OpCode::CALL, line, pos), dest_(dest), func_(func), args_(args) {}
+    CallInstr(Address dest, std::vector<Address> args, int func, int line, int pos) : Instr(OpCode::CALL, line, pos), dest_(std::move(dest)), func_(func), args_(std::move(args)) {}
 
     auto operator==(const Instr &other) const -> bool override {
         if (auto instr = dynamic_cast<const CallInstr *>(&other)) {
@@ -397,7 +552,7 @@ struct PureInstr : public Instr {
     Address dest_;
     std::vector<Address> args_;
 
-    PureInstr(OpCode code, Address &dest, std::vector<Address> &args, int line, int pos) : Instr(code, line, pos), dest_(dest), args_(args) {}
+    PureInstr(OpCode code, Address dest, std::vector<Address> args, int line, int pos) : Instr(code, line, pos), dest_(std::move(dest)), args_(std::move(args)) {}
     
     auto operator==(const Instr &other) const -> bool override {
         if (auto instr = dynamic_cast<const PureInstr *>(&other)) {
@@ -422,7 +577,7 @@ struct PhiInstr : public Instr {
     std::vector<Label> labels_;
     std::vector<Address> args_;
 
-    PhiInstr(Address &dest, std::vector<Address> &args, std::vector<Label> &labels, int line, int pos) : Instr(OpCode::PHI, line, pos), dest_(dest), labels_(labels), args_(args) {}
+    PhiInstr(Address dest, std::vector<Address> args, std::vector<Label> labels, int line, int pos) : Instr(OpCode::PHI, line, pos), dest_(std::move(dest)), labels_(std::move(labels)), args_(std::move(args)) {}
 
     auto operator==(const Instr &other) const -> bool override {
         if (auto instr = dynamic_cast<const PhiInstr *>(&other)) {
@@ -456,7 +611,7 @@ struct ConstInstr : public Instr {
     Address dest_;
     int index_;
 
-    ConstInstr(const Address &dest, int index, int line, int pos) : Instr(OpCode::CONST, line, pos), dest_(dest), index_(index) {}
+    ConstInstr(Address dest, int index, int line, int pos) : Instr(OpCode::CONST, line, pos), dest_(std::move(dest)), index_(index) {}
 
     auto operator==(const Instr &other) const -> bool override {
         if (auto instr = dynamic_cast<const ConstInstr *>(&other)) {
@@ -0,0 +1,72 @@
+#ifndef _STRONK_MEM_STATS_H
+#define _STRONK_MEM_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include "common/common.h"
+
+namespace stronk {
+
+enum class MemPhase : uint8_t {
+    OTHER,
+    SCANNER,
+    PARSER,
+    CODE_GENERATOR,
+    CONSTANT_POOL,
+    VM
+};
+
+enum MEM_STATS_CONSTANTS {
+    _STRONK_MEM_PHASES = 6
+};
+
+auto MemPhaseName(MemPhase phase) -> const char *;
+
+struct PhaseAllocations {
+    uint64_t allocations_ = 0;
+    uint64_t bytes_ = 0;
+};
+
+// Allocations made on one thread, by the phase that was active
+// when they happened. Counting needs a build configured with
+// -DSTRONK_MEM_STATS=ON, which replaces the global operator new;
+// otherwise every count stays zero.
+struct MemStats {
+    std::array<PhaseAllocations, _STRONK_MEM_PHASES> phases_ = {};
+
+    static constexpr auto Enabled() -> bool { return STRONK_MEM_STATS != 0; }
+    // Everything the calling thread allocated so far.
+    static auto Current() -> MemStats;
+
+    auto operator[](MemPhase phase) const -> const PhaseAllocations & {
+        return phases_[static_cast<size_t>(phase)];
+    }
+    auto operator-(const MemStats &other) const -> MemStats;
+    auto operator+=(const MemStats &other) -> MemStats &;
+    auto Total() const -> PhaseAllocations;
+    // Per phase table; `source_bytes` adds a bytes per source KB
+    // column.
+    void Report(std::ostream &out, size_t source_bytes = 0) const;
+};
+
+// Attributes the allocations of the calling thread to `phase`
+// until the scope ends. Free in builds without STRONK_MEM_STATS.
+class MemPhaseScope {
+public:
+    explicit MemPhaseScope(MemPhase phase);
+    ~MemPhaseScope();
+    MemPhaseScope(const MemPhaseScope &) = delete;
+    auto operator=(const MemPhaseScope &) -> MemPhaseScope & = delete;
+private:
+    MemPhase previous_;
+};
+
+#if !STRONK_MEM_STATS
+inline MemPhaseScope::MemPhaseScope(MemPhase) : previous_(MemPhase::OTHER) {}
+inline MemPhaseScope::~MemPhaseScope() = default;
+#endif
+
+} // namespace "stronk"
+
+#endif // _STRONK_MEM_STATS_H
@@ -0,0 +1,59 @@
+#ifndef _STRONK_THREAD_POOL_H
+#define _STRONK_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stronk {
+
+// Fixed size pool with one task deque per worker. Workers take
+// from the back of their own deque and, once it runs dry, steal
+// from the front of the others, so a few long tasks do not leave
+// the remaining workers idle. Tasks submitted from a worker go to
+// that worker's deque; others are spread round robin.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+
+    void Submit(Task task);
+    // Blocks until every submitted task has finished.
+    void Wait();
+    auto Size() const -> size_t { return workers_.size(); }
+    auto GetSteals() const -> size_t { return steals_.load(std::memory_order_relaxed); }
+private:
+    struct Queue {
+        std::mutex mutex_;
+        std::deque<Task> tasks_;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<size_t> steals_{0};
+
+    // Sleeping and completion tracking.
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    size_t queued_ = 0;
+    size_t pending_ = 0;
+    bool stopping_ = false;
+
+    void WorkerLoop(size_t index);
+    auto TakeTask(size_t index, Task &task) -> bool;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_THREAD_POOL_H
@@ -0,0 +1,76 @@
+#ifndef _STRONK_TRACE_H
+#define _STRONK_TRACE_H
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common/instruction.h"
+#include "common/value.h"
+
+namespace stronk {
+
+enum TRACE_CONSTANTS {
+    _STRONK_TRACE_BUFFER_SIZE = 64 * 1024
+};
+
+// Categories are bits so several can be selected at once.
+enum class TraceCategory : uint32_t {
+    TOKENS = 1 << 0,        // Tokens produced by the scanner.
+    IR = 1 << 1,            // Instructions emitted by the parser.
+    INSTRUCTIONS = 1 << 2,  // Instructions executed by the interpreter.
+    REGISTERS = 1 << 3      // Register writes in the interpreter.
+};
+
+// Binary trace log. Records are appended to an in-memory buffer
+// and written out in large chunks; `DecodeTrace` turns a log back
+// into text. Components hold a nullable `Tracer *` and check
+// `IsEnabled` before building a record, so a disabled tracer costs
+// one test outside the interpreter loop, and nothing inside it
+// since the VM picks an uninstrumented loop up front.
+//
+// Layout: the magic "STRKTRC1", then records starting with a
+// one byte kind. Integers are little endian.
+class Tracer {
+public:
+    explicit Tracer(std::ostream &out, uint32_t categories = 0);
+    ~Tracer();
+    Tracer(const Tracer &) = delete;
+    auto operator=(const Tracer &) -> Tracer & = delete;
+
+    // Parses a comma separated list such as "tokens,ir,instrs,regs"
+    // or "all".
+    static auto ParseCategories(std::string_view list) -> std::optional<uint32_t>;
+
+    void Enable(uint32_t categories) { categories_ |= categories; }
+    void Disable(uint32_t categories) { categories_ &= ~categories; }
+    inline auto IsEnabled(TraceCategory category) const -> bool {
+        return (categories_ & static_cast<uint32_t>(category)) != 0;
+    }
+
+    void Token(int line, std::string_view form);
+    void Ir(const Instr &instr);
+    void Instruction(int pc, OpCode code, int line);
+    void RegisterWrite(int pc, int reg, const Value &val);
+    void Flush();
+private:
+    std::ostream *out_;
+    uint32_t categories_;
+    std::vector<char> buffer_;
+
+    template <class T>
+    void Put(T val);
+    void PutString(std::string_view str);
+    void EndRecord();
+};
+
+// Writes one line of text per record of the log in `in`. Returns
+// false if the log is malformed.
+auto DecodeTrace(std::istream &in, std::ostream &out) -> bool;
+
+} // namespace "stronk"
+
+#endif // _STRONK_TRACE_H
@@ -5,6 +5,7 @@
 #include <string>
 #include "frontend/token.h"
 #include "compiler/compiler.h"
+#include "backend/vm.h"
 #include "common/instruction.h"
 #include "common/common.h"
 
@@ -12,8 +13,10 @@
 
 namespace stronk {
 
+auto ReadMockSource(const std::string &source) -> std::string;
 auto ReadTokensFromSource(const std::string &source) -> std::vector<std::shared_ptr<Token>>;
 auto ReadBytecodeFromTokens(const std::vector<std::shared_ptr<Token>> &tokens) -> Bytecode;
+auto InterpretSource(const std::string &source, ExecutionEngine engine = ExecutionEngine::INTERPRETER) -> std::string;
 auto BuildToken(TokenType token_type) -> std::shared_ptr<Token>;
 template <class T> auto BuildValueToken(TokenType token_type, const T &value) -> std::shared_ptr<ValueToken<T>>;
 auto BuildTypeToken(PrimitiveType type) -> std::shared_ptr<TypeToken>;
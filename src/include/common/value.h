@@ -1,36 +1,53 @@
 #ifndef _STRONK_VALUE_H
 #define _STRONK_VALUE_H
 
+#include <cstdint>
+#include <string>
 #include <vector>
 #include "common/common.h"
 
 namespace stronk {
 
-struct Value {
-    virtual ~Value() = default;
-};
-struct BoolValue : public Value {
-    bool val_;
-    explicit BoolValue(bool val) : val_(val) {} 
-};
-struct RealValue : public Value {
-    float val_;
-    explicit RealValue(float val) : val_(val) {} 
-};
-struct IntValue : public Value {
-    int val_;
-    explicit IntValue(int val) : val_(val) {} 
+struct Obj;
+
+enum class ValueType : uint8_t {
+    NIL,
+    BOOL,
+    INT,
+    REAL,
+    CHAR,
+    OBJ
 };
-struct CharValue : public Value {
-    char val_;
-    explicit CharValue(char val) : val_(val) {} 
+
+// A runtime value held in a register. Scalars are stored
+// inline while strings (and any later heap values) point into
+// the garbage collected heap.
+struct Value {
+    ValueType type_ = ValueType::NIL;
+    union {
+        uint64_t bits_;
+        bool bool_;
+        int int_;
+        float real_;
+        char char_;
+        Obj *obj_;
+    } as_ = {};
+
+    static auto Bool(bool val) -> Value { Value v; v.type_ = ValueType::BOOL; v.as_.bool_ = val; return v; }
+    static auto Int(int val) -> Value { Value v; v.type_ = ValueType::INT; v.as_.int_ = val; return v; }
+    static auto Real(float val) -> Value { Value v; v.type_ = ValueType::REAL; v.as_.real_ = val; return v; }
+    static auto Char(char val) -> Value { Value v; v.type_ = ValueType::CHAR; v.as_.char_ = val; return v; }
+    static auto Object(Obj *val) -> Value { Value v; v.type_ = ValueType::OBJ; v.as_.obj_ = val; return v; }
+
+    auto IsObj() const -> bool { return type_ == ValueType::OBJ; }
 };
-struct NilValue : public Value {};
 
 using ValueArray = std::vector<Value>;
 
-void PrintValue(Value val);
+// Formats a scalar value. Objects are formatted by the backend
+// that owns them.
+auto ScalarToString(const Value &val) -> std::string;
 
 } // namespace "stronk"
 
-#endif // _STRONK_VALUE_H
\ No newline at end of file
+#endif // _STRONK_VALUE_H
@@ -0,0 +1,42 @@
+#ifndef _STRONK_BATCH_COMPILER_H
+#define _STRONK_BATCH_COMPILER_H
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "backend/program_cache.h"
+
+namespace stronk {
+
+struct BatchFileResult {
+    std::filesystem::path path_;
+    size_t bytes_ = 0;
+    size_t instructions_ = 0;
+    bool ok_ = false;
+    std::chrono::nanoseconds elapsed_{0};
+};
+
+struct BatchResult {
+    std::vector<BatchFileResult> files_;
+    std::chrono::nanoseconds wall_{0};
+    size_t threads_ = 0;
+    size_t steals_ = 0;
+
+    auto Failures() const -> size_t;
+    auto TotalBytes() const -> size_t;
+};
+
+// Every .stronk file below `directory`, sorted.
+auto FindSources(const std::filesystem::path &directory) -> std::vector<std::filesystem::path>;
+
+// Compiles and lowers `files` concurrently, one Compiler per file,
+// on a work-stealing pool of `threads` workers. Successfully
+// compiled programs are stored in `cache` when one is given.
+// Results are in the order of `files`.
+auto CompileAll(const std::vector<std::filesystem::path> &files, size_t threads,
+                const ProgramCache *cache = nullptr) -> BatchResult;
+
+} // namespace "stronk"
+
+#endif // _STRONK_BATCH_COMPILER_H
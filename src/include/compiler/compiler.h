@@ -1,8 +1,12 @@
 #ifndef _STRONK_COMPILER_H
 #define _STRONK_COMPILER_H
 
+#include <ostream>
 #include <string>
+#include "common/arena.h"
 #include "common/common.h"
+#include "common/mem_stats.h"
+#include "common/trace.h"
 #include "frontend/scanner.h"
 #include "frontend/parser.h"
 
@@ -14,11 +18,20 @@ class Compiler {
 private:
     Scanner scanner_;
     Parser parser_;
-    Bytecode bytecode_;
+    Module module_;
+    std::shared_ptr<Arena> arena_;
+    Tracer *tracer_ = nullptr;
+    std::ostream *disassembly_ = nullptr;
+    MemStats mem_stats_;
 public:
     Compiler() = default;
     auto Compile(std::string_view source) -> bool;
-    auto GetBytecode() -> Bytecode;
+    void SetTracer(Tracer *tracer);
+    void SetDisassembly(std::ostream *out);
+    auto GetBytecode() const -> const Bytecode &;
+    auto GetConstantPool() const -> const ConstantPool &;
+    auto TakeModule() -> Module;
+    auto GetMemStats() const -> const MemStats &;
 };
 
 } // namespace "stronk"
@@ -11,7 +11,7 @@ namespace stronk {
 class ConstantPool {
 public:
     using ConstantValue = std::variant<int, float, char, bool, std::string>;
-    auto GetConstant(int id) -> ConstantValue;
+    auto GetConstant(int id) const -> ConstantValue;
     auto AddConstant(ConstantValue val) -> int;
     auto Size() const -> size_t;
 private:
@@ -0,0 +1,36 @@
+#ifndef _STRONK_MODULE_H
+#define _STRONK_MODULE_H
+
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "common/instruction.h"
+#include "compiler/constant_pool.h"
+
+namespace stronk {
+
+using Bytecode = std::vector<std::shared_ptr<Instr>>;
+
+// The output of one compilation: its instructions and the constant
+// pool their CONST instructions index into. Move only, so the code
+// is handed from the code generator to the compiler to the VM
+// without copying the instruction list.
+struct Module {
+    Bytecode code_;
+    ConstantPool constants_;
+
+    Module() = default;
+    Module(Bytecode code, ConstantPool constants);
+    Module(Module &&) = default;
+    auto operator=(Module &&) -> Module & = default;
+    Module(const Module &) = delete;
+    auto operator=(const Module &) -> Module & = delete;
+
+    // Writes one line per instruction, prefixed with its source
+    // line, in a single write.
+    void Disassemble(std::ostream &out) const;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_MODULE_H
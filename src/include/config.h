@@ -0,0 +1 @@
+#define BASE_DIR "/root/repo"
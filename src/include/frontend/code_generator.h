@@ -3,26 +3,28 @@
 
 #include <memory>
 
+#include "common/arena.h"
 #include "common/instruction.h"
 #include "common/value.h"
 #include "compiler/constant_pool.h"
+#include "compiler/module.h"
 
 namespace stronk {
 
-using Bytecode = std::vector<std::shared_ptr<Instr>>;
-
 class CodeGenerator {
 private:
     Bytecode bytecode_;
     ConstantPool constant_pool_;
+    std::shared_ptr<Arena> arena_;
     auto AddConstant(const Value &val) -> int;
 public:
     CodeGenerator() = default;
+    void SetArena(std::shared_ptr<Arena> arena);
+    auto GetArena() const -> const std::shared_ptr<Arena> & { return arena_; }
     void AddInstruction(const std::shared_ptr<Instr> &instr);
     void AddConstantInstruction(Address &dest, const ConstantPool::ConstantValue &value, int line, int pos);
     auto Size() -> size_t;
-    void DissasembleCode();
-    auto GetCode() -> Bytecode;
+    auto TakeModule() -> Module;
 };
 
 } // namespace "stronk"
@@ -5,17 +5,56 @@
 #include <optional>
 #include "common/common.h"
 #include "frontend/code_generator.h"
+#include "frontend/symbol_table.h"
 #include "frontend/token.h"
 #include "common/number_generator.h"
 
 namespace stronk {
 
+// Binding power of the binary operators, loosest first. NONE marks
+// tokens that end an operand chain.
+enum class Precedence : uint8_t {
+    NONE,
+    OR,
+    AND,
+    EQUALITY,
+    COMPARISON,
+    TERM,
+    FACTOR
+};
+
+struct BinaryRule;
+
+// The result of an expression: where it lives and its type, which
+// is missing for an undefined variable.
+struct Operand {
+    Address address_;
+    std::optional<PrimitiveType> type_;
+};
+
+enum PARSER_CONSTANTS {
+    _STRONK_MAX_EXPRESSION_DEPTH = 1000
+};
+
+// A statement whose body is still being parsed: a block (kind
+// LEFT_BRACE), an if or a while. `next_label_` is the false branch
+// of an if or the condition of a while.
+struct StatementFrame {
+    TokenType kind_;
+    int stage_ = 0;
+    Label next_label_;
+    Label exit_label_;
+};
+
 class Parser {
 public:
     Parser() = default;
     void AddToken(std::shared_ptr<Token> token);
     void Parse();
-    auto GetBytecode() -> Bytecode;
+    auto TakeModule() -> Module;
+    auto HadError() const -> bool;
+    void SetMaxExpressionDepth(int depth);
+    void SetArena(std::shared_ptr<Arena> arena);
 private:
     CodeGenerator cg_;
 
@@ -28,7 +67,12 @@ private:
     bool error_occurred_ = false;
     bool is_panic_mode_ = false; // Prevents cascade of errors.
 
-    std::unordered_map<std::string, PrimitiveType> symbol_table_;
+    // Unfinished statements, innermost last.
+    std::vector<StatementFrame> statements_;
+    int expression_depth_ = 0;
+    int max_expression_depth_ = _STRONK_MAX_EXPRESSION_DEPTH;
+
+    SymbolTable symbols_;
 
     // Utility methods
     void StepForward();
@@ -40,16 +84,12 @@ private:
     template <class T> auto ExtractValue(std::string_view message = "Unexpected token.") -> std::optional<T>;
 
     // Type Methods
-    auto ConvertType(Address source, PrimitiveType type2) -> Address;
-    auto GetType(Address source) -> std::optional<PrimitiveType>;
-
-    // Symbol Table
-    void AddToTable(Address dest, PrimitiveType type);
-    void UpdateTable(Address dest, PrimitiveType type);
+    auto ConvertType(const Operand &source, PrimitiveType type2) -> Operand;
+    auto GetType(const Operand &source) -> std::optional<PrimitiveType>;
 
     // Instruction Utilities
     template <typename... Args> void EmitInstruction(Address &dest, OpCode op, Args... args);
-    auto EmitConstInstruction(const ConstantPool::ConstantValue &val, PrimitiveType type) -> Address;
+    auto EmitConstInstruction(const ConstantPool::ConstantValue &val, PrimitiveType type) -> Operand;
     auto EmitConstInstruction(Address &dest, const ConstantPool::ConstantValue &val) -> Address;
     template <typename... Args> void EmitInstruction(OpCode op, Args... args);
     void EmitBr(Address cond, Label label1, Label label2);
@@ -58,6 +98,9 @@ private:
 
     // Parser methods
     void ParseDeclaration();
+    void BeginDeclaration();
+    void ResumeStatement();
+    void CheckExpressionDepth();
     auto ParseVarDeclaration() -> Address;
     void ParseStatement();
     void ParseExprStatement();
@@ -66,17 +109,14 @@ private:
     void ParseWhileStatement();
     void ParsePrintStatement();
     void ParseBlock();
-    auto ParseExpression() -> Address;
-    auto ParseAssignment() -> Address;
-    auto ParseLogicOr() -> Address;
-    auto ParseLogicAnd() -> Address;
-    auto ParseEquality() -> Address;
-    auto ParseComparison() -> Address;
-    auto ParseTerm() -> Address;
-    auto ParseFactor() -> Address;
-    auto ParseUnary() -> Address;
-    auto ParsePrimary() -> Address;
-    auto ParseString() -> Address;
+    auto ParseExpression() -> Operand;
+    auto ParseAssignment() -> Operand;
+    auto ParseBinary(Precedence precedence, const Address *merge = nullptr) -> Operand;
+    auto EmitBinary(const BinaryRule &rule, const Operand &a, const Operand &b) -> Operand;
+    auto ParseLogic(const BinaryRule &rule, const Operand &a, Precedence precedence, const Address *merge) -> Operand;
+    auto ParseUnary() -> Operand;
+    auto ParsePrimary() -> Operand;
+    auto ParseString() -> Operand;
 };
 
 } // namespace "stronk"
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <unordered_map>
 #include <memory>
+#include "common/arena.h"
 #include "common/common.h"
 #include "token.h"
 
@@ -34,6 +35,7 @@ private:
     std::string_view::iterator current_;
     ScannerMode mode_;
     int line_ = 1;
+    std::shared_ptr<Arena> arena_;
     
     auto MakeToken(TokenType type) -> std::shared_ptr<Token>;
     template <class T> auto MakeToken(TokenType type, T value) -> std::shared_ptr<ValueToken<T>>;
@@ -50,6 +52,7 @@ private:
 public:
     Scanner() = default;
     void LoadSource(std::string_view source);
+    void SetArena(std::shared_ptr<Arena> arena);
     auto ScanNextToken() -> std::shared_ptr<Token>;
 };
 
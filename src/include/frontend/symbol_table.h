@@ -0,0 +1,66 @@
+#ifndef _STRONK_SYMBOL_TABLE_H
+#define _STRONK_SYMBOL_TABLE_H
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common.h"
+#include "common/instruction.h"
+#include "frontend/token.h"
+
+namespace stronk {
+
+enum SYMBOL_TABLE_CONSTANTS {
+    _STRONK_PRIMITIVE_TYPES = 4
+};
+
+// A declared variable. Globals are addressed by their name, which
+// the VM uses to keep them alive between runs; block locals get an
+// integer slot and the register address of that slot.
+struct Symbol {
+    Address address_;
+    PrimitiveType type_;
+    int slot_;     // Local slot, -1 for globals.
+    int name_;     // Interned name.
+    int shadowed_; // Symbol hidden by this one, -1 if none.
+};
+
+// Named variables by scope. Names are interned once into dense ids
+// and every id points at its innermost symbol, so a lookup is one
+// hash of the name and declarations in a block are dropped again
+// at its end. Temporaries never enter the table; their types travel
+// with the parser's operands.
+//
+// Local slots freed at the end of a block are reused by later
+// locals of the same type, so a slot (and the register behind it)
+// always holds one type.
+class SymbolTable {
+public:
+    void EnterScope();
+    void ExitScope();
+    // 0 at the top level, where variables are global.
+    auto Depth() const -> int;
+
+    // Declares `name` in the innermost scope. Returns nullptr if it
+    // is already declared in that scope; outer ones are shadowed.
+    auto Declare(const std::string &name, PrimitiveType type) -> const Symbol *;
+    auto Lookup(const std::string &name) const -> const Symbol *;
+private:
+    std::unordered_map<std::string, int> names_;
+    // Innermost symbol per interned name, -1 when out of scope.
+    std::vector<int> bindings_;
+    // Symbols in scope, outermost first.
+    std::vector<Symbol> symbols_;
+    // Size of `symbols_` when each open scope was entered.
+    std::vector<size_t> scopes_;
+    std::array<std::vector<int>, _STRONK_PRIMITIVE_TYPES> free_slots_;
+    int next_slot_ = 0;
+
+    auto Intern(const std::string &name) -> int;
+    auto AllocateSlot(PrimitiveType type) -> int;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_SYMBOL_TABLE_H
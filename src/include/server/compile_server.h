@@ -0,0 +1,156 @@
+#ifndef _STRONK_COMPILE_SERVER_H
+#define _STRONK_COMPILE_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "backend/program.h"
+#include "backend/program_cache.h"
+#include "backend/vm.h"
+
+namespace stronk {
+
+enum COMPILE_SERVER_CONSTANTS {
+    _STRONK_SERVER_MAGIC = 0x5352544b,
+    _STRONK_SERVER_MAX_SOURCE = 16 << 20,
+    // Warm programs kept in memory and latencies kept for the
+    // percentiles in ServerStats.
+    _STRONK_SERVER_CACHE_ENTRIES = 4096,
+    _STRONK_SERVER_LATENCY_WINDOW = 4096,
+    // Idle clients are dropped after this many seconds so they
+    // cannot pin a worker.
+    _STRONK_SERVER_RECV_TIMEOUT = 5,
+    // Instructions a RUN request may execute before it fails with a
+    // runtime error, so a script that never ends cannot pin a worker.
+    _STRONK_SERVER_MAX_INSTRUCTIONS = 1000000000
+};
+
+enum class ServerRequestKind : uint8_t {
+    RUN,      // compile (or reuse) and execute, returning the output
+    COMPILE,  // compile into the warm cache only
+    STATS,    // formatted ServerStats
+    SHUTDOWN
+};
+
+enum class ServerStatus : uint8_t {
+    OK,
+    COMPILE_ERROR,
+    RUNTIME_ERROR,
+    BAD_REQUEST
+};
+
+struct ServerReply {
+    ServerStatus status_ = ServerStatus::BAD_REQUEST;
+    bool cache_hit_ = false;
+    // Time spent inside the server, from the decoded request to
+    // the encoded reply.
+    std::chrono::nanoseconds server_time_{0};
+    std::string output_;
+};
+
+struct ServerStats {
+    size_t requests_ = 0;
+    size_t cache_hits_ = 0;
+    size_t cache_misses_ = 0;
+    size_t compile_errors_ = 0;
+    size_t runtime_errors_ = 0;
+    size_t cached_programs_ = 0;
+    // Over the last _STRONK_SERVER_LATENCY_WINDOW requests.
+    std::chrono::nanoseconds p50_{0};
+    std::chrono::nanoseconds p99_{0};
+    std::chrono::nanoseconds max_{0};
+
+    auto ToString() const -> std::string;
+};
+
+// Long running compile server on a Unix domain socket. Lowered
+// programs stay in memory keyed by the source hash, so repeated
+// requests for the same script skip the frontend and lowering and
+// only pay for execution in a fresh VM. Misses fall back to the
+// on-disk program cache when one is given. Connections are served
+// on a thread pool; each connection may send any number of
+// requests.
+//
+// Diagnostics of failed compiles and runtime errors go to the
+// server's stderr; the client only receives the status.
+//
+// RUN requests execute under an instruction budget. A budgeted run
+// stays in the interpreter whatever engine was requested, since only
+// the interpreter counts instructions. A budget of 0 honours the
+// engine but lets a script that never ends hold its worker, and
+// with it a SHUTDOWN, forever.
+class CompileServer {
+public:
+    explicit CompileServer(std::filesystem::path socket_path, size_t threads = std::thread::hardware_concurrency(),
+                           const ProgramCache *disk_cache = nullptr,
+                           uint64_t max_instructions = _STRONK_SERVER_MAX_INSTRUCTIONS);
+    ~CompileServer();
+    CompileServer(const CompileServer &) = delete;
+    auto operator=(const CompileServer &) -> CompileServer & = delete;
+
+    // $STRONK_SERVER_SOCKET, else stronk-<uid>.sock in the
+    // temporary directory.
+    static auto DefaultSocket() -> std::filesystem::path;
+
+    // Binds the socket, replacing a stale one. Returns false if
+    // the socket could not be created.
+    auto Listen() -> bool;
+    // Accepts connections until a SHUTDOWN request or `Shutdown`.
+    void Serve();
+    // Safe to call from any thread.
+    void Shutdown();
+
+    auto Handle(ServerRequestKind kind, ExecutionEngine engine, std::string_view source) -> ServerReply;
+    auto GetStats() const -> ServerStats;
+private:
+    struct CachedProgram {
+        std::string source_;
+        Program program_;
+    };
+
+    std::filesystem::path socket_path_;
+    size_t threads_;
+    const ProgramCache *disk_cache_;
+    uint64_t max_instructions_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+
+    mutable std::shared_mutex cache_mutex_;
+    std::unordered_map<uint64_t, CachedProgram> programs_;
+
+    mutable std::mutex stats_mutex_;
+    ServerStats stats_;
+    std::vector<std::chrono::nanoseconds> latencies_;
+    size_t next_latency_ = 0;
+
+    void ServeConnection(int fd);
+    auto GetProgram(std::string_view source, bool &cache_hit) -> std::optional<Program>;
+    void Record(const ServerReply &reply);
+};
+
+// Thin client of a CompileServer. Each request opens its own
+// connection.
+class CompileClient {
+public:
+    explicit CompileClient(std::filesystem::path socket_path) : socket_path_(std::move(socket_path)) {}
+
+    // Returns std::nullopt if the server could not be reached or
+    // the connection broke.
+    auto Send(ServerRequestKind kind, ExecutionEngine engine, std::string_view source) const
+        -> std::optional<ServerReply>;
+private:
+    std::filesystem::path socket_path_;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_COMPILE_SERVER_H
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "common/thread_pool.h"
+#include "compiler/compiler.h"
+#include "server/compile_server.h"
+
+namespace stronk {
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct RequestHeader {
+    uint32_t magic_;
+    uint32_t size_;
+    uint8_t kind_;
+    uint8_t engine_;
+    uint16_t reserved_;
+};
+
+struct ReplyHeader {
+    uint32_t magic_;
+    uint32_t size_;
+    uint64_t server_ns_;
+    uint8_t status_;
+    uint8_t cache_hit_;
+    uint16_t reserved_[3];
+};
+
+auto ReadAll(int fd, void *data, size_t size) -> bool {
+    auto *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t n = ::read(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+auto WriteAll(int fd, const void *data, size_t size) -> bool {
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        // MSG_NOSIGNAL: a client that went away must not kill the
+        // server with SIGPIPE.
+        ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+auto MakeAddress(const std::filesystem::path &path, sockaddr_un &addr) -> bool {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    const std::string &name = path.native();
+    if (name.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, name.c_str(), name.size() + 1);
+    return true;
+}
+
+auto Micros(std::chrono::nanoseconds duration) -> double {
+    return duration.count() / 1e3;
+}
+
+} // namespace
+
+auto ServerStats::ToString() const -> std::string {
+    std::ostringstream out;
+    out << requests_ << " requests, " << cache_hits_ << " cache hits, " << cache_misses_ << " misses, "
+        << compile_errors_ << " compile errors, " << runtime_errors_ << " runtime errors, "
+        << cached_programs_ << " programs cached\n"
+        << "latency p50 " << Micros(p50_) << " us, p99 " << Micros(p99_) << " us, max " << Micros(max_) << " us\n";
+    return out.str();
+}
+
+CompileServer::CompileServer(std::filesystem::path socket_path, size_t threads, const ProgramCache *disk_cache,
+                             uint64_t max_instructions)
+        : socket_path_(std::move(socket_path)), threads_(threads), disk_cache_(disk_cache),
+          max_instructions_(max_instructions) {}
+
+CompileServer::~CompileServer() {
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        std::filesystem::remove(socket_path_);
+    }
+}
+
+auto CompileServer::DefaultSocket() -> std::filesystem::path {
+    if (const char *path = std::getenv("STRONK_SERVER_SOCKET")) {
+        return path;
+    }
+    return std::filesystem::temp_directory_path() / ("stronk-" + std::to_string(getuid()) + ".sock");
+}
+
+auto CompileServer::Listen() -> bool {
+    sockaddr_un addr;
+    if (!MakeAddress(socket_path_, addr)) {
+        return false;
+    }
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::remove(socket_path_, ec);
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+            || ::listen(listen_fd_, SOMAXCONN) != 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void CompileServer::Serve() {
+    ThreadPool pool(threads_);
+    while (!stopping_.load()) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break; // shut down
+        }
+        timeval timeout = { _STRONK_SERVER_RECV_TIMEOUT, 0 };
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        pool.Submit([this, fd] { ServeConnection(fd); });
+    }
+    pool.Wait();
+}
+
+// Wakes the accept loop up. Connections in flight still finish.
+void CompileServer::Shutdown() {
+    stopping_.store(true);
+    if (listen_fd_ >= 0) {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+    }
+}
+
+void CompileServer::ServeConnection(int fd) {
+    RequestHeader request;
+    std::string source;
+    while (ReadAll(fd, &request, sizeof(request))) {
+        if (request.magic_ != _STRONK_SERVER_MAGIC || request.size_ > _STRONK_SERVER_MAX_SOURCE) {
+            break;
+        }
+        source.resize(request.size_);
+        if (!ReadAll(fd, source.data(), source.size())) {
+            break;
+        }
+
+        auto kind = static_cast<ServerRequestKind>(request.kind_);
+        ServerReply reply;
+        if (request.engine_ <= static_cast<uint8_t>(ExecutionEngine::TIERED)) {
+            reply = Handle(kind, static_cast<ExecutionEngine>(request.engine_), source);
+        }
+
+        ReplyHeader header = {};
+        header.magic_ = _STRONK_SERVER_MAGIC;
+        header.size_ = static_cast<uint32_t>(reply.output_.size());
+        header.server_ns_ = static_cast<uint64_t>(reply.server_time_.count());
+        header.status_ = static_cast<uint8_t>(reply.status_);
+        header.cache_hit_ = reply.cache_hit_;
+        if (!WriteAll(fd, &header, sizeof(header)) || !WriteAll(fd, reply.output_.data(), reply.output_.size())) {
+            break;
+        }
+        if (kind == ServerRequestKind::SHUTDOWN) {
+            Shutdown();
+            break;
+        }
+    }
+    ::close(fd);
+}
+
+// Returns the lowered program of `source` from memory, the disk
+// cache or the frontend, in that order.
+auto CompileServer::GetProgram(std::string_view source, bool &cache_hit) -> std::optional<Program> {
+    uint64_t hash = HashSource(source);
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        auto it = programs_.find(hash);
+        if (it != programs_.end() && it->second.source_ == source) {
+            cache_hit = true;
+            return it->second.program_;
+        }
+    }
+    cache_hit = false;
+
+    std::optional<Program> program;
+    if (disk_cache_ != nullptr) {
+        program = disk_cache_->Load(source);
+    }
+    if (!program) {
+        Compiler compiler;
+        if (!compiler.Compile(source)) {
+            return std::nullopt;
+        }
+        try {
+            program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+        } catch (const std::invalid_argument &e) {
+            std::cerr << "Invalid bytecode: " << e.what() << "\n";
+            return std::nullopt;
+        }
+        if (disk_cache_ != nullptr) {
+            disk_cache_->Store(source, *program);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+    if (programs_.size() >= _STRONK_SERVER_CACHE_ENTRIES && programs_.count(hash) == 0) {
+        programs_.erase(programs_.begin());
+    }
+    programs_[hash] = CachedProgram{ std::string(source), *program };
+    return program;
+}
+
+auto CompileServer::Handle(ServerRequestKind kind, ExecutionEngine engine, std::string_view source)
+        -> ServerReply {
+    auto start = Clock::now();
+    ServerReply reply;
+    switch (kind) {
+        case ServerRequestKind::RUN:
+        case ServerRequestKind::COMPILE: {
+            std::optional<Program> program = GetProgram(source, reply.cache_hit_);
+            if (!program) {
+                reply.status_ = ServerStatus::COMPILE_ERROR;
+                break;
+            }
+            reply.status_ = ServerStatus::OK;
+            if (kind == ServerRequestKind::RUN) {
+                std::ostringstream out;
+                VirtualMachine vm(out);
+                vm.SetEngine(engine);
+                vm.SetInstructionLimit(max_instructions_);
+                if (vm.Execute(std::move(*program)) != InterpretResult::OK) {
+                    reply.status_ = ServerStatus::RUNTIME_ERROR;
+                }
+                reply.output_ = out.str();
+            }
+            break;
+        }
+        case ServerRequestKind::STATS:
+            reply.status_ = ServerStatus::OK;
+            reply.output_ = GetStats().ToString();
+            return reply;
+        case ServerRequestKind::SHUTDOWN:
+            reply.status_ = ServerStatus::OK;
+            return reply;
+        default:
+            return reply;
+    }
+    reply.server_time_ = Clock::now() - start;
+    Record(reply);
+    return reply;
+}
+
+void CompileServer::Record(const ServerReply &reply) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.requests_++;
+    if (reply.cache_hit_) {
+        stats_.cache_hits_++;
+    } else {
+        stats_.cache_misses_++;
+    }
+    if (reply.status_ == ServerStatus::COMPILE_ERROR) {
+        stats_.compile_errors_++;
+    } else if (reply.status_ == ServerStatus::RUNTIME_ERROR) {
+        stats_.runtime_errors_++;
+    }
+    if (latencies_.size() < _STRONK_SERVER_LATENCY_WINDOW) {
+        latencies_.push_back(reply.server_time_);
+    } else {
+        latencies_[next_latency_] = reply.server_time_;
+        next_latency_ = (next_latency_ + 1) % latencies_.size();
+    }
+}
+
+auto CompileServer::GetStats() const -> ServerStats {
+    ServerStats stats;
+    std::vector<std::chrono::nanoseconds> latencies;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats = stats_;
+        latencies = latencies_;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        stats.cached_programs_ = programs_.size();
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats.p50_ = latencies[latencies.size() / 2];
+        stats.p99_ = latencies[latencies.size() * 99 / 100];
+        stats.max_ = latencies.back();
+    }
+    return stats;
+}
+
+auto CompileClient::Send(ServerRequestKind kind, ExecutionEngine engine, std::string_view source) const
+        -> std::optional<ServerReply> {
+    sockaddr_un addr;
+    if (source.size() > _STRONK_SERVER_MAX_SOURCE || !MakeAddress(socket_path_, addr)) {
+        return std::nullopt;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    RequestHeader request = {};
+    request.magic_ = _STRONK_SERVER_MAGIC;
+    request.size_ = static_cast<uint32_t>(source.size());
+    request.kind_ = static_cast<uint8_t>(kind);
+    request.engine_ = static_cast<uint8_t>(engine);
+
+    std::optional<ServerReply> reply;
+    ReplyHeader header;
+    if (WriteAll(fd, &request, sizeof(request)) && WriteAll(fd, source.data(), source.size())
+            && ReadAll(fd, &header, sizeof(header)) && header.magic_ == _STRONK_SERVER_MAGIC) {
+        reply.emplace();
+        reply->status_ = static_cast<ServerStatus>(header.status_);
+        reply->cache_hit_ = header.cache_hit_ != 0;
+        reply->server_time_ = std::chrono::nanoseconds(header.server_ns_);
+        reply->output_.resize(header.size_);
+        if (!ReadAll(fd, reply->output_.data(), reply->output_.size())) {
+            reply.reset();
+        }
+    }
+    ::close(fd);
+    return reply;
+}
+
+} // namespace "stronk"
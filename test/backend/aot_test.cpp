@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <unistd.h>
+#include "backend/aot.h"
+#include "common/utils.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+namespace {
+
+auto TranslateSource(const std::string &source) -> std::string {
+    Compiler compiler;
+    EXPECT_TRUE(compiler.Compile(ReadMockSource(source)));
+    return TranslateToC(LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool()));
+}
+
+// Builds `source` into a native executable and returns what it
+// prints, or "<runtime error>" appended on a non-zero exit. The
+// binary is named after the test and process, since ctest may run
+// the tests of this file in parallel.
+auto RunExecutable(const std::string &source) -> std::string {
+    std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::string binary = (std::filesystem::temp_directory_path()
+                          / ("stronk_aot_test_" + name + "_" + std::to_string(getpid()))).string();
+    EXPECT_TRUE(CompileExecutable(TranslateSource(source), binary));
+
+    std::string output;
+    FILE *pipe = popen(("'" + binary + "' 2>/dev/null").c_str(), "r");
+    std::array<char, 256> buffer;
+    size_t read;
+    while ((read = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+        output.append(buffer.data(), read);
+    }
+    if (pclose(pipe) != 0) {
+        output += "<runtime error>";
+    }
+    std::filesystem::remove(binary);
+    return output;
+}
+
+auto HasCompiler() -> bool {
+    return std::system("cc --version > /dev/null 2>&1") == 0;
+}
+
+} // namespace
+
+TEST(AotTests, TranslatesControlFlowToGotos) {
+    std::string c_source = TranslateSource("execution/counting_loop.stronk");
+    ASSERT_NE(c_source.find("int main(void)"), std::string::npos);
+    ASSERT_NE(c_source.find("int v_i = 0;"), std::string::npos);
+    ASSERT_NE(c_source.find("goto L"), std::string::npos);
+    ASSERT_NE(c_source.find("printf(\"%d\", v_sum);"), std::string::npos);
+}
+
+TEST(AotTests, MatchesInterpreter) {
+    if (!HasCompiler()) {
+        GTEST_SKIP() << "No C compiler available.";
+    }
+    for (const auto &source : { "execution/counting_loop.stronk",
+                                "execution/real_arithmetic.stronk",
+                                "execution/numeric_kernel.stronk",
+                                "execution/nested_loops.stronk",
+                                "execution/immediates.stronk",
+                                "execution/superinstructions.stronk",
+                                "execution/conversions.stronk",
+                                "execution/initializers.stronk",
+                                "execution/short_circuit.stronk" }) {
+        EXPECT_EQ(RunExecutable(source), InterpretSource(source)) << source;
+    }
+}
+
+TEST(AotTests, DivisionByZero) {
+    if (!HasCompiler()) {
+        GTEST_SKIP() << "No C compiler available.";
+    }
+    ASSERT_EQ(RunExecutable("execution/division_by_zero.stronk"), "<runtime error>");
+}
+
+} // namespace "stronk"
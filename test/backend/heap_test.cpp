@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "backend/heap.h"
+
+namespace stronk {
+
+TEST(HeapTests, CollectsUnreachableStrings) {
+    Heap heap;
+    std::vector<Value> roots;
+    heap.SetRootMarker([&roots](Heap &h) {
+        for (const auto &val : roots) {
+            h.MarkValue(val);
+        }
+    });
+
+    roots.push_back(Value::Object(heap.AllocateString("kept")));
+    heap.AllocateString("garbage");
+    heap.AllocateString(std::string(1000, 'x'));
+
+    heap.Collect();
+
+    ASSERT_EQ(heap.GetStats().live_objects_, 1);
+    ASSERT_EQ(heap.GetStats().collections_, 1);
+    ASSERT_EQ(AsString(roots[0])->View(), "kept");
+}
+
+TEST(HeapTests, ReusesFreedBlocks) {
+    Heap heap;
+    heap.SetRootMarker([](Heap &) {});
+
+    ObjString *first = heap.AllocateString("short");
+    heap.Collect();
+    ObjString *second = heap.AllocateString("other");
+
+    ASSERT_EQ(static_cast<Obj *>(first), static_cast<Obj *>(second));
+    ASSERT_EQ(second->View(), "other");
+}
+
+TEST(HeapTests, IncrementalCycleKeepsRoots) {
+    Heap heap(4096);
+    std::vector<Value> roots;
+    heap.SetRootMarker([&roots](Heap &h) {
+        for (const auto &val : roots) {
+            h.MarkValue(val);
+        }
+    });
+
+    for (int i = 0; i < 10000; i++) {
+        Value val = Value::Object(heap.AllocateString("string " + std::to_string(i)));
+        if (i % 100 == 0) {
+            roots.push_back(val);
+        }
+    }
+    heap.Collect();
+
+    const HeapStats &stats = heap.GetStats();
+    ASSERT_GT(stats.collections_, 1);
+    ASSERT_EQ(stats.live_objects_, roots.size());
+    for (size_t i = 0; i < roots.size(); i++) {
+        ASSERT_EQ(AsString(roots[i])->View(), "string " + std::to_string(i * 100));
+    }
+}
+
+} // namespace "stronk"
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "backend/jit.h"
+#include "common/utils.h"
+#include "config.h"
+
+namespace stronk {
+
+// Runs every mock program through both engines and expects
+// identical output. Strings and error fixtures are skipped since
+// the frontend cannot compile them yet.
+TEST(JitTests, MatchesInterpreterOnCorpus) {
+    if (!JitCompiler::IsSupported()) {
+        GTEST_SKIP() << "JIT is not supported on this host.";
+    }
+
+    std::filesystem::path mock_dir = std::string(BASE_DIR) + "/test/mock";
+    int programs = 0;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(mock_dir)) {
+        if (entry.path().extension() != ".stronk") {
+            continue;
+        }
+        std::string source = std::filesystem::relative(entry.path(), mock_dir).string();
+        if (source.rfind("strings/", 0) == 0 || source.find("errors/") != std::string::npos) {
+            continue;
+        }
+        EXPECT_EQ(InterpretSource(source, ExecutionEngine::JIT), InterpretSource(source)) << source;
+        programs++;
+    }
+    ASSERT_GT(programs, 0);
+}
+
+TEST(JitTests, NumericKernel) {
+    ASSERT_EQ(InterpretSource("execution/numeric_kernel.stronk", ExecutionEngine::JIT),
+              "0\n0.5\n1.5\n3\n95\n-175\n23.75\ntrue\n");
+}
+
+TEST(JitTests, DivisionByZero) {
+    ASSERT_EQ(InterpretSource("execution/division_by_zero.stronk", ExecutionEngine::JIT), "<runtime error>");
+}
+
+} // namespace "stronk"
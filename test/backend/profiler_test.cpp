@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "backend/profiler.h"
+#include "backend/vm.h"
+#include "common/utils.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+namespace {
+
+auto LowerSource(const std::string &source) -> Program {
+    Compiler compiler;
+    EXPECT_TRUE(compiler.Compile(ReadMockSource(source)));
+    return LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+}
+
+} // namespace
+
+// Replays a straight-line trace through the profiler and checks
+// that counts are attributed to opcodes, lines and blocks.
+TEST(ProfilerTests, AttributesCounts) {
+    Program program = LowerSource("execution/counting_loop.stronk");
+    Profiler profiler;
+    profiler.Reset(program);
+    for (int round = 0; round < 3; round++) {
+        for (int pc = 0; pc < 3; pc++) {
+            profiler.OnInstr(pc);
+        }
+    }
+    profiler.Flush();
+
+    // i = 0; sum = 0; lower to a CONST each on lines 1 and 2, then
+    // the loop condition is a BLTI on line 3.
+    ASSERT_EQ(profiler.GetOpcodeCounts().at(OpCode::CONST), 6);
+    ASSERT_EQ(profiler.GetOpcodeCounts().at(OpCode::BLTI), 3);
+    ASSERT_EQ(profiler.GetLineCounts().at(1), 3);
+    ASSERT_EQ(profiler.GetLineCounts().at(3), 3);
+    ASSERT_EQ((profiler.GetPairCounts().at({ OpCode::CONST, OpCode::BLTI })), 3);
+    ASSERT_EQ(profiler.GetBlocks().size(), 1);
+    ASSERT_EQ(profiler.GetBlocks()[0].begin_, 0);
+    ASSERT_EQ(profiler.GetBlocks()[0].executions_, 3);
+
+    std::ostringstream report;
+    profiler.Report(report);
+    ASSERT_NE(report.str().find("== Opcodes (9 instructions) =="), std::string::npos);
+    ASSERT_NE(report.str().find("CONST + BLTI"), std::string::npos);
+    ASSERT_NE(report.str().find("line 1"), std::string::npos);
+}
+
+TEST(ProfilerTests, CountsInterpretedLoop) {
+    if (!STRONK_VM_PROFILE) {
+        GTEST_SKIP() << "Built without STRONK_VM_PROFILE.";
+    }
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile(ReadMockSource("execution/counting_loop.stronk")));
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    ASSERT_EQ(vm.Interpret(compiler.TakeModule()), InterpretResult::OK);
+
+    // The loop body prints once per iteration. The loop is entered
+    // through its condition and closed by the fused counter.
+    ASSERT_EQ(vm.GetProfiler().GetOpcodeCounts().at(OpCode::PRINT), 5);
+    ASSERT_EQ(vm.GetProfiler().GetOpcodeCounts().at(OpCode::BLTI), 1);
+    ASSERT_EQ(vm.GetProfiler().GetOpcodeCounts().at(OpCode::INCBLTI), 5);
+}
+
+} // namespace "stronk"
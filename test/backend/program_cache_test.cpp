@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <sstream>
+#include "backend/program_cache.h"
+#include "backend/vm.h"
+#include "common/utils.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+namespace {
+
+auto LowerSource(const std::string &source) -> Program {
+    Compiler compiler;
+    EXPECT_TRUE(compiler.Compile(source));
+    return LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+}
+
+auto Execute(Program program) -> std::string {
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    EXPECT_EQ(vm.Execute(std::move(program)), InterpretResult::OK);
+    return out.str();
+}
+
+} // namespace
+
+TEST(ProgramCacheTests, RoundTripsProgram) {
+    std::string source = ReadMockSource("execution/numeric_kernel.stronk");
+    Program program = LowerSource(source);
+    std::string image = SerializeProgram(program, HashSource(source));
+
+    std::optional<Program> loaded = DeserializeProgram(image.data(), image.size(), HashSource(source));
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(loaded->code_.size(), program.code_.size());
+    ASSERT_EQ(loaded->constants_, program.constants_);
+    ASSERT_EQ(loaded->globals_, program.globals_);
+    ASSERT_EQ(Execute(std::move(*loaded)), "0\n0.5\n1.5\n3\n95\n-175\n23.75\ntrue\n");
+}
+
+TEST(ProgramCacheTests, RejectsStaleOrCorruptImages) {
+    std::string source = ReadMockSource("execution/counting_loop.stronk");
+    std::string image = SerializeProgram(LowerSource(source), HashSource(source));
+
+    ASSERT_FALSE(DeserializeProgram(image.data(), image.size(), HashSource(source + " ")));
+    ASSERT_FALSE(DeserializeProgram(image.data(), image.size() - 1, HashSource(source)));
+
+    // Point the first branch far outside the program.
+    Program program = LowerSource(source);
+    for (size_t i = 0; i < program.code_.size(); i++) {
+        if (IsBranch(program.code_[i].code_)) {
+            program.code_[i].target_ = 1000;
+            break;
+        }
+    }
+    std::string corrupt = SerializeProgram(program, HashSource(source));
+    ASSERT_FALSE(DeserializeProgram(corrupt.data(), corrupt.size(), HashSource(source)));
+}
+
+TEST(ProgramCacheTests, StoresAndLoadsEntries) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "stronk_program_cache_test";
+    std::filesystem::remove_all(dir);
+    ProgramCache cache(dir);
+
+    std::string source = ReadMockSource("execution/counting_loop.stronk");
+    ASSERT_FALSE(cache.Load(source));
+    ASSERT_TRUE(cache.Store(source, LowerSource(source)));
+    ASSERT_TRUE(std::filesystem::exists(cache.EntryPath(source)));
+
+    std::optional<Program> loaded = cache.Load(source);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(Execute(std::move(*loaded)), "0\n1\n3\n6\n10\n");
+    ASSERT_FALSE(cache.Load(source + "print 1;"));
+    std::filesystem::remove_all(dir);
+}
+
+} // namespace "stronk"
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include "backend/sampler.h"
+#include "backend/vm.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+TEST(SamplerTests, RingPreservesOrderAndDropsWhenFull) {
+    auto ring = std::make_unique<SampleRing>();
+    for (uint64_t i = 0; i < _STRONK_SAMPLE_RING_SIZE; i++) {
+        ASSERT_TRUE(ring->Push(i));
+    }
+    ASSERT_FALSE(ring->Push(0));
+    ASSERT_EQ(ring->Dropped(), 1);
+
+    uint64_t sample;
+    for (uint64_t i = 0; i < _STRONK_SAMPLE_RING_SIZE; i++) {
+        ASSERT_TRUE(ring->Pop(sample));
+        ASSERT_EQ(sample, i);
+    }
+    ASSERT_FALSE(ring->Pop(sample));
+}
+
+// Periods of a second or more do not fit in tv_usec alone.
+TEST(SamplerTests, StartsAtLowRates) {
+    if (!SamplingProfiler::IsSupported()) {
+        GTEST_SKIP() << "Sampling is not supported on this host.";
+    }
+    SamplingProfiler sampler;
+    ASSERT_TRUE(sampler.Start(1));
+    sampler.Stop();
+    ASSERT_TRUE(sampler.Start(2));
+    sampler.Stop();
+    ASSERT_FALSE(sampler.Start(0));
+}
+
+TEST(SamplerTests, AttributesSamplesToLines) {
+    if (!SamplingProfiler::IsSupported()) {
+        GTEST_SKIP() << "Sampling is not supported on this host.";
+    }
+
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int i = 0;\nint sum = 0;\nwhile (i < 3000000) {\n    sum = sum + i;\n    i = i + 1;\n}\n"));
+
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    auto sampler = std::make_unique<SamplingProfiler>();
+    ASSERT_TRUE(sampler->Start(1000));
+    ASSERT_FALSE(SamplingProfiler().Start(1000));
+    vm.SetSampler(sampler.get());
+    ASSERT_EQ(vm.Interpret(compiler.TakeModule()), InterpretResult::OK);
+    sampler->Stop();
+
+    ASSERT_GT(sampler->GetSamples(), 0);
+    std::ostringstream collapsed;
+    sampler->WriteCollapsed(collapsed);
+    ASSERT_NE(collapsed.str().find("stronk;line 4;"), std::string::npos);
+}
+
+} // namespace "stronk"
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "backend/jit.h"
+#include "common/utils.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+namespace {
+
+struct TieredRun {
+    std::string output;
+    TieringStats stats;
+};
+
+auto RunTiered(const std::string &source, uint32_t threshold) -> TieredRun {
+    Compiler compiler;
+    EXPECT_TRUE(compiler.Compile(ReadMockSource(source)));
+
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    vm.SetEngine(ExecutionEngine::TIERED);
+    vm.SetTierUpThreshold(threshold);
+    if (vm.Interpret(compiler.TakeModule()) != InterpretResult::OK) {
+        out << "<runtime error>";
+    }
+    return { out.str(), vm.GetTieringStats() };
+}
+
+} // namespace
+
+TEST(TieredTests, MatchesInterpreter) {
+    for (const auto &source : { "execution/counting_loop.stronk",
+                                "execution/numeric_kernel.stronk",
+                                "execution/nested_loops.stronk",
+                                "execution/superinstructions.stronk",
+                                "execution/conversions.stronk",
+                                "execution/initializers.stronk",
+                                "execution/short_circuit.stronk" }) {
+        for (uint32_t threshold : { 1u, 2u, 3u, 1000u }) {
+            EXPECT_EQ(RunTiered(source, threshold).output, InterpretSource(source)) << source << " " << threshold;
+        }
+    }
+}
+
+TEST(TieredTests, EntersCompiledLoop) {
+    if (!JitCompiler::IsSupported()) {
+        GTEST_SKIP() << "JIT is not supported on this host.";
+    }
+
+    TieredRun run = RunTiered("execution/nested_loops.stronk", 2);
+    ASSERT_EQ(run.output, "0\n1320\n20615\n90335\n");
+    ASSERT_GE(run.stats.regions_compiled_, 1);
+    ASSERT_GT(run.stats.osr_entries_, 0);
+
+    TieredRun cold = RunTiered("execution/nested_loops.stronk", 100000);
+    ASSERT_EQ(cold.stats.regions_compiled_, 0);
+    ASSERT_EQ(cold.stats.osr_entries_, 0);
+}
+
+} // namespace "stronk"
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <sstream>
+#include "backend/verifier.h"
+#include "backend/vm.h"
+#include "common/utils.h"
+#include "compiler/compiler.h"
+#include "config.h"
+
+namespace stronk {
+
+namespace {
+
+auto LowerSource(const std::string &source) -> Program {
+    Compiler compiler;
+    EXPECT_TRUE(compiler.Compile(source));
+    return LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+}
+
+// r0 = 2; r1 = 1.5; then `instr`.
+auto MakeProgram(ProgramInstr instr) -> Program {
+    Program program;
+    program.constants_ = { 2, 1.5f };
+    program.num_registers_ = 3;
+    program.code_ = { { OpCode::CONST, 0, 0 }, { OpCode::CONST, 1, 1 }, instr };
+    return program;
+}
+
+} // namespace
+
+TEST(VerifierTests, AcceptsLoweredCorpus) {
+    std::filesystem::path mock_dir = std::string(BASE_DIR) + "/test/mock";
+    int programs = 0;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(mock_dir)) {
+        if (entry.path().extension() != ".stronk") {
+            continue;
+        }
+        std::string source = std::filesystem::relative(entry.path(), mock_dir).string();
+        if (source.rfind("strings/", 0) == 0 || source.find("errors/") != std::string::npos) {
+            continue;
+        }
+        Program program = LowerSource(ReadMockSource(source));
+        EXPECT_TRUE(program.verified_) << source;
+        EXPECT_EQ(VerifyProgram(program), std::nullopt) << source;
+        programs++;
+    }
+    ASSERT_GT(programs, 0);
+}
+
+TEST(VerifierTests, RejectsMalformedPrograms) {
+    ASSERT_EQ(VerifyProgram(MakeProgram({ OpCode::ADD, 2, 0, 0 })), std::nullopt);
+    ASSERT_EQ(VerifyProgram(MakeProgram({ OpCode::EQ, 2, 0, 0 })), std::nullopt);
+    ASSERT_EQ(VerifyProgram(MakeProgram({ OpCode::BEQI, -1, 0, 7, -1, 3, 3 })), std::nullopt);
+
+    // Operand types against the opcode family.
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::ADD, 2, 0, 1 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::FADD, 2, 0, 1 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::EQ, 2, 1, 1 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::BR, -1, 0, -1, -1, 3, 3 })), std::nullopt);
+    // Frame bounds, definitions and branch targets.
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::ADD, 3, 0, 0 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::ADD, 2, 0, 2 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::JMP, -1, -1, -1, -1, 4 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::CONST, 2, 5 })), std::nullopt);
+    ASSERT_NE(VerifyProgram(MakeProgram({ OpCode::PHI, 2, 0, 0 })), std::nullopt);
+
+    // A register keeps one type.
+    Program program = MakeProgram({ OpCode::I2F, 2, 0 });
+    program.code_.push_back({ OpCode::F2I, 2, 1 });
+    std::optional<std::string> error = VerifyProgram(program);
+    ASSERT_NE(error, std::nullopt);
+    ASSERT_EQ(error->rfind("Instruction 3", 0), 0u);
+}
+
+TEST(VerifierTests, ExecuteRejectsUnverifiedPrograms) {
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    ASSERT_EQ(vm.Execute(MakeProgram({ OpCode::FNEG, 2, 0 })), InterpretResult::COMPILE_ERROR);
+
+    Program program = MakeProgram({ OpCode::NEG, 2, 0 });
+    program.code_.push_back({ OpCode::PRINT, -1, 0, 1 });
+    program.operands_ = { 2 };
+    ASSERT_EQ(vm.Execute(std::move(program)), InterpretResult::OK);
+    ASSERT_EQ(out.str(), "-2\n");
+}
+
+} // namespace "stronk"
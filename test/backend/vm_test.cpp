@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "common/utils.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+TEST(VirtualMachineTests, PrintStatement) {
+    ASSERT_EQ(InterpretSource("statements/print_basic.stronk"), "nil\n5\ntrue\n");
+}
+
+TEST(VirtualMachineTests, IfStatement) {
+    ASSERT_EQ(InterpretSource("statements/if_basic.stronk"), "6\n");
+    ASSERT_EQ(InterpretSource("statements/alone_if.stronk"), "12\n");
+}
+
+TEST(VirtualMachineTests, WhileLoop) {
+    ASSERT_EQ(InterpretSource("execution/counting_loop.stronk"), "0\n1\n3\n6\n10\n");
+}
+
+TEST(VirtualMachineTests, RealArithmetic) {
+    ASSERT_EQ(InterpretSource("execution/real_arithmetic.stronk"), "4.5\n-1.5\n3\n3.5\ntrue\n");
+}
+
+TEST(VirtualMachineTests, DivisionByZero) {
+    ASSERT_EQ(InterpretSource("execution/division_by_zero.stronk"), "<runtime error>");
+}
+
+// Literals used once become immediate operands, taking their CONST
+// and register with them.
+TEST(VirtualMachineTests, FoldsImmediates) {
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int x = 0; while (10 > x) { x = 2 * x + 1; } print -x;"));
+    Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+    std::vector<OpCode> codes;
+    for (const auto &instr : program.code_) {
+        codes.push_back(instr.code_);
+    }
+    std::vector<OpCode> expected = {
+        OpCode::CONST,
+        OpCode::BLTI,
+        OpCode::MULTI, OpCode::ADDI, OpCode::BLTI,
+        OpCode::NEG, OpCode::PRINT
+    };
+    ASSERT_EQ(codes, expected);
+    ASSERT_EQ(program.constants_.size(), 1u);
+    ASSERT_EQ(program.code_[1].b_, 10);
+    ASSERT_EQ(program.code_[4].target_, 2);
+
+    ASSERT_EQ(InterpretSource("execution/immediates.stronk"),
+              "-24\n70.125\nfalse\ntrue\ntrue\ntrue\nfalse\n-12\n-70.125\n-2147483637\n");
+}
+
+TEST(VirtualMachineTests, SelectsSuperinstructions) {
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int i = 0; int a = 1; real r = 0.5;\n"
+                                 "while (i <= 9) { a = i * a + a; r = r * r + r; if (a == 4) { print a; } i = i + 1; }"));
+    Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+    std::vector<OpCode> codes;
+    for (const auto &instr : program.code_) {
+        codes.push_back(instr.code_);
+    }
+    std::vector<OpCode> expected = {
+        OpCode::CONST, OpCode::CONST, OpCode::CONST,
+        OpCode::BLEQI,
+        OpCode::MADD, OpCode::FMADD, OpCode::BEQI, OpCode::PRINT,
+        OpCode::INCBLEQI
+    };
+    ASSERT_EQ(codes, expected);
+    ASSERT_EQ(program.code_[8].target_, 4);
+    ASSERT_EQ(program.code_[8].c_, 1);
+
+    ASSERT_EQ(InterpretSource("execution/superinstructions.stronk"),
+              "8231334\n145.965\n-3\n8\n-2147483647\n3\n");
+}
+
+// Initializers convert to the declared type like assignments do,
+// for globals and block locals alike.
+TEST(VirtualMachineTests, ConvertsInitializers) {
+    ASSERT_EQ(InterpretSource("execution/initializers.stronk"), "10.5\n0.5\n2\n2.66667\n12\n11\n");
+}
+
+// A counter converted in every statement of a loop is converted
+// once, and converted constants are folded while lowering.
+TEST(VirtualMachineTests, EliminatesConversions) {
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int i = 0; real r = 0.0;\n"
+                                 "while (i < 4) { r = r + i * 0.5; if (i > 1) { r = r - i; } r = r / i; i = i + 1; }\n"
+                                 "r = r + 3;"));
+    Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+    int conversions = 0;
+    for (const auto &instr : program.code_) {
+        conversions += instr.code_ == OpCode::I2F || instr.code_ == OpCode::F2I ? 1 : 0;
+    }
+    ASSERT_EQ(conversions, 1);
+
+    ASSERT_EQ(InterpretSource("execution/conversions.stronk"), "20.625\n3.5\n15\n10\n");
+}
+
+// The right operand only runs when the left one leaves the result
+// open, and a condition chain branches straight to its target.
+TEST(VirtualMachineTests, ShortCircuitsLogic) {
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int i = 0; int n = 2;\n"
+                                 "if (i != 3 and n >= i or i == 9) { print i; }"));
+    Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+    std::vector<OpCode> codes;
+    for (const auto &instr : program.code_) {
+        codes.push_back(instr.code_);
+    }
+    std::vector<OpCode> expected = {
+        OpCode::CONST, OpCode::CONST,
+        OpCode::BNEQI, OpCode::BGEQ, OpCode::BEQI,
+        OpCode::PRINT
+    };
+    ASSERT_EQ(codes, expected);
+    ASSERT_EQ(program.code_[2].alt_, 4);
+    ASSERT_EQ(program.code_[3].target_, 5);
+    ASSERT_EQ(program.code_[4].alt_, 6);
+
+    ASSERT_EQ(InterpretSource("execution/short_circuit.stronk"),
+              "2\nfalse\ntrue\n10\nfalse\ntrue\ntrue\n8\n3\n10\ntrue\n");
+}
+
+// Feeds a session line by line like the REPL: every line only
+// produces and runs its own code against the persisted globals.
+TEST(VirtualMachineTests, IncrementalSession) {
+    Compiler compiler;
+    std::ostringstream out;
+    VirtualMachine vm(out);
+
+    auto run_line = [&](const std::string &line) -> size_t {
+        EXPECT_TRUE(compiler.Compile(line));
+        size_t size = compiler.GetBytecode().size();
+        EXPECT_EQ(vm.Interpret(compiler.TakeModule()), InterpretResult::OK);
+        return size;
+    };
+
+    run_line("int x = 1;");
+    run_line("real y = 0.5;");
+    size_t first = run_line("x = x + 1;");
+    for (int i = 0; i < 50; i++) {
+        ASSERT_EQ(run_line("x = x + 1;"), first);
+    }
+    run_line("while (x < 60) { x = x + 1; }");
+    run_line("print x;");
+    run_line("print y;");
+    ASSERT_EQ(out.str(), "60\n0.5\n");
+}
+
+// Counting keeps every engine in the interpreter, so the count is a
+// property of the program alone.
+TEST(VirtualMachineTests, CountsExecutedInstructions) {
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int x = 0; while (x < 10) { x = x + 1; } print x;"));
+    Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+
+    uint64_t expected = 0;
+    for (auto engine : { ExecutionEngine::INTERPRETER, ExecutionEngine::JIT, ExecutionEngine::TIERED }) {
+        std::ostringstream out;
+        VirtualMachine vm(out);
+        vm.SetEngine(engine);
+        vm.SetTierUpThreshold(2);
+        vm.SetCountInstructions(true);
+        ASSERT_EQ(vm.Execute(program), InterpretResult::OK);
+        ASSERT_EQ(out.str(), "10\n");
+        if (expected == 0) {
+            expected = vm.GetInstructionsExecuted();
+            ASSERT_GT(expected, program.code_.size());
+        }
+        ASSERT_EQ(vm.GetInstructionsExecuted(), expected);
+        ASSERT_EQ(vm.GetTieringStats().regions_compiled_, 0);
+    }
+}
+
+// The limit applies to each program, on top of what earlier ones ran.
+TEST(VirtualMachineTests, StopsAtInstructionLimit) {
+    Compiler compiler;
+    ASSERT_TRUE(compiler.Compile("int x = 0; while (x < 10) { x = x + 1; } print x;"));
+    Program program = LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    vm.SetEngine(ExecutionEngine::JIT);
+    vm.SetInstructionLimit(1000);
+    ASSERT_EQ(vm.Execute(program), InterpretResult::OK);
+    ASSERT_EQ(vm.Execute(program), InterpretResult::OK);
+    ASSERT_EQ(out.str(), "10\n10\n");
+    vm.SetInstructionLimit(10);
+    ASSERT_EQ(vm.Execute(program), InterpretResult::RUNTIME_ERROR);
+}
+
+} // namespace "stronk"
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory_resource>
+#include <sstream>
+#include <vector>
+#include "backend/vm.h"
+#include "common/arena.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+TEST(ArenaTests, BumpsAlignedMemory) {
+    Arena arena(64);
+    void *a = arena.allocate(3, 1);
+    void *b = arena.allocate(8, 8);
+    void *c = arena.allocate(1000, 16);
+    ASSERT_NE(a, b);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(c) % 16, 0u);
+    ASSERT_EQ(arena.Allocated(), 1011u);
+    // Freed with the arena only.
+    arena.deallocate(c, 1000, 16);
+    ASSERT_EQ(arena.Allocated(), 1011u);
+
+    std::pmr::vector<int> values(&arena);
+    for (int i = 0; i < 100; i++) {
+        values.push_back(i);
+    }
+    ASSERT_EQ(values[99], 99);
+    ASSERT_GT(arena.Allocated(), 1011u + 100 * sizeof(int));
+}
+
+// Objects share ownership of their arena, so they may outlive
+// whoever made it.
+TEST(ArenaTests, ObjectsKeepTheirArena) {
+    auto arena = std::make_shared<Arena>();
+    std::weak_ptr<Arena> alive = arena;
+    auto value = MakeShared<std::vector<int>>(arena, 3, 7);
+    ASSERT_GT(arena->Allocated(), 0u);
+    arena.reset();
+    ASSERT_FALSE(alive.expired());
+    ASSERT_EQ((*value)[2], 7);
+    value.reset();
+    ASSERT_TRUE(alive.expired());
+
+    ASSERT_EQ(*MakeShared<int>(nullptr, 5), 5);
+}
+
+TEST(ArenaTests, ModuleOutlivesCompiler) {
+    Module module;
+    {
+        Compiler compiler;
+        ASSERT_TRUE(compiler.Compile("int x = 2;\nwhile (x < 40) { x = x * x; }\nprint x;"));
+        module = compiler.TakeModule();
+        // A second compilation starts a new arena.
+        ASSERT_TRUE(compiler.Compile("print 1;"));
+    }
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    ASSERT_EQ(vm.Interpret(std::move(module)), InterpretResult::OK);
+    ASSERT_EQ(out.str(), "256\n");
+}
+
+} // namespace "stronk"
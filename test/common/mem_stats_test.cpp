@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+TEST(MemStatsTests, AttributesAllocationsToScope) {
+    if (!MemStats::Enabled()) {
+        GTEST_SKIP() << "Built without STRONK_MEM_STATS.";
+    }
+    MemStats before = MemStats::Current();
+    {
+        MemPhaseScope scope(MemPhase::VM);
+        auto block = std::make_unique<char[]>(1000);
+        ASSERT_NE(block, nullptr);
+    }
+    MemStats delta = MemStats::Current() - before;
+    ASSERT_EQ(delta[MemPhase::VM].allocations_, 1);
+    ASSERT_EQ(delta[MemPhase::VM].bytes_, 1000);
+    ASSERT_EQ(delta[MemPhase::SCANNER].allocations_, 0);
+}
+
+// Every frontend phase allocates, and twice the source costs more.
+TEST(MemStatsTests, CountsCompilerPhases) {
+    if (!MemStats::Enabled()) {
+        GTEST_SKIP() << "Built without STRONK_MEM_STATS.";
+    }
+    std::string source = "int x = 1; real y = 2.5; while (x < 10) { x = x + 1; y = y * 2; } print x;";
+    Compiler small;
+    ASSERT_TRUE(small.Compile(source));
+    const MemStats &stats = small.GetMemStats();
+    for (auto phase : { MemPhase::SCANNER, MemPhase::PARSER, MemPhase::CODE_GENERATOR, MemPhase::CONSTANT_POOL }) {
+        ASSERT_GT(stats[phase].allocations_, 0) << MemPhaseName(phase);
+    }
+    ASSERT_EQ(stats[MemPhase::VM].allocations_, 0);
+
+    // Large enough to outgrow the first arena chunk of the tokens.
+    std::string larger = source;
+    for (int i = 0; i < 200; i++) {
+        larger += "x = x * 2; y = y + x; print y;";
+    }
+    Compiler large;
+    ASSERT_TRUE(large.Compile(larger));
+    ASSERT_GT(large.GetMemStats()[MemPhase::SCANNER].bytes_, stats[MemPhase::SCANNER].bytes_);
+    ASSERT_GT(large.GetMemStats().Total().bytes_, stats.Total().bytes_);
+}
+
+} // namespace "stronk"
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "common/thread_pool.h"
+
+namespace stronk {
+
+TEST(ThreadPoolTests, RunsEveryTask) {
+    ThreadPool pool(4);
+    std::atomic<int> sum{0};
+    for (int i = 1; i <= 1000; i++) {
+        pool.Submit([&sum, i] { sum += i; });
+    }
+    pool.Wait();
+    ASSERT_EQ(sum.load(), 500500);
+
+    // The pool can be reused after waiting.
+    pool.Submit([&sum] { sum = 0; });
+    pool.Wait();
+    ASSERT_EQ(sum.load(), 0);
+}
+
+// Tasks spawned by a worker land on its own deque; the other
+// workers have to steal them.
+TEST(ThreadPoolTests, StealsNestedTasks) {
+    ThreadPool pool(4);
+    std::atomic<int> done{0};
+    pool.Submit([&pool, &done] {
+        for (int i = 0; i < 200; i++) {
+            pool.Submit([&done] {
+                volatile int spin = 0;
+                for (int j = 0; j < 10000; j++) {
+                    spin = spin + j;
+                }
+                done++;
+            });
+        }
+    });
+    pool.Wait();
+    ASSERT_EQ(done.load(), 200);
+}
+
+} // namespace "stronk"
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "common/trace.h"
+#include "common/utils.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+namespace {
+
+auto Decode(const std::string &log) -> std::string {
+    std::istringstream in(log);
+    std::ostringstream out;
+    EXPECT_TRUE(DecodeTrace(in, out));
+    return out.str();
+}
+
+} // namespace
+
+TEST(TraceTests, ParsesCategories) {
+    ASSERT_EQ(Tracer::ParseCategories("tokens,regs"),
+              static_cast<uint32_t>(TraceCategory::TOKENS) | static_cast<uint32_t>(TraceCategory::REGISTERS));
+    ASSERT_EQ(Tracer::ParseCategories(""), 0u);
+    ASSERT_FALSE(Tracer::ParseCategories("tokens,bogus"));
+}
+
+TEST(TraceTests, RoundTripsRecords) {
+    std::ostringstream log;
+    {
+        Tracer tracer(log, ~0u);
+        tracer.Token(3, "SEMICOLON");
+        tracer.Instruction(7, OpCode::ADD, 2);
+        tracer.RegisterWrite(7, 4, Value::Int(-5));
+        tracer.RegisterWrite(8, 1, Value::Bool(true));
+    }
+    ASSERT_EQ(Decode(log.str()),
+              "token    3  SEMICOLON\n"
+              "exec     2       7  ADD\n"
+              "write            7  r4 = -5\n"
+              "write            8  r1 = true\n");
+
+    std::istringstream truncated(log.str().substr(0, log.str().size() - 3));
+    std::ostringstream out;
+    ASSERT_FALSE(DecodeTrace(truncated, out));
+}
+
+TEST(TraceTests, TracesOnlyEnabledCategories) {
+    std::ostringstream log;
+    {
+        Tracer tracer(log, static_cast<uint32_t>(TraceCategory::INSTRUCTIONS));
+        Compiler compiler;
+        compiler.SetTracer(&tracer);
+        ASSERT_TRUE(compiler.Compile(ReadMockSource("execution/counting_loop.stronk")));
+
+        std::ostringstream out;
+        VirtualMachine vm(out);
+        vm.SetEngine(ExecutionEngine::JIT);
+        vm.SetTracer(&tracer);
+        ASSERT_EQ(vm.Interpret(compiler.TakeModule()), InterpretResult::OK);
+        ASSERT_EQ(out.str(), "0\n1\n3\n6\n10\n");
+    }
+
+    std::string text = Decode(log.str());
+    ASSERT_EQ(text.find("token"), std::string::npos);
+    ASSERT_EQ(text.find("write"), std::string::npos);
+    // Traced programs run in the interpreter even when the JIT is selected.
+    ASSERT_NE(text.find("PRINT"), std::string::npos);
+}
+
+} // namespace "stronk"
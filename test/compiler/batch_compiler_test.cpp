@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "compiler/batch_compiler.h"
+#include "config.h"
+
+namespace stronk {
+
+TEST(BatchCompilerTests, CompilesDirectoryConcurrently) {
+    std::filesystem::path mock_dir = std::string(BASE_DIR) + "/test/mock/execution";
+    std::filesystem::path cache_dir = std::filesystem::temp_directory_path() / "stronk_batch_compiler_test";
+    std::filesystem::remove_all(cache_dir);
+    ProgramCache cache(cache_dir);
+
+    std::vector<std::filesystem::path> files = FindSources(mock_dir);
+    ASSERT_GE(files.size(), 4);
+    // Compile every file several times so workers run concurrently.
+    std::vector<std::filesystem::path> batch;
+    for (int i = 0; i < 8; i++) {
+        batch.insert(batch.end(), files.begin(), files.end());
+    }
+
+    BatchResult result = CompileAll(batch, 4, &cache);
+    ASSERT_EQ(result.files_.size(), batch.size());
+    ASSERT_EQ(result.Failures(), 0);
+    ASSERT_EQ(result.threads_, 4);
+    for (size_t i = 0; i < batch.size(); i++) {
+        ASSERT_EQ(result.files_[i].path_, batch[i]);
+        ASSERT_GT(result.files_[i].instructions_, 0);
+    }
+    ASSERT_EQ(std::distance(std::filesystem::directory_iterator(cache_dir), {}), files.size());
+    std::filesystem::remove_all(cache_dir);
+}
+
+} // namespace "stronk"
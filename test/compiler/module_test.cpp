@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <sstream>
+#include "backend/vm.h"
+#include "compiler/compiler.h"
+
+namespace stronk {
+
+// Nothing is disassembled unless a sink was set, and then only to
+// that sink.
+TEST(ModuleTests, DisassemblesOnlyToSink) {
+    std::ostringstream stdout_capture;
+    std::streambuf *stdout_buffer = std::cout.rdbuf(stdout_capture.rdbuf());
+    Compiler compiler;
+    bool compiled = compiler.Compile("int x = 1;\nprint x + 2;\n");
+    std::ostringstream sink;
+    compiler.SetDisassembly(&sink);
+    compiled = compiled && compiler.Compile("print 3;\n");
+    std::cout.rdbuf(stdout_buffer);
+
+    ASSERT_TRUE(compiled);
+    ASSERT_EQ(stdout_capture.str(), "");
+    std::ostringstream expected;
+    for (const auto &instr : compiler.GetBytecode()) {
+        expected << instr->line_ << " " << instr->ToString() << "\n";
+    }
+    ASSERT_FALSE(expected.str().empty());
+    ASSERT_EQ(sink.str(), expected.str());
+}
+
+// Taking the module leaves the compiler empty, and every module
+// carries the constants it refers to.
+TEST(ModuleTests, TakeModuleMovesCode) {
+    Compiler compiler;
+    std::ostringstream out;
+    VirtualMachine vm(out);
+
+    ASSERT_TRUE(compiler.Compile("int x = 40;\n"));
+    Module first = compiler.TakeModule();
+    ASSERT_FALSE(first.code_.empty());
+    ASSERT_TRUE(compiler.GetBytecode().empty());
+    ASSERT_EQ(compiler.GetConstantPool().Size(), 0);
+    ASSERT_EQ(vm.Interpret(std::move(first)), InterpretResult::OK);
+
+    ASSERT_TRUE(compiler.Compile("print x + 2;\n"));
+    Module second = compiler.TakeModule();
+    ASSERT_EQ(second.constants_.Size(), 1);
+    ASSERT_EQ(vm.Interpret(std::move(second)), InterpretResult::OK);
+    ASSERT_EQ(out.str(), "42\n");
+}
+
+} // namespace "stronk"
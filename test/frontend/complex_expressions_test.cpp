@@ -5,6 +5,8 @@
 
 namespace stronk {
 
+#define P(num) (TEMP_VAR_PREFIX + std::to_string(num)).c_str()
+
 TEST(ComplexExpressionsTests, Precedence) {
     auto token_result = ReadTokensFromSource("complex_expressions/precedence.stronk");
     std::vector<std::shared_ptr<Token>> token_expected {
@@ -36,16 +38,24 @@ TEST(ComplexExpressionsTests, Precedence) {
         BuildInstr(3, OpCode::GEQ, 1, 2),
         BuildConstInstr(4, 2),
         BuildInstr(5, OpCode::EQ, 3, 4),
-        BuildConstInstr(6, 3),
-        BuildConstInstr(7, 4),
-        BuildInstr(8, OpCode::NEQ, 6, 7),
-        BuildConstInstr(9, 0),
-        BuildConstInstr(10, 5),
-        BuildInstr(11, OpCode::MULT, 9, 10),
-        BuildConstInstr(12, 6),
-        BuildInstr(13, OpCode::LT, 11, 12),
-        BuildInstr(14, OpCode::AND, 8, 13),
-        BuildInstr(15, OpCode::OR, 5, 14)
+        BuildInstr(6, OpCode::ID, 5),
+        BuildBr(P(6), ".or_0.exit", ".or_0.rhs"),
+        BuildLabel(".or_0.rhs"),
+        BuildConstInstr(7, 3),
+        BuildConstInstr(8, 4),
+        BuildInstr(9, OpCode::NEQ, 7, 8),
+        // The chain shares the merge register of the `or`.
+        BuildInstr(6, OpCode::ID, 9),
+        BuildBr(P(6), ".and_1.rhs", ".and_1.exit"),
+        BuildLabel(".and_1.rhs"),
+        BuildConstInstr(10, 0),
+        BuildConstInstr(11, 5),
+        BuildInstr(12, OpCode::MULT, 10, 11),
+        BuildConstInstr(13, 6),
+        BuildInstr(14, OpCode::LT, 12, 13),
+        BuildInstr(6, OpCode::ID, 14),
+        BuildLabel(".and_1.exit"),
+        BuildLabel(".or_0.exit")
     };
     ASSERT_EQ(bytecode_result, bytecode_expected);
 }
@@ -81,4 +91,6 @@ TEST(ComplexExpressionsTests, Grouping) {
     ASSERT_EQ(bytecode_result, bytecode_expected);
 }
 
+#undef P
+
 } // namespace "stronk"
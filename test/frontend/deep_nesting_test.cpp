@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <string>
+#include "backend/vm.h"
+#include "compiler/compiler.h"
+#include "frontend/parser.h"
+#include "frontend/scanner.h"
+
+namespace stronk {
+
+namespace {
+
+// Runs `body` on a thread with a fixed `stack_bytes` stack, so a
+// parse that recursed per nesting level would crash the test.
+void RunWithStack(size_t stack_bytes, const std::function<void()> &body) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, stack_bytes);
+    pthread_t thread;
+    auto run = [](void *arg) -> void * {
+        (*static_cast<const std::function<void()> *>(arg))();
+        return nullptr;
+    };
+    ASSERT_EQ(pthread_create(&thread, &attr, run, const_cast<std::function<void()> *>(&body)), 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+}
+
+auto Repeat(std::string_view text, size_t times) -> std::string {
+    std::string result;
+    result.reserve(text.size() * times);
+    for (size_t i = 0; i < times; i++) {
+        result += text;
+    }
+    return result;
+}
+
+auto Parse(std::string_view source, int max_expression_depth = _STRONK_MAX_EXPRESSION_DEPTH) -> bool {
+    Scanner scanner;
+    Parser parser;
+    parser.SetMaxExpressionDepth(max_expression_depth);
+    scanner.LoadSource(source);
+    for (;;) {
+        auto token = scanner.ScanNextToken();
+        bool eof = token->type_ == TokenType::TOKEN_EOF;
+        parser.AddToken(std::move(token));
+        if (eof) {
+            break;
+        }
+    }
+    parser.Parse();
+    return !parser.HadError();
+}
+
+// Seconds to compile `statements` copies of a small statement.
+auto CompileSeconds(size_t statements) -> double {
+    std::string source = "int x = 0;\n" + Repeat("x = x + 1;\n", statements);
+    auto start = std::chrono::steady_clock::now();
+    Compiler compiler;
+    EXPECT_TRUE(compiler.Compile(source));
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+// Statements keep their unfinished bodies on an explicit stack, so
+// nesting depth is only bounded by memory. 25k levels compiled and
+// run end to end are far beyond what a recursive parser fits in
+// 512 KiB; NestedBlocks parses 100k.
+TEST(DeepNestingTests, NestedStatements) {
+    constexpr size_t depth = 25000;
+    std::string source = "int x = 0;\n" + Repeat("if (true) { while (x < 1) {\n", depth) + "x = 1; print 7;\n"
+        + Repeat("} } else { print 0; }\n", depth);
+    RunWithStack(512 << 10, [&] {
+        Compiler compiler;
+        ASSERT_TRUE(compiler.Compile(source));
+        std::ostringstream out;
+        VirtualMachine vm(out);
+        ASSERT_EQ(vm.Interpret(compiler.TakeModule()), InterpretResult::OK);
+        ASSERT_EQ(out.str(), "7\n");
+    });
+}
+
+TEST(DeepNestingTests, NestedBlocks) {
+    constexpr size_t depth = 100000;
+    std::string source = Repeat("{ ", depth) + "print 1;" + Repeat(" }", depth);
+    RunWithStack(512 << 10, [&] { ASSERT_TRUE(Parse(source)); });
+    // An unclosed block is an error, not a hang or a crash.
+    RunWithStack(512 << 10, [&] { ASSERT_FALSE(Parse(Repeat("{ ", depth))); });
+}
+
+// Expressions are parsed recursively and give up with a diagnostic
+// past the depth limit instead of overflowing the stack.
+TEST(DeepNestingTests, NestedExpressions) {
+    constexpr size_t depth = 100000;
+    ASSERT_FALSE(Parse("print " + Repeat("(", depth) + "1" + Repeat(")", depth) + ";"));
+    ASSERT_FALSE(Parse("print " + Repeat("-", depth) + "1;"));
+    ASSERT_FALSE(Parse("int x = 0;\nif (true) { x = " + Repeat("(", depth) + "1" + Repeat(")", depth) + "; }"));
+
+    std::string parens = "print " + Repeat("(", 100) + "1" + Repeat(")", 100) + ";";
+    ASSERT_TRUE(Parse(parens));
+    ASSERT_FALSE(Parse(parens, 50));
+    ASSERT_TRUE(Parse(Repeat("{ ", 100) + parens + Repeat(" }", 100), 200));
+}
+
+// A quadratic parser would take 16 times longer on 4 times the
+// input; allow for noise but not for that.
+TEST(DeepNestingTests, LinearTime) {
+    CompileSeconds(2000);
+    double small = CompileSeconds(10000);
+    double large = CompileSeconds(40000);
+    ASSERT_LT(large / small, 8.0);
+}
+
+// 1M tokens on a small stack against a tenth of that. The full 10M
+// token program takes minutes and several GB in sanitizer builds,
+// so CI runs this reduced size. It is the slowest test here, so
+// test/CMakeLists.txt gives this file a longer timeout.
+TEST(DeepNestingTests, MillionTokens) {
+    constexpr size_t statements = 1000000 / 6;
+    double small = 0;
+    double large = 0;
+    RunWithStack(512 << 10, [&] {
+        CompileSeconds(statements / 20);
+        small = CompileSeconds(statements / 10);
+        large = CompileSeconds(statements);
+    });
+    ASSERT_LT(large / small, 20.0);
+}
+
+} // namespace "stronk"
@@ -82,7 +82,11 @@ TEST(GlobalVariableTests, OverwritingVariables) {
         BuildInstr("a", OpCode::ID, "b"),
         BuildConstInstr(P(3), 1),
         BuildInstr("b", OpCode::ID, P(3)),
-        BuildInstr(P(4), OpCode::OR, "a", "b"),
+        BuildInstr(P(4), OpCode::ID, "a"),
+        BuildBr(P(4), ".or_0.exit", ".or_0.rhs"),
+        BuildLabel(".or_0.rhs"),
+        BuildInstr(P(4), OpCode::ID, "b"),
+        BuildLabel(".or_0.exit"),
     };
 
     ASSERT_EQ(bytecode_result, bytecode_expected);
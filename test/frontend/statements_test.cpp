@@ -6,6 +6,7 @@
 namespace stronk {
 
 #define P(num) (TEMP_VAR_PREFIX + std::to_string(num)).c_str()
+#define L(slot) (LOCAL_VAR_PREFIX + std::to_string(slot)).c_str()
 
 TEST(StatementsTests, PrintStatement) {
     auto token_result = ReadTokensFromSource("statements/print_basic.stronk");
@@ -34,8 +35,8 @@ TEST(StatementsTests, BasicIfStatement) {
         BuildBr(P(5), ".if_0.true", ".if_0.false"),
         BuildLabel(".if_0.true"),
         BuildConstInstr(6, 3),
-        BuildInstr("a", OpCode::ID, P(6)),
-        BuildInstr(OpCode::PRINT, "a"),
+        BuildInstr(L(0), OpCode::ID, P(6)),
+        BuildInstr(OpCode::PRINT, L(0)),
         BuildJmp(".if_0.exit"),
         BuildLabel(".if_0.false"),
         BuildConstInstr(7, 4),
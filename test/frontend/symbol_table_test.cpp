@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "backend/vm.h"
+#include "compiler/compiler.h"
+#include "frontend/symbol_table.h"
+
+namespace stronk {
+
+namespace {
+
+auto RunSource(std::string_view source) -> std::string {
+    Compiler compiler;
+    if (!compiler.Compile(source)) {
+        return "<compile error>";
+    }
+    std::ostringstream out;
+    VirtualMachine vm(out);
+    vm.Interpret(compiler.TakeModule());
+    return out.str();
+}
+
+} // namespace
+
+TEST(SymbolTableTests, GlobalsKeepTheirNames) {
+    SymbolTable table;
+    const Symbol *symbol = table.Declare("count", PrimitiveType::INT);
+    ASSERT_NE(symbol, nullptr);
+    ASSERT_EQ(symbol->address_, "count");
+    ASSERT_EQ(symbol->slot_, -1);
+    ASSERT_EQ(table.Declare("count", PrimitiveType::REAL), nullptr);
+    ASSERT_EQ(table.Lookup("count")->type_, PrimitiveType::INT);
+    ASSERT_EQ(table.Lookup("missing"), nullptr);
+}
+
+TEST(SymbolTableTests, ScopesShadowAndUnbind) {
+    SymbolTable table;
+    table.Declare("x", PrimitiveType::INT);
+    table.EnterScope();
+    const Symbol *inner = table.Declare("x", PrimitiveType::REAL);
+    ASSERT_NE(inner, nullptr);
+    ASSERT_EQ(inner->address_, LOCAL_VAR_PREFIX "0");
+    table.Declare("y", PrimitiveType::BOOL);
+    ASSERT_EQ(table.Declare("y", PrimitiveType::BOOL), nullptr);
+    ASSERT_EQ(table.Lookup("x")->type_, PrimitiveType::REAL);
+    ASSERT_EQ(table.Depth(), 1);
+
+    table.ExitScope();
+    ASSERT_EQ(table.Depth(), 0);
+    ASSERT_EQ(table.Lookup("x")->address_, "x");
+    ASSERT_EQ(table.Lookup("y"), nullptr);
+}
+
+// A freed slot is only handed to a local of the same type.
+TEST(SymbolTableTests, ReusesSlotsPerType) {
+    SymbolTable table;
+    table.EnterScope();
+    ASSERT_EQ(table.Declare("a", PrimitiveType::INT)->slot_, 0);
+    ASSERT_EQ(table.Declare("b", PrimitiveType::REAL)->slot_, 1);
+    table.ExitScope();
+
+    table.EnterScope();
+    ASSERT_EQ(table.Declare("c", PrimitiveType::BOOL)->slot_, 2);
+    ASSERT_EQ(table.Declare("d", PrimitiveType::REAL)->slot_, 1);
+    table.EnterScope();
+    ASSERT_EQ(table.Declare("e", PrimitiveType::INT)->slot_, 0);
+    ASSERT_EQ(table.Declare("f", PrimitiveType::INT)->slot_, 3);
+    table.ExitScope();
+    table.ExitScope();
+}
+
+TEST(SymbolTableTests, BlockScoping) {
+    ASSERT_EQ(RunSource("int x = 1;\n{ int x = 2; print x; }\nprint x;"), "2\n1\n");
+    ASSERT_EQ(RunSource("{ int a = 1; print a; }\n{ int b = 2; print b; }\nprint a;"), "1\n2\nnil\n");
+    ASSERT_EQ(RunSource("{ real a = 1.5; print a; }\n{ int a = 2; print a + 1; }"), "1.5\n3\n");
+    ASSERT_EQ(RunSource("int i = 0;\nwhile (i < 3) { int j = i * 2; i = i + 1; print j; }"), "0\n2\n4\n");
+    ASSERT_EQ(RunSource("{ int a = 1; int a = 2; }"), "<compile error>");
+}
+
+} // namespace "stronk"
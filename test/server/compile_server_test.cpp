@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include "server/compile_server.h"
+
+namespace stronk {
+
+TEST(CompileServerTests, ServesWarmPrograms) {
+    std::filesystem::path socket_path = std::filesystem::temp_directory_path()
+        / ("stronk_server_test_" + std::to_string(getpid()) + ".sock");
+    CompileServer server(socket_path, 2);
+    ASSERT_TRUE(server.Listen());
+    std::thread serving([&server] { server.Serve(); });
+
+    CompileClient client(socket_path);
+    std::string source = "int x = 0; while (x < 5) { x = x + 1; } print x;";
+    auto first = client.Send(ServerRequestKind::RUN, ExecutionEngine::INTERPRETER, source);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_EQ(first->status_, ServerStatus::OK);
+    ASSERT_FALSE(first->cache_hit_);
+    ASSERT_EQ(first->output_, "5\n");
+
+    // Same script again, now from the warm cache and on another engine.
+    auto second = client.Send(ServerRequestKind::RUN, ExecutionEngine::TIERED, source);
+    ASSERT_TRUE(second.has_value());
+    ASSERT_TRUE(second->cache_hit_);
+    ASSERT_EQ(second->output_, "5\n");
+
+    auto error = client.Send(ServerRequestKind::RUN, ExecutionEngine::INTERPRETER, "int y = 5 / 0;");
+    ASSERT_TRUE(error.has_value());
+    ASSERT_EQ(error->status_, ServerStatus::RUNTIME_ERROR);
+
+    ServerStats stats = server.GetStats();
+    ASSERT_EQ(stats.requests_, 3);
+    ASSERT_EQ(stats.cache_hits_, 1);
+    ASSERT_EQ(stats.cached_programs_, 2);
+    ASSERT_GT(stats.max_.count(), 0);
+
+    auto stop = client.Send(ServerRequestKind::SHUTDOWN, ExecutionEngine::INTERPRETER, "");
+    ASSERT_TRUE(stop.has_value());
+    serving.join();
+    ASSERT_FALSE(client.Send(ServerRequestKind::STATS, ExecutionEngine::INTERPRETER, "").has_value());
+}
+
+// A script that never ends fails once it runs out of budget, so the
+// worker is freed and SHUTDOWN still returns.
+TEST(CompileServerTests, LimitsRunawayScripts) {
+    std::filesystem::path socket_path = std::filesystem::temp_directory_path()
+        / ("stronk_server_limit_test_" + std::to_string(getpid()) + ".sock");
+    CompileServer server(socket_path, 1, nullptr, 100000);
+    ASSERT_TRUE(server.Listen());
+    std::thread serving([&server] { server.Serve(); });
+
+    CompileClient client(socket_path);
+    auto runaway = client.Send(ServerRequestKind::RUN, ExecutionEngine::JIT, "int x = 0; while (true) { x = x + 1; }");
+    ASSERT_TRUE(runaway.has_value());
+    ASSERT_EQ(runaway->status_, ServerStatus::RUNTIME_ERROR);
+
+    auto fits = client.Send(ServerRequestKind::RUN, ExecutionEngine::TIERED, "int x = 0; while (x < 5) { x = x + 1; } print x;");
+    ASSERT_TRUE(fits.has_value());
+    ASSERT_EQ(fits->status_, ServerStatus::OK);
+    ASSERT_EQ(fits->output_, "5\n");
+
+    ASSERT_TRUE(client.Send(ServerRequestKind::SHUTDOWN, ExecutionEngine::INTERPRETER, "").has_value());
+    serving.join();
+}
+
+} // namespace "stronk"
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+#include "backend/aot.h"
+#include "backend/vm.h"
+#include "compiler/compiler.h"
+
+// Compares ahead-of-time compiled executables against the
+// interpreter (and JIT) on one program. Without a path a
+// synthetic arithmetic loop is used.
+
+using Clock = std::chrono::steady_clock;
+
+static const char *DEFAULT_PROGRAM = R"(int i = 0;
+int sum = 0;
+real acc = 0.0;
+while (i < 5000000) {
+    sum = sum + i * 3 / 2;
+    acc = acc + i * 0.5;
+    i = i + 1;
+}
+print sum;
+print acc;
+)";
+
+static auto Milliseconds(Clock::duration duration) -> double {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static auto ReadSource(const std::string &path) -> std::string {
+    std::ifstream istream(path);
+    if (!istream.is_open()) {
+        std::cerr << "File does not exist" << "\n";
+        exit(74);
+    }
+    std::stringstream buffer;
+    buffer << istream.rdbuf();
+    return buffer.str();
+}
+
+// Best of `runs` executions of the program in the VM.
+static auto TimeEngine(const stronk::Program &program, stronk::ExecutionEngine engine, int runs) -> double {
+    double best = 0;
+    for (int run = 0; run < runs; run++) {
+        std::ostringstream out;
+        stronk::VirtualMachine vm(out);
+        vm.SetEngine(engine);
+        auto start = Clock::now();
+        vm.Execute(program);
+        double elapsed = Milliseconds(Clock::now() - start);
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+// Best of `runs` executions of the native binary, process startup
+// included.
+static auto TimeExecutable(const std::string &binary, int runs) -> double {
+    std::string command = "'" + binary + "' > /dev/null";
+    double best = 0;
+    for (int run = 0; run < runs; run++) {
+        auto start = Clock::now();
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "Executable failed" << "\n";
+            std::filesystem::remove(binary);
+            exit(70);
+        }
+        double elapsed = Milliseconds(Clock::now() - start);
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+auto main(int argc, const char *argv[]) -> int {
+    if (argc > 3) {
+        std::cerr << "Usage: stronk-aot-bench [path] [runs]\n";
+        return 64;
+    }
+    std::string source = argc > 1 ? ReadSource(argv[1]) : DEFAULT_PROGRAM;
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    stronk::Compiler compiler;
+    if (!compiler.Compile(source)) {
+        return 65;
+    }
+
+    std::string binary = (std::filesystem::temp_directory_path()
+                          / ("stronk-aot-bench-" + std::to_string(getpid()))).string();
+    const char *cc = std::getenv("CC");
+    auto start = Clock::now();
+    stronk::Program program = stronk::LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+    std::string c_source = stronk::TranslateToC(program);
+    if (!stronk::CompileExecutable(c_source, binary, cc != nullptr ? cc : "cc")) {
+        std::cerr << "C compiler failed" << "\n";
+        return 70;
+    }
+    double build = Milliseconds(Clock::now() - start);
+
+    double interpreter = TimeEngine(program, stronk::ExecutionEngine::INTERPRETER, runs);
+    double jit = TimeEngine(program, stronk::ExecutionEngine::JIT, runs);
+    double native = TimeExecutable(binary, runs);
+    std::filesystem::remove(binary);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "aot build    " << std::setw(10) << build << " ms\n";
+    std::cout << "interpreter  " << std::setw(10) << interpreter << " ms\n";
+    std::cout << "jit          " << std::setw(10) << jit << " ms  (" << interpreter / jit << "x)\n";
+    std::cout << "aot          " << std::setw(10) << native << " ms  (" << interpreter / native << "x)\n";
+    return 0;
+}
@@ -0,0 +1,390 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <spawn.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "backend/aot.h"
+#include "backend/vm.h"
+#include "compiler/compiler.h"
+#include "config.h"
+#include "perf_counters.h"
+
+// Runs every program of the benchmark corpus under each execution
+// mode and reports execution time, instructions executed and peak
+// RSS, checking that every mode prints the same output (and the
+// checked-in <name>.out when there is one).
+//
+// Each run happens in a child process so peak RSS is per run.
+// Programs are compiled once up front; VM children inherit the
+// lowered program and time only `Execute`, while AOT runs time the
+// whole process. Children of the VM modes start from a copy of the
+// runner, so their RSS includes the runner's own footprint.
+// Instructions are counted once in the interpreter.
+//
+// With --perf the VM children also read hardware counters around
+// `Execute` (averaged over the runs) and report IPC and counts per
+// instruction executed. AOT runs are not counted, and "perf" is
+// null wherever the counters are unavailable.
+
+extern char **environ;
+
+using Clock = std::chrono::steady_clock;
+
+struct ModeResult {
+    std::string mode_;
+    double ms_ = 0;
+    long peak_rss_kib_ = 0;
+    bool output_ok_ = true;
+    stronk::PerfSample perf_ = {};
+};
+
+struct ProgramResult {
+    std::string name_;
+    uint64_t instructions_ = 0;
+    bool expected_output_ = false;
+    bool expected_ok_ = true;
+    bool output_ok_ = true;
+    std::vector<ModeResult> modes_;
+};
+
+struct RunOutput {
+    double ms_ = 0;
+    long peak_rss_kib_ = 0;
+    std::string output_;
+    stronk::PerfSample perf_ = {};
+};
+
+// Written by a VM child into memory shared with the runner.
+struct ChildReport {
+    double ms_;
+    stronk::PerfSample perf_ = {};
+};
+
+static auto ReadFile(const std::filesystem::path &path) -> std::optional<std::string> {
+    std::ifstream istream(path);
+    if (!istream.is_open()) {
+        return std::nullopt;
+    }
+    std::stringstream buffer;
+    buffer << istream.rdbuf();
+    return buffer.str();
+}
+
+static auto ReadAll(int fd) -> std::string {
+    std::string data;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0 || (n < 0 && errno == EINTR)) {
+        data.append(buffer, n > 0 ? n : 0);
+    }
+    return data;
+}
+
+static auto Compile(const std::string &source) -> std::optional<stronk::Program> {
+    stronk::Compiler compiler;
+    if (!compiler.Compile(source)) {
+        return std::nullopt;
+    }
+    return stronk::LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+}
+
+// Executes the program in a forked child on `engine`, reading the
+// hardware counters around it when `perf` is set.
+static auto RunInChild(const stronk::Program &program, stronk::ExecutionEngine engine, bool perf) -> RunOutput {
+    void *shared = mmap(nullptr, sizeof(ChildReport), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    int fds[2];
+    if (shared == MAP_FAILED || pipe(fds) != 0) {
+        std::cerr << "Could not set up a child run" << "\n";
+        exit(71);
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        std::ostringstream out;
+        stronk::VirtualMachine vm(out);
+        vm.SetEngine(engine);
+        // Opened in the child: counters follow the thread that
+        // opened them.
+        std::optional<stronk::PerfCounters> counters;
+        if (perf) {
+            counters.emplace();
+            counters->Start();
+        }
+        auto start = Clock::now();
+        auto result = vm.Execute(program);
+        double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        new (shared) ChildReport { elapsed, counters ? counters->Stop() : stronk::PerfSample() };
+        std::string output = out.str();
+        ssize_t written = write(fds[1], output.data(), output.size());
+        _exit(result == stronk::InterpretResult::OK && written == static_cast<ssize_t>(output.size()) ? 0 : 70);
+    }
+    close(fds[1]);
+    RunOutput run;
+    run.output_ = ReadAll(fds[0]);
+    close(fds[0]);
+    int status;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    const auto *report = static_cast<const ChildReport *>(shared);
+    run.ms_ = report->ms_;
+    run.perf_ = report->perf_;
+    run.peak_rss_kib_ = usage.ru_maxrss;
+    munmap(shared, sizeof(ChildReport));
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        run.output_ += "<failed>";
+    }
+    return run;
+}
+
+// Runs a native executable. posix_spawn does not copy the runner's
+// address space, so the peak RSS is the executable's own.
+static auto RunExecutable(const std::string &binary) -> RunOutput {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        std::cerr << "Could not set up a child run" << "\n";
+        exit(71);
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+    auto start = Clock::now();
+    char *argv[] = { const_cast<char *>(binary.c_str()), nullptr };
+    pid_t pid;
+    int spawned = posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    RunOutput run;
+    if (spawned != 0) {
+        close(fds[0]);
+        run.output_ = "<failed>";
+        return run;
+    }
+    run.output_ = ReadAll(fds[0]);
+    close(fds[0]);
+    int status;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    run.ms_ = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    run.peak_rss_kib_ = usage.ru_maxrss;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        run.output_ += "<failed>";
+    }
+    return run;
+}
+
+// Best time, highest peak RSS and average counters of `runs` runs;
+// every run must print `reference`.
+template <class Run>
+static auto Measure(const std::string &mode, int runs, const std::string &reference, Run run) -> ModeResult {
+    ModeResult result;
+    result.mode_ = mode;
+    for (int i = 0; i < runs; i++) {
+        RunOutput output = run();
+        result.ms_ = i == 0 ? output.ms_ : std::min(result.ms_, output.ms_);
+        result.peak_rss_kib_ = std::max(result.peak_rss_kib_, output.peak_rss_kib_);
+        result.output_ok_ = result.output_ok_ && output.output_ == reference;
+        result.perf_ += output.perf_;
+    }
+    result.perf_ = result.perf_.Average(runs);
+    return result;
+}
+
+static auto RunProgram(const std::filesystem::path &path, int runs, bool aot, bool perf) -> ProgramResult {
+    ProgramResult result;
+    result.name_ = path.stem().string();
+    std::optional<std::string> source = ReadFile(path);
+    std::optional<stronk::Program> program = source ? Compile(*source) : std::nullopt;
+    if (!program) {
+        std::cerr << path.string() << ": does not compile" << "\n";
+        result.output_ok_ = false;
+        return result;
+    }
+
+    std::ostringstream reference;
+    {
+        stronk::VirtualMachine vm(reference);
+        vm.SetCountInstructions(true);
+        result.output_ok_ = vm.Execute(*program) == stronk::InterpretResult::OK;
+        result.instructions_ = vm.GetInstructionsExecuted();
+    }
+    std::filesystem::path expected_path = path;
+    expected_path.replace_extension(".out");
+    if (auto expected = ReadFile(expected_path)) {
+        result.expected_output_ = true;
+        result.expected_ok_ = *expected == reference.str();
+        result.output_ok_ = result.output_ok_ && result.expected_ok_;
+    }
+
+    const std::pair<const char *, stronk::ExecutionEngine> engines[] = {
+        { "interpreter", stronk::ExecutionEngine::INTERPRETER },
+        { "jit", stronk::ExecutionEngine::JIT },
+        { "tiered", stronk::ExecutionEngine::TIERED },
+    };
+    for (const auto &[mode, engine] : engines) {
+        if (engine != stronk::ExecutionEngine::INTERPRETER && !stronk::JitCompiler::IsSupported()) {
+            continue;
+        }
+        result.modes_.push_back(Measure(mode, runs, reference.str(),
+                                        [&, engine = engine] { return RunInChild(*program, engine, perf); }));
+    }
+
+    if (aot) {
+        std::string binary = (std::filesystem::temp_directory_path()
+            / ("stronk-e2e-" + std::to_string(getpid()) + "-" + result.name_)).string();
+        const char *cc = std::getenv("CC");
+        if (stronk::CompileExecutable(stronk::TranslateToC(*program), binary, cc != nullptr ? cc : "cc")) {
+            result.modes_.push_back(Measure("aot", runs, reference.str(), [&] { return RunExecutable(binary); }));
+            std::filesystem::remove(binary);
+        } else {
+            std::cerr << result.name_ << ": C compiler failed, skipping aot" << "\n";
+        }
+    }
+    for (const auto &mode : result.modes_) {
+        result.output_ok_ = result.output_ok_ && mode.output_ok_;
+    }
+    return result;
+}
+
+// With `perf` the table gains IPC and branch misses per executed
+// instruction; "-" marks counters that were not read.
+static void WriteTable(std::ostream &out, const std::vector<ProgramResult> &results, bool perf) {
+    out << std::left << std::setw(18) << "program" << std::setw(13) << "mode" << std::right << std::setw(11)
+        << "ms" << std::setw(14) << "instrs" << std::setw(12) << "peak KiB";
+    if (perf) {
+        out << std::setw(8) << "ipc" << std::setw(14) << "br-miss/instr";
+    }
+    out << "  output\n";
+    out << std::fixed << std::setprecision(2);
+    for (const auto &program : results) {
+        for (const auto &mode : program.modes_) {
+            out << std::left << std::setw(18) << program.name_ << std::setw(13) << mode.mode_ << std::right
+                << std::setw(11) << mode.ms_ << std::setw(14) << program.instructions_ << std::setw(12)
+                << mode.peak_rss_kib_;
+            if (perf) {
+                const stronk::PerfSample &sample = mode.perf_;
+                bool ipc = sample.Has(stronk::PerfEvent::CYCLES) && sample.Has(stronk::PerfEvent::INSTRUCTIONS)
+                    && sample.Get(stronk::PerfEvent::CYCLES) > 0;
+                bool misses = sample.Has(stronk::PerfEvent::BRANCH_MISSES) && program.instructions_ > 0;
+                out << std::setw(8);
+                if (ipc) {
+                    out << static_cast<double>(sample.Get(stronk::PerfEvent::INSTRUCTIONS))
+                        / sample.Get(stronk::PerfEvent::CYCLES);
+                } else {
+                    out << "-";
+                }
+                out << std::setw(14) << std::setprecision(4);
+                if (misses) {
+                    out << static_cast<double>(sample.Get(stronk::PerfEvent::BRANCH_MISSES)) / program.instructions_;
+                } else {
+                    out << "-";
+                }
+                out << std::setprecision(2);
+            }
+            out << "  " << (mode.output_ok_ ? "ok" : "MISMATCH") << "\n";
+        }
+        if (!program.expected_output_) {
+            out << std::left << std::setw(18) << program.name_ << "(no .out file to check against)\n";
+        } else if (!program.expected_ok_) {
+            out << std::left << std::setw(18) << program.name_ << "(output differs from the .out file)\n";
+        }
+    }
+}
+
+static void WriteJson(std::ostream &out, const std::vector<ProgramResult> &results, int runs, bool perf) {
+    out << std::setprecision(6);
+    out << "{\n  \"schema\": 2,\n  \"suite\": \"e2e\",\n  \"runs\": " << runs
+        << ",\n  \"perf\": " << (perf ? "true" : "false") << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const ProgramResult &program = results[i];
+        out << "    {\n      \"program\": \"" << program.name_ << "\", \"instructions\": " << program.instructions_
+            << ", \"expected_output\": " << (program.expected_output_ ? "true" : "false")
+            << ", \"output_ok\": " << (program.output_ok_ ? "true" : "false") << ",\n      \"modes\": [\n";
+        for (size_t j = 0; j < program.modes_.size(); j++) {
+            const ModeResult &mode = program.modes_[j];
+            out << "        { \"mode\": \"" << mode.mode_ << "\", \"ms\": " << mode.ms_
+                << ", \"peak_rss_kib\": " << mode.peak_rss_kib_
+                << ", \"output_ok\": " << (mode.output_ok_ ? "true" : "false") << ", \"perf\": ";
+            mode.perf_.WriteJson(out, program.instructions_, "instructions executed");
+            out << " }" << (j + 1 < program.modes_.size() ? "," : "") << "\n";
+        }
+        out << "      ]\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+static void Usage() {
+    std::cerr << "Usage: stronk-e2e-bench [--runs=N] [--json] [--perf] [--no-aot] [corpus-dir]\n";
+    exit(64);
+}
+
+auto main(int argc, const char *argv[]) -> int {
+    int runs = 3;
+    bool json = false;
+    bool aot = true;
+    bool perf = false;
+    std::filesystem::path corpus = std::string(BASE_DIR) + "/tools/bench/corpus";
+    bool custom_corpus = false;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg.rfind("--runs=", 0) == 0) {
+            runs = std::max(1, std::atoi(argv[i] + 7));
+        } else if (arg == "--json") {
+            json = true;
+        } else if (arg == "--perf") {
+            perf = true;
+        } else if (arg == "--no-aot") {
+            aot = false;
+        } else if (arg.rfind("--", 0) == 0 || custom_corpus) {
+            Usage();
+        } else {
+            corpus = arg;
+            custom_corpus = true;
+        }
+    }
+
+    std::vector<std::filesystem::path> programs;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(corpus, ec)) {
+        if (entry.path().extension() == ".stronk") {
+            programs.push_back(entry.path());
+        }
+    }
+    if (ec || programs.empty()) {
+        std::cerr << "No programs in " << corpus.string() << "\n";
+        return 74;
+    }
+    std::sort(programs.begin(), programs.end());
+    if (perf) {
+        stronk::PerfCounters counters;
+        if (!counters.Available()) {
+            std::cerr << "Hardware counters unavailable (" << counters.Error() << "), reporting time only" << "\n";
+            perf = false;
+        }
+    }
+
+    std::vector<ProgramResult> results;
+    bool ok = true;
+    for (const auto &path : programs) {
+        results.push_back(RunProgram(path, runs, aot, perf));
+        ok = ok && results.back().output_ok_;
+    }
+    if (json) {
+        WriteJson(std::cout, results, runs, perf);
+    } else {
+        WriteTable(std::cout, results, perf);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "compiler/constant_pool.h"
+#include "frontend/code_generator.h"
+#include "frontend/parser.h"
+#include "frontend/scanner.h"
+#include "perf_counters.h"
+#include "synthetic_program.h"
+
+// Measures the throughput of each frontend stage on its own over
+// generated programs and prints the results as JSON. The key set
+// and order are fixed (see `schema`) so runs can be diffed across
+// versions.
+//
+// The parser emits code as it parses, so the parser figures
+// include instruction emission; the code generator is measured by
+// replaying the emitted instructions into a fresh generator.
+// String literals are only fed to the scanner since the parser
+// does not support them yet.
+//
+// With --perf each phase also reports hardware counters (averaged
+// over the runs), IPC and counts per item; "perf" is null when the
+// counters are unavailable.
+
+using Clock = std::chrono::steady_clock;
+
+struct Phase {
+    const char *name_;
+    const char *unit_;
+    size_t items_ = 0;
+    size_t bytes_ = 0;
+    double seconds_ = 0;
+    stronk::PerfSample perf_ = {};
+};
+
+struct BenchOptions {
+    int runs = 5;
+    bool perf = false;
+    bool custom = false;
+    stronk::SyntheticConfig config;
+};
+
+// Best of `runs` calls to `body`; `setup` runs untimed before each.
+// Counters, when given, are summed over all runs into `perf`.
+template <class Setup, class Body>
+static auto BestOf(int runs, stronk::PerfCounters *counters, stronk::PerfSample &perf, Setup setup, Body body)
+        -> double {
+    double best = 0;
+    for (int run = 0; run < runs; run++) {
+        setup();
+        if (counters != nullptr) {
+            counters->Start();
+        }
+        auto start = Clock::now();
+        body();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (counters != nullptr) {
+            perf += counters->Stop();
+        }
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+    perf = perf.Average(runs);
+    return best;
+}
+
+static auto Scan(std::string_view source) -> std::vector<std::shared_ptr<stronk::Token>> {
+    std::vector<std::shared_ptr<stronk::Token>> tokens;
+    stronk::Scanner scanner;
+    scanner.LoadSource(source);
+    do {
+        tokens.push_back(scanner.ScanNextToken());
+    } while (tokens.back()->type_ != stronk::TokenType::TOKEN_EOF);
+    return tokens;
+}
+
+static auto LiteralValues(const std::vector<std::shared_ptr<stronk::Token>> &tokens)
+        -> std::vector<stronk::ConstantPool::ConstantValue> {
+    std::vector<stronk::ConstantPool::ConstantValue> values;
+    for (const auto &token : tokens) {
+        if (auto *value = dynamic_cast<stronk::ValueToken<int> *>(token.get())) {
+            values.emplace_back(value->value_);
+        } else if (auto *value = dynamic_cast<stronk::ValueToken<float> *>(token.get())) {
+            values.emplace_back(value->value_);
+        } else if (auto *value = dynamic_cast<stronk::ValueToken<std::string> *>(token.get())) {
+            if (token->type_ == stronk::TokenType::TEXT) {
+                values.emplace_back(value->value_);
+            }
+        }
+    }
+    return values;
+}
+
+static auto RunConfig(const stronk::SyntheticConfig &config, int runs, stronk::PerfCounters *counters)
+        -> std::vector<Phase> {
+    std::string source = stronk::GenerateProgram(config);
+    stronk::SyntheticConfig parse_config = config;
+    parse_config.string_density_ = 0;
+    std::string parse_source = config.string_density_ > 0 ? stronk::GenerateProgram(parse_config) : source;
+
+    Phase scanner = { "scanner", "tokens" };
+    scanner.bytes_ = source.size();
+    scanner.seconds_ = BestOf(runs, counters, scanner.perf_, [] {}, [&] { scanner.items_ = Scan(source).size(); });
+
+    auto tokens = Scan(parse_source);
+    Phase parser = { "parser", "instructions" };
+    parser.bytes_ = parse_source.size();
+    std::unique_ptr<stronk::Parser> parsing;
+    parser.seconds_ = BestOf(runs, counters, parser.perf_, [&] {
+        parsing = std::make_unique<stronk::Parser>();
+        for (const auto &token : tokens) {
+            parsing->AddToken(token);
+        }
+    }, [&] { parsing->Parse(); });
+    if (parsing->HadError()) {
+        std::cerr << "Generated program does not parse" << "\n";
+        exit(70);
+    }
+    stronk::Module module = parsing->TakeModule();
+    const stronk::Bytecode &bytecode = module.code_;
+    const stronk::ConstantPool &pool = module.constants_;
+    parser.items_ = bytecode.size();
+
+    Phase code_generator = { "code_generator", "instructions", bytecode.size(), parse_source.size() };
+    std::unique_ptr<stronk::CodeGenerator> generator;
+    code_generator.seconds_ = BestOf(runs, counters, code_generator.perf_, [&] { generator = std::make_unique<stronk::CodeGenerator>(); }, [&] {
+        for (const auto &instr : bytecode) {
+            if (auto *constant = dynamic_cast<stronk::ConstInstr *>(instr.get())) {
+                generator->AddConstantInstruction(constant->dest_, pool.GetConstant(constant->index_),
+                                                  instr->line_, instr->pos_);
+            } else {
+                generator->AddInstruction(instr);
+            }
+        }
+    });
+
+    auto values = LiteralValues(Scan(source));
+    Phase constant_pool = { "constant_pool", "constants", values.size(), source.size() };
+    std::unique_ptr<stronk::ConstantPool> constants;
+    constant_pool.seconds_ = BestOf(runs, counters, constant_pool.perf_, [&] { constants = std::make_unique<stronk::ConstantPool>(); }, [&] {
+        for (const auto &value : values) {
+            constants->AddConstant(value);
+        }
+    });
+
+    return { scanner, parser, code_generator, constant_pool };
+}
+
+static void WriteResult(std::ostream &out, const stronk::SyntheticConfig &config, const std::vector<Phase> &phases) {
+    out << "    {\n"
+        << "      \"config\": { \"bytes\": " << config.bytes_ << ", \"depth\": " << config.depth_
+        << ", \"expression_depth\": " << config.expression_depth_
+        << ", \"string_density\": " << config.string_density_ << ", \"identifiers\": " << config.identifiers_
+        << ", \"seed\": " << config.seed_ << " },\n";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const Phase &phase = phases[i];
+        double seconds = std::max(phase.seconds_, 1e-9);
+        out << "      \"" << phase.name_ << "\": { \"unit\": \"" << phase.unit_ << "\", \"items\": " << phase.items_
+            << ", \"bytes\": " << phase.bytes_ << ", \"seconds\": " << phase.seconds_
+            << ", \"items_per_s\": " << phase.items_ / seconds
+            << ", \"mb_per_s\": " << phase.bytes_ / seconds / 1e6 << ", \"perf\": ";
+        phase.perf_.WriteJson(out, phase.items_, phase.unit_);
+        out << " }" << (i + 1 < phases.size() ? "," : "") << "\n";
+    }
+    out << "    }";
+}
+
+// Scales each dimension on its own around a 256 KiB baseline.
+static auto DefaultSweep() -> std::vector<stronk::SyntheticConfig> {
+    std::vector<stronk::SyntheticConfig> configs;
+    auto add = [&configs](size_t bytes, int depth, double strings, int identifiers, int expression_depth = 3) {
+        stronk::SyntheticConfig config;
+        config.bytes_ = bytes;
+        config.depth_ = depth;
+        config.expression_depth_ = expression_depth;
+        config.string_density_ = strings;
+        config.identifiers_ = identifiers;
+        configs.push_back(config);
+    };
+    for (size_t bytes : { 16 << 10, 256 << 10, 1 << 20 }) {
+        add(bytes, 4, 0, 64);
+    }
+    for (int depth : { 1, 16 }) {
+        add(256 << 10, depth, 0, 64);
+    }
+    // Expression dense: long operator chains, few statements.
+    add(256 << 10, 4, 0, 64, 8);
+    add(256 << 10, 4, 0.25, 64);
+    for (int identifiers : { 8, 4096 }) {
+        add(256 << 10, 4, 0, identifiers);
+    }
+    return configs;
+}
+
+static void Usage() {
+    std::cerr << "Usage: stronk-bench [--runs=N] [--perf] [--size=bytes] [--depth=N] [--expr-depth=N]\n"
+              << "                    [--strings=fraction] [--identifiers=N] [--seed=N]\n"
+              << "Without a shape option a fixed sweep over all dimensions is run.\n";
+    exit(64);
+}
+
+auto main(int argc, const char *argv[]) -> int {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        auto value = [&arg](size_t prefix) { return std::string(arg.substr(prefix)); };
+        if (arg.rfind("--runs=", 0) == 0) {
+            options.runs = std::max(1, std::stoi(value(7)));
+            continue;
+        }
+        if (arg == "--perf") {
+            options.perf = true;
+            continue;
+        }
+        options.custom = true;
+        if (arg.rfind("--size=", 0) == 0) {
+            options.config.bytes_ = std::stoul(value(7));
+        } else if (arg.rfind("--depth=", 0) == 0) {
+            options.config.depth_ = std::stoi(value(8));
+        } else if (arg.rfind("--expr-depth=", 0) == 0) {
+            options.config.expression_depth_ = std::stoi(value(13));
+        } else if (arg.rfind("--strings=", 0) == 0) {
+            options.config.string_density_ = std::stod(value(10));
+        } else if (arg.rfind("--identifiers=", 0) == 0) {
+            options.config.identifiers_ = std::stoi(value(14));
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            options.config.seed_ = std::stoull(value(7));
+        } else {
+            Usage();
+        }
+    }
+
+    std::vector<stronk::SyntheticConfig> configs = options.custom
+        ? std::vector<stronk::SyntheticConfig>{ options.config }
+        : DefaultSweep();
+
+    std::unique_ptr<stronk::PerfCounters> counters;
+    if (options.perf) {
+        counters = std::make_unique<stronk::PerfCounters>();
+        if (!counters->Available()) {
+            std::cerr << "Hardware counters unavailable (" << counters->Error() << "), reporting time only" << "\n";
+            counters.reset();
+        }
+    }
+
+    std::ostringstream out;
+    out << std::setprecision(6);
+    out << "{\n  \"schema\": 3,\n  \"suite\": \"frontend\",\n  \"runs\": " << options.runs
+        << ",\n  \"perf\": " << (counters != nullptr ? "true" : "false") << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < configs.size(); i++) {
+        WriteResult(out, configs[i], RunConfig(configs[i], options.runs, counters.get()));
+        out << (i + 1 < configs.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    std::cout << out.str();
+    return 0;
+}
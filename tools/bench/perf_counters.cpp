@@ -0,0 +1,192 @@
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace stronk {
+
+auto PerfEventName(PerfEvent event) -> const char * {
+    switch (event) {
+        case PerfEvent::CYCLES: return "cycles";
+        case PerfEvent::INSTRUCTIONS: return "instructions";
+        case PerfEvent::BRANCH_MISSES: return "branch_misses";
+        case PerfEvent::L1D_MISSES: return "l1d_misses";
+        case PerfEvent::LLC_MISSES: return "llc_misses";
+        default: return "unknown";
+    }
+}
+
+auto PerfSample::operator+=(const PerfSample &other) -> PerfSample & {
+    for (size_t i = 0; i < _STRONK_PERF_EVENTS; i++) {
+        values_[i] += other.values_[i];
+        present_[i] = present_[i] || other.present_[i];
+    }
+    return *this;
+}
+
+auto PerfSample::Average(int runs) const -> PerfSample {
+    PerfSample sample = *this;
+    for (auto &value : sample.values_) {
+        value /= static_cast<uint64_t>(std::max(runs, 1));
+    }
+    return sample;
+}
+
+void PerfSample::WriteJson(std::ostream &out, uint64_t items, const char *unit) const {
+    bool any = false;
+    for (bool present : present_) {
+        any = any || present;
+    }
+    if (!any) {
+        out << "null";
+        return;
+    }
+    out << "{ ";
+    for (size_t i = 0; i < _STRONK_PERF_EVENTS; i++) {
+        if (present_[i]) {
+            out << "\"" << PerfEventName(static_cast<PerfEvent>(i)) << "\": " << values_[i] << ", ";
+        }
+    }
+    if (Has(PerfEvent::CYCLES) && Has(PerfEvent::INSTRUCTIONS) && Get(PerfEvent::CYCLES) > 0) {
+        out << "\"ipc\": " << static_cast<double>(Get(PerfEvent::INSTRUCTIONS)) / Get(PerfEvent::CYCLES) << ", ";
+    }
+    out << "\"per\": \"" << unit << "\"";
+    for (size_t i = 0; i < _STRONK_PERF_EVENTS; i++) {
+        if (present_[i] && items > 0) {
+            out << ", \"" << PerfEventName(static_cast<PerfEvent>(i)) << "_per_item\": "
+                << static_cast<double>(values_[i]) / items;
+        }
+    }
+    out << " }";
+}
+
+#ifdef __linux__
+
+namespace {
+
+auto Open(PerfEvent event) -> int {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    // User space only, which is what perf_event_paranoid 2 allows.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    auto cache_miss = [](uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    switch (event) {
+        case PerfEvent::CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfEvent::INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfEvent::BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PerfEvent::L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case PerfEvent::LLC_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+            break;
+    }
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    for (size_t i = 0; i < _STRONK_PERF_EVENTS; i++) {
+        fds_[i] = Open(static_cast<PerfEvent>(i));
+        if (fds_[i] < 0 && error_.empty()) {
+            error_ = std::string("perf_event_open: ") + std::strerror(errno);
+        }
+    }
+    if (Available()) {
+        error_.clear();
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+auto PerfCounters::Available() const -> bool {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::Start() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+auto PerfCounters::Stop() -> PerfSample {
+    PerfSample sample;
+    for (size_t i = 0; i < _STRONK_PERF_EVENTS; i++) {
+        if (fds_[i] < 0) {
+            continue;
+        }
+        ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (read(fds_[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            continue;
+        }
+        sample.values_[i] = data[2] < data[1]
+            ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2])
+            : data[0];
+        sample.present_[i] = true;
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("perf_event_open is Linux only") {
+    fds_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+auto PerfCounters::Available() const -> bool {
+    return false;
+}
+
+void PerfCounters::Start() {}
+
+auto PerfCounters::Stop() -> PerfSample {
+    return {};
+}
+
+#endif
+
+} // namespace "stronk"
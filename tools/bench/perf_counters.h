@@ -0,0 +1,68 @@
+#ifndef _STRONK_PERF_COUNTERS_H
+#define _STRONK_PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace stronk {
+
+enum class PerfEvent {
+    CYCLES,
+    INSTRUCTIONS,
+    BRANCH_MISSES,
+    L1D_MISSES,
+    LLC_MISSES
+};
+
+enum PERF_COUNTERS_CONSTANTS {
+    _STRONK_PERF_EVENTS = 5
+};
+
+auto PerfEventName(PerfEvent event) -> const char *;
+
+// Counter values, scaled up when the kernel multiplexed them.
+// Events that could not be opened are missing rather than zero.
+struct PerfSample {
+    std::array<uint64_t, _STRONK_PERF_EVENTS> values_ = {};
+    std::array<bool, _STRONK_PERF_EVENTS> present_ = {};
+
+    auto Has(PerfEvent event) const -> bool { return present_[static_cast<size_t>(event)]; }
+    auto Get(PerfEvent event) const -> uint64_t { return values_[static_cast<size_t>(event)]; }
+    auto operator+=(const PerfSample &other) -> PerfSample &;
+    // Every value divided by `runs`.
+    auto Average(int runs) const -> PerfSample;
+
+    // JSON object with the raw counts, IPC and every count per
+    // `unit` (e.g. tokens or instructions executed), or null when
+    // nothing was counted.
+    void WriteJson(std::ostream &out, uint64_t items, const char *unit) const;
+};
+
+// User-space hardware counters of the calling thread, read with
+// perf_event_open(2). Each event is opened on its own so a PMU
+// without, say, LLC events still reports the rest. When no event
+// can be opened (no PMU in a VM, perf_event_paranoid, non-Linux)
+// `Available` is false and samples are empty.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    auto operator=(const PerfCounters &) -> PerfCounters & = delete;
+
+    auto Available() const -> bool;
+    // Why no event could be opened.
+    auto Error() const -> const std::string & { return error_; }
+
+    void Start();
+    auto Stop() -> PerfSample;
+private:
+    std::array<int, _STRONK_PERF_EVENTS> fds_;
+    std::string error_;
+};
+
+} // namespace "stronk"
+
+#endif // _STRONK_PERF_COUNTERS_H
@@ -0,0 +1,158 @@
+#include "synthetic_program.h"
+
+namespace stronk {
+
+namespace {
+
+const char *OPERATORS[] = { " + ", " - ", " * ", " / " };
+const char *COMPARISONS[] = { " < ", " <= ", " > ", " >= ", " == ", " != " };
+
+class Generator {
+public:
+    explicit Generator(const SyntheticConfig &config)
+        : config_(config), state_(config.seed_ * 0x9e3779b97f4a7c15ull + 1) {
+        if (config_.identifiers_ < 2) {
+            config_.identifiers_ = 2;
+        }
+    }
+
+    auto Run() -> std::string {
+        for (int i = 0; i < config_.identifiers_; i++) {
+            out_ += IsReal(i) ? "real " : "int ";
+            out_ += Name(i) + " = " + (IsReal(i) ? "0.5" : std::to_string(i)) + ";\n";
+        }
+        while (out_.size() < config_.bytes_) {
+            for (int i = 0; i < 3; i++) {
+                Statement(0);
+            }
+            Compound(0);
+        }
+        return std::move(out_);
+    }
+private:
+    SyntheticConfig config_;
+    uint64_t state_;
+    std::string out_;
+
+    // xorshift64*, fixed so programs never change with the library.
+    auto Next(uint64_t bound) -> uint64_t {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return (state_ * 0x2545f4914f6cdd1dull >> 32) % bound;
+    }
+
+    // One variable in four is real.
+    static auto IsReal(int var) -> bool { return var % 4 == 3; }
+    // Letters only (the scanner stops identifiers at digits); the
+    // x prefix keeps clear of every keyword.
+    static auto Name(int var) -> std::string {
+        std::string name = "x";
+        do {
+            name += static_cast<char>('a' + var % 26);
+            var /= 26;
+        } while (var > 0);
+        return name;
+    }
+
+    auto IntVar() -> int {
+        int var = static_cast<int>(Next(config_.identifiers_));
+        return IsReal(var) ? var - 1 : var;
+    }
+    auto AnyVar() -> int { return static_cast<int>(Next(config_.identifiers_)); }
+
+    void Indent(int level) { out_.append(4 * level, ' '); }
+
+    void IntExpr(int depth) {
+        if (depth == 0 || Next(3) == 0) {
+            out_ += Next(2) == 0 ? Name(IntVar()) : std::to_string(Next(1000));
+            return;
+        }
+        bool group = Next(4) == 0;
+        out_ += group ? "(" : "";
+        IntExpr(depth - 1);
+        out_ += OPERATORS[Next(4)];
+        IntExpr(depth - 1);
+        out_ += group ? ")" : "";
+    }
+
+    // Mixes int and real operands so conversions are generated.
+    void RealExpr(int depth) {
+        if (depth == 0 || Next(3) == 0) {
+            switch (Next(3)) {
+                case 0: out_ += Name(AnyVar()); break;
+                case 1: out_ += std::to_string(Next(100)) + "." + std::to_string(Next(100)); break;
+                default: out_ += Name(IntVar()); break;
+            }
+            return;
+        }
+        bool group = Next(4) == 0;
+        out_ += group ? "(" : "";
+        RealExpr(depth - 1);
+        out_ += OPERATORS[Next(4)];
+        RealExpr(depth - 1);
+        out_ += group ? ")" : "";
+    }
+
+    void Condition() {
+        IntExpr(2);
+        out_ += COMPARISONS[Next(6)];
+        IntExpr(2);
+        if (Next(3) == 0) {
+            out_ += Next(2) == 0 ? " and " : " or ";
+            // Comparisons need equal types; the literal makes
+            // both sides real.
+            RealExpr(1);
+            out_ += " + 0.5";
+            out_ += COMPARISONS[Next(4)];
+            RealExpr(1);
+            out_ += " - 0.5";
+        }
+    }
+
+    void Statement(int level) {
+        Indent(level);
+        if (Next(1000) < static_cast<uint64_t>(config_.string_density_ * 1000)) {
+            out_ += "print \"value ${ " + Name(AnyVar()) + " } of " + std::to_string(Next(1000)) + "\";\n";
+            return;
+        }
+        if (Next(5) == 0) {
+            out_ += "print ";
+            RealExpr(config_.expression_depth_);
+            out_ += ";\n";
+            return;
+        }
+        int var = AnyVar();
+        out_ += Name(var) + " = ";
+        if (IsReal(var)) {
+            RealExpr(config_.expression_depth_);
+        } else {
+            IntExpr(config_.expression_depth_);
+        }
+        out_ += ";\n";
+    }
+
+    void Compound(int level) {
+        if (level >= config_.depth_) {
+            Statement(level);
+            return;
+        }
+        Indent(level);
+        out_ += Next(2) == 0 ? "if (" : "while (";
+        Condition();
+        out_ += ") {\n";
+        Statement(level + 1);
+        Compound(level + 1);
+        Statement(level + 1);
+        Indent(level);
+        out_ += "}\n";
+    }
+};
+
+} // namespace
+
+auto GenerateProgram(const SyntheticConfig &config) -> std::string {
+    return Generator(config).Run();
+}
+
+} // namespace "stronk"
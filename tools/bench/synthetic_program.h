@@ -0,0 +1,37 @@
+#ifndef _STRONK_SYNTHETIC_PROGRAM_H
+#define _STRONK_SYNTHETIC_PROGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stronk {
+
+// Shape of a generated program. The generator is deterministic for
+// a given config (it does not depend on the standard library's
+// distributions), so results stay comparable across versions.
+struct SyntheticConfig {
+    // Approximate source size; generation stops at the first
+    // top-level statement past it.
+    size_t bytes_ = 64 * 1024;
+    // Every top-level compound statement nests if/while blocks
+    // this deep.
+    int depth_ = 4;
+    // Operator nesting of assigned and printed expressions; each
+    // level may split an operand into a binary operation.
+    int expression_depth_ = 3;
+    // Fraction of statements printing an interpolated string.
+    double string_density_ = 0.0;
+    // Number of distinct global variables referenced.
+    int identifiers_ = 64;
+    uint64_t seed_ = 1;
+};
+
+// Generates a program of global declarations followed by
+// assignments, prints and nested ifs/whiles. Every loop condition
+// is arbitrary, so the program is meant to be compiled, not run.
+auto GenerateProgram(const SyntheticConfig &config) -> std::string;
+
+} // namespace "stronk"
+
+#endif // _STRONK_SYNTHETIC_PROGRAM_H
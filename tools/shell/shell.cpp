@@ -1,33 +1,120 @@
+#include <charconv>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <thread>
 
 #include "common/common.h"
+#include "common/mem_stats.h"
 #include "compiler/compiler.h"
+#include "backend/aot.h"
+#include "backend/program_cache.h"
+#include "compiler/batch_compiler.h"
 #include "backend/vm.h"
+#include "server/compile_server.h"
 
-#define COMPUTE_PERF 0
+// Options parsed from the command line.
+struct ShellOptions {
+    std::string path;
+    bool gc_stats = false;
+    bool profile = false;
+    bool mem_stats = false;
+    std::string sample_output;
+    int sample_hz = stronk::_STRONK_SAMPLE_DEFAULT_HZ;
+    stronk::ExecutionEngine engine = stronk::ExecutionEngine::INTERPRETER;
+    uint32_t tier_up_threshold = 1000;
+    bool emit_c = false;
+    bool disassemble = false;
+    std::string aot_output;
+    uint32_t trace_categories = 0;
+    std::string trace_output = "stronk.trace";
+    bool use_cache = true;
+    bool compile_all = false;
+    size_t jobs = std::thread::hardware_concurrency();
+    bool server = false;
+    bool connect = false;
+    std::string socket_path;
+    bool latency = false;
+    bool server_stats = false;
+    bool stop_server = false;
+};
 
-#if COMPUTE_PERF
-#include <chrono>
-using namespace std::chrono;
-
-#define INTERPRET_WITH_PERF() \
-    auto start = std::chrono::high_resolution_clock::now(); \
-    auto stop = std::chrono::high_resolution_clock::now(); \
-    auto duration = duration_cast<microseconds>(stop - start); \
-    std::cout << duration.count() / 1000.0 << " ms\n";
-#endif
-
-// Starts reading from standard input as a REPL and
-// compiles + interprets (the bytecode) of each line.
-static void Repl() {
+// Trace log of the session. File scope so the log is flushed
+// during static destruction even when the shell exits on an error.
+static std::ofstream trace_file;
+static std::unique_ptr<stronk::Tracer> tracer;
+
+// Applies the options to `compiler` and `vm`, opens the trace log
+// and starts the sampling profiler when requested.
+static auto Configure(const ShellOptions &options, stronk::Compiler &compiler, stronk::VirtualMachine &vm)
+        -> std::unique_ptr<stronk::SamplingProfiler> {
+    if (options.trace_categories != 0 && tracer == nullptr) {
+        trace_file.open(options.trace_output, std::ios::binary);
+        if (!trace_file.is_open()) {
+            std::cerr << "Could not open " << options.trace_output << "\n";
+            exit(74);
+        }
+        tracer = std::make_unique<stronk::Tracer>(trace_file, options.trace_categories);
+    }
+    compiler.SetTracer(tracer.get());
+    compiler.SetDisassembly(options.disassemble ? &std::cerr : nullptr);
+    vm.SetTracer(tracer.get());
+
+    vm.SetEngine(options.engine);
+    vm.SetTierUpThreshold(options.tier_up_threshold);
+    if (options.sample_output.empty()) {
+        return nullptr;
+    }
+    auto sampler = std::make_unique<stronk::SamplingProfiler>();
+    if (!sampler->Start(options.sample_hz)) {
+        std::cerr << "Could not start the sampling profiler" << "\n";
+        exit(70);
+    }
+    vm.SetSampler(sampler.get());
+    return sampler;
+}
+
+// `allocations_start` is the allocation count before the source
+// was compiled, so --mem-stats covers the compiler and the VM.
+static void ReportStats(const ShellOptions &options, stronk::VirtualMachine &vm,
+                        stronk::SamplingProfiler *sampler, const stronk::MemStats &allocations_start,
+                        size_t source_bytes) {
+    if (sampler != nullptr) {
+        sampler->Stop();
+        vm.SetSampler(nullptr);
+        std::ofstream out(options.sample_output);
+        sampler->WriteCollapsed(out);
+        std::cerr << sampler->GetSamples() << " samples (" << sampler->GetDropped() << " dropped) written to "
+                  << options.sample_output << "\n";
+    }
+    if (options.gc_stats) {
+        vm.GetHeap().DumpStats(std::cerr);
+    }
+    if (options.profile) {
+        vm.GetProfiler().Report(std::cerr);
+    }
+    if (options.mem_stats) {
+        (stronk::MemStats::Current() - allocations_start).Report(std::cerr, source_bytes);
+    }
+}
+
+// Starts reading from standard input as a REPL. Each line is
+// compiled on its own and only its bytecode runs; declarations
+// stay in the compiler and values in the VM's globals.
+static void Repl(const ShellOptions &options) {
     // TODO(thomasspradling): Handle REPL scoping.
 
     std::string line;
+    size_t source_bytes = 0;
+    stronk::MemStats allocations_start = stronk::MemStats::Current();
     stronk::Compiler compiler;
     stronk::VirtualMachine vm;
+    auto sampler = Configure(options, compiler, vm);
 
     for (;;) {
         std::cout << "> ";
@@ -37,23 +124,46 @@ static void Repl() {
             break;
         }
 
-        if (compiler.Compile(line)) {
+        source_bytes += line.size() + 1;
+        if (!compiler.Compile(line)) {
             exit(65); // compile time error
         }
 
-        stronk::Bytecode bytecode = compiler.GetBytecode();
-
-        if (vm.Interpret(bytecode)) {
+        if (vm.Interpret(compiler.TakeModule()) != stronk::InterpretResult::OK) {
             exit(70); // runtime error
         }
     }
+    ReportStats(options, vm, sampler.get(), allocations_start, source_bytes);
+}
+
+// Translates the program to C and either prints it or builds a
+// native executable with the system C compiler ($CC or cc).
+static void CompileAheadOfTime(const ShellOptions &options, const stronk::Bytecode &bytecode,
+                               const stronk::ConstantPool &constant_pool) {
+    std::string c_source;
+    try {
+        c_source = stronk::TranslateToC(stronk::LowerBytecode(bytecode, constant_pool));
+    } catch (const std::invalid_argument &e) {
+        std::cerr << e.what() << "\n";
+        exit(65);
+    }
+
+    if (options.emit_c) {
+        std::cout << c_source;
+        return;
+    }
+    const char *cc = std::getenv("CC");
+    if (!stronk::CompileExecutable(c_source, options.aot_output, cc != nullptr ? cc : "cc")) {
+        std::cerr << "C compiler failed" << "\n";
+        exit(70);
+    }
 }
 
 // Reads an entire file and feeds contents to VM to
 // compiler and interpret it.
-static void RunFile(std::string_view path) {
+static void RunFile(const ShellOptions &options) {
     // Turn file into a string.
-    std::string filepath(path);
+    std::string filepath(options.path);
     std::ifstream istream(filepath);
 
     if (!istream.is_open()) {
@@ -66,30 +176,260 @@ static void RunFile(std::string_view path) {
 
     std::string source = buffer.str();
 
+    stronk::MemStats allocations_start = stronk::MemStats::Current();
     stronk::Compiler compiler;
     stronk::VirtualMachine vm;
+    auto sampler = Configure(options, compiler, vm);
 
-    if (compiler.Compile(source)) {
-        exit(65); // compile time error
+    // The frontend is skipped entirely for cached programs, so the
+    // cache is bypassed when its output was asked for.
+    uint32_t frontend_traces = static_cast<uint32_t>(stronk::TraceCategory::TOKENS)
+        | static_cast<uint32_t>(stronk::TraceCategory::IR);
+    bool use_cache = options.use_cache && !options.emit_c && options.aot_output.empty() && !options.disassemble
+        && (options.trace_categories & frontend_traces) == 0;
+    stronk::ProgramCache cache(stronk::ProgramCache::DefaultDirectory());
+
+    std::optional<stronk::Program> program;
+    if (use_cache) {
+        program = cache.Load(source);
     }
 
-    stronk::Bytecode bytecode = compiler.GetBytecode();
+    if (!program) {
+        if (!compiler.Compile(source)) {
+            exit(65); // compile time error
+        }
 
-    if (vm.Interpret(bytecode)) {
+        if (options.emit_c || !options.aot_output.empty()) {
+            CompileAheadOfTime(options, compiler.GetBytecode(), compiler.GetConstantPool());
+            return;
+        }
+
+        try {
+            program = stronk::LowerBytecode(compiler.GetBytecode(), compiler.GetConstantPool());
+        } catch (const std::invalid_argument &e) {
+            std::cerr << "Invalid bytecode: " << e.what() << "\n";
+            exit(65);
+        }
+        if (use_cache) {
+            cache.Store(source, *program);
+        }
+    }
+
+    if (vm.Execute(std::move(*program)) != stronk::InterpretResult::OK) {
         exit(70); // runtime error
     }
+    ReportStats(options, vm, sampler.get(), allocations_start, source.size());
+}
+
+// Compiles every script below the directory `options.path` in
+// parallel, filling the program cache, and reports throughput.
+static void CompileAll(const ShellOptions &options) {
+    std::vector<std::filesystem::path> files;
+    try {
+        files = stronk::FindSources(options.path);
+    } catch (const std::filesystem::filesystem_error &e) {
+        std::cerr << e.what() << "\n";
+        exit(74);
+    }
+
+    stronk::ProgramCache cache(stronk::ProgramCache::DefaultDirectory());
+    stronk::BatchResult result = stronk::CompileAll(files, options.jobs, options.use_cache ? &cache : nullptr);
+
+    auto ms = [](std::chrono::nanoseconds duration) { return duration.count() / 1e6; };
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto &file : result.files_) {
+        std::cout << (file.ok_ ? "ok   " : "FAIL ") << std::setw(9) << ms(file.elapsed_) << " ms "
+                  << std::setw(9) << file.bytes_ << " B " << std::setw(7) << file.instructions_ << " instrs  "
+                  << file.path_.string() << "\n";
+    }
+    double seconds = std::max(ms(result.wall_) / 1000.0, 1e-9);
+    std::cout << result.files_.size() << " files (" << result.Failures() << " failed), "
+              << result.TotalBytes() << " B in " << ms(result.wall_) << " ms on " << result.threads_ << " threads ("
+              << result.steals_ << " steals): " << result.files_.size() / seconds << " files/s, "
+              << result.TotalBytes() / seconds / (1024 * 1024) << " MiB/s\n";
+    if (result.Failures() != 0) {
+        exit(65);
+    }
+}
+
+// Keeps compiled programs warm for clients until a client sends
+// --stop-server.
+static void Serve(const ShellOptions &options) {
+    stronk::ProgramCache cache(stronk::ProgramCache::DefaultDirectory());
+    stronk::CompileServer server(options.socket_path, options.jobs, options.use_cache ? &cache : nullptr);
+    if (!server.Listen()) {
+        std::cerr << "Could not listen on " << options.socket_path << "\n";
+        exit(74);
+    }
+    std::cerr << "Listening on " << options.socket_path << "\n";
+    server.Serve();
+    std::cerr << server.GetStats().ToString();
+}
+
+// Sends the script (or a stats/stop request) to a running server
+// and replays its output.
+static void Connect(const ShellOptions &options) {
+    auto kind = stronk::ServerRequestKind::RUN;
+    std::string source;
+    if (options.server_stats) {
+        kind = stronk::ServerRequestKind::STATS;
+    } else if (options.stop_server) {
+        kind = stronk::ServerRequestKind::SHUTDOWN;
+    } else {
+        std::ifstream istream(options.path);
+        if (!istream.is_open()) {
+            std::cerr << "File does not exist" << "\n";
+            exit(74);
+        }
+        std::stringstream buffer;
+        buffer << istream.rdbuf();
+        source = buffer.str();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    stronk::CompileClient client(options.socket_path);
+    auto reply = client.Send(kind, options.engine, source);
+    auto round_trip = std::chrono::steady_clock::now() - start;
+    if (!reply) {
+        std::cerr << "Could not reach a server on " << options.socket_path << "\n";
+        exit(69);
+    }
+
+    std::cout << reply->output_;
+    if (options.latency) {
+        auto us = [](std::chrono::nanoseconds duration) { return duration.count() / 1e3; };
+        std::cerr << "round trip " << us(round_trip) << " us, server " << us(reply->server_time_) << " us ("
+                  << (reply->cache_hit_ ? "cache hit" : "cache miss") << ")\n";
+    }
+    switch (reply->status_) {
+        case stronk::ServerStatus::OK:
+            break;
+        case stronk::ServerStatus::COMPILE_ERROR:
+            exit(65);
+        case stronk::ServerStatus::RUNTIME_ERROR:
+            exit(70);
+        case stronk::ServerStatus::BAD_REQUEST:
+            exit(64);
+    }
+}
+
+static void Usage() {
+    std::cerr << "Usage: stronk [--no-cache] [--gc-stats] [--profile] [--mem-stats] [--sample=output] [--sample-hz=N]\n"
+              << "              [--trace=tokens,ir,instrs,regs|all] [--trace-file=path] [--disassemble]\n"
+              << "              [--jit | --tiered] [--tier-threshold=N]\n"
+              << "              [--emit-c | --aot=output] [path]\n"
+              << "       stronk [--no-cache] [--jobs=N] --compile-all dir\n"
+              << "       stronk [--no-cache] [--jobs=N] --server[=socket]\n"
+              << "       stronk --connect[=socket] [--latency] [--jit | --tiered] (path | --server-stats | --stop-server)\n";
+    exit(64);
+}
+
+// Value of a numeric flag. Anything but a positive integer that
+// fits in T is a usage error.
+template <typename T>
+static auto ParsePositive(std::string_view text) -> T {
+    T value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size() || value <= 0) {
+        Usage();
+    }
+    return value;
 }
 
 auto main(int argc, const char *argv[]) -> int {
-    if (argc == 1) {
-        Repl();
-    } else if (argc == 2) {
-        RunFile(argv[1]);
+    ShellOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--gc-stats") {
+            options.gc_stats = true;
+        } else if (arg == "--profile") {
+            if (!STRONK_VM_PROFILE) {
+                std::cerr << "--profile needs a build configured with -DSTRONK_VM_PROFILE=ON" << "\n";
+                exit(64);
+            }
+            options.profile = true;
+        } else if (arg == "--mem-stats") {
+            if (!stronk::MemStats::Enabled()) {
+                std::cerr << "--mem-stats needs a build configured with -DSTRONK_MEM_STATS=ON" << "\n";
+                exit(64);
+            }
+            options.mem_stats = true;
+        } else if (arg.rfind("--sample=", 0) == 0) {
+            options.sample_output = arg.substr(9);
+        } else if (arg.rfind("--sample-hz=", 0) == 0) {
+            options.sample_hz = ParsePositive<int>(arg.substr(12));
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            auto categories = stronk::Tracer::ParseCategories(arg.substr(8));
+            if (!categories) {
+                Usage();
+            }
+            options.trace_categories = *categories;
+        } else if (arg.rfind("--trace-file=", 0) == 0) {
+            options.trace_output = arg.substr(13);
+        } else if (arg == "--compile-all") {
+            options.compile_all = true;
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            options.jobs = ParsePositive<size_t>(arg.substr(7));
+        } else if (arg == "--server" || arg.rfind("--server=", 0) == 0) {
+            options.server = true;
+            options.socket_path = arg.size() > 9 ? arg.substr(9) : "";
+        } else if (arg == "--connect" || arg.rfind("--connect=", 0) == 0) {
+            options.connect = true;
+            options.socket_path = arg.size() > 10 ? arg.substr(10) : "";
+        } else if (arg == "--latency") {
+            options.latency = true;
+        } else if (arg == "--server-stats") {
+            options.server_stats = true;
+        } else if (arg == "--stop-server") {
+            options.stop_server = true;
+        } else if (arg == "--no-cache") {
+            options.use_cache = false;
+        } else if (arg == "--jit") {
+            options.engine = stronk::ExecutionEngine::JIT;
+        } else if (arg == "--tiered") {
+            options.engine = stronk::ExecutionEngine::TIERED;
+        } else if (arg.rfind("--tier-threshold=", 0) == 0) {
+            options.tier_up_threshold = ParsePositive<uint32_t>(arg.substr(17));
+        } else if (arg == "--disassemble") {
+            options.disassemble = true;
+        } else if (arg == "--emit-c") {
+            options.emit_c = true;
+        } else if (arg.rfind("--aot=", 0) == 0) {
+            options.aot_output = arg.substr(6);
+        } else if (arg.rfind("--", 0) == 0 || !options.path.empty()) {
+            Usage();
+        } else {
+            options.path = arg;
+        }
+    }
+
+    if (options.socket_path.empty()) {
+        options.socket_path = stronk::CompileServer::DefaultSocket();
+    }
+
+    if (options.server) {
+        if (!options.path.empty() || options.connect) {
+            Usage();
+        }
+        Serve(options);
+    } else if (options.connect) {
+        if (options.path.empty() == !(options.server_stats || options.stop_server)) {
+            Usage();
+        }
+        Connect(options);
+    } else if (options.compile_all) {
+        if (options.path.empty()) {
+            Usage();
+        }
+        CompileAll(options);
+    } else if (options.path.empty()) {
+        if (options.emit_c || !options.aot_output.empty()) {
+            Usage();
+        }
+        Repl(options);
     } else {
-        std::cerr << "Usage: stronk [path]\n";
-        exit(64);
+        RunFile(options);
     }
     return 0;
 }
 
-#undef COMPUTE_PERF
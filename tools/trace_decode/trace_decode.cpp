@@ -0,0 +1,24 @@
+#include <fstream>
+#include <iostream>
+
+#include "common/trace.h"
+
+// Prints a binary trace log written by `stronk --trace=...` as
+// text, one record per line.
+auto main(int argc, const char *argv[]) -> int {
+    if (argc != 2) {
+        std::cerr << "Usage: stronk-trace-decode <trace>\n";
+        return 64;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "File does not exist" << "\n";
+        return 74;
+    }
+    if (!stronk::DecodeTrace(in, std::cout)) {
+        std::cerr << "Malformed trace log" << "\n";
+        return 65;
+    }
+    return 0;
+}